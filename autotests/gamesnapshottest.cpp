@@ -0,0 +1,253 @@
+/*
+    Copyright 2026 The KMines Authors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include <QFile>
+#include <QObject>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <cstring>
+
+#include "counterrandom.h"
+#include "gamesnapshot.h"
+#include "minefield.h"
+#include "replayrecorder.h"
+
+/**
+ * Writes games with GameSnapshot and checks what restore() makes of
+ * the file, whole or broken
+ */
+class GameSnapshotTest : public QObject
+{
+    Q_OBJECT
+private slots:
+    void roundTrip_data();
+    void roundTrip();
+    void truncatedFile();
+    void wrongByteOrder();
+private:
+    /**
+     * Starts a game of given size in field, writes its first move
+     * to snapshot and recorder
+     */
+    static void startGame(MineField* field, GameSnapshot* snapshot, ReplayRecorder* recorder,
+                          int rows, int cols, int mines);
+    /**
+     * Reveals a random safe cell or flags a random mine and
+     * writes the move to snapshot and recorder
+     */
+    static void playMove(MineField* field, GameSnapshot* snapshot, ReplayRecorder* recorder,
+                         CounterRandom* random);
+    /**
+     * Checks that restored shows the same game as field
+     */
+    static void compareFields(const MineField& field, const MineField& restored);
+    /**
+     * @return whether a snapshot in fileName is restored
+     */
+    static bool canRestore(const QString& fileName);
+
+    QTemporaryDir m_dir;
+};
+
+void GameSnapshotTest::startGame(MineField* field, GameSnapshot* snapshot, ReplayRecorder* recorder,
+                                 int rows, int cols, int mines)
+{
+    field->setSeed(11);
+    field->newGame(rows, cols, mines);
+    recorder->start(ReplayRecorder::RandomMines, 11, rows, cols, mines);
+    const int idx = field->cellCount() / 2;
+    recorder->record(ReplayRecorder::Reveal, idx);
+    field->reveal(idx);
+    QVERIFY(snapshot->create(*field, recorder->data()));
+}
+
+void GameSnapshotTest::playMove(MineField* field, GameSnapshot* snapshot, ReplayRecorder* recorder,
+                                CounterRandom* random)
+{
+    int idx;
+    do
+        idx = random->bounded(field->cellCount());
+    while(field->isRevealed(idx) || field->isFlagged(idx));
+    if(field->hasMine(idx))
+    {
+        recorder->record(ReplayRecorder::Mark, idx);
+        field->toggleMark(idx);
+    }
+    else
+    {
+        recorder->record(ReplayRecorder::Reveal, idx);
+        field->reveal(idx);
+    }
+    snapshot->update(*field, field->changedCells(), recorder->data());
+}
+
+void GameSnapshotTest::compareFields(const MineField& field, const MineField& restored)
+{
+    QCOMPARE(restored.rowCount(), field.rowCount());
+    QCOMPARE(restored.columnCount(), field.columnCount());
+    QCOMPARE(restored.minesCount(), field.minesCount());
+    QCOMPARE(restored.seed(), field.seed());
+    QCOMPARE(restored.flaggedCount(), field.flaggedCount());
+    QCOMPARE(restored.unrevealedCount(), field.unrevealedCount());
+    QVERIFY(!restored.isFirstClick());
+    for(int idx=0; idx<field.cellCount(); ++idx)
+    {
+        QCOMPARE(restored.cellState(idx), field.cellState(idx));
+        QCOMPARE(restored.hasMine(idx), field.hasMine(idx));
+        QCOMPARE(restored.digit(idx), field.digit(idx));
+    }
+}
+
+bool GameSnapshotTest::canRestore(const QString& fileName)
+{
+    GameSnapshot snapshot;
+    snapshot.setFileName(fileName);
+    MineField field;
+    QByteArray replay;
+    int seconds;
+    return snapshot.restore(&field, &replay, &seconds);
+}
+
+void GameSnapshotTest::roundTrip_data()
+{
+    QTest::addColumn<int>("rows");
+    QTest::addColumn<int>("cols");
+    QTest::addColumn<int>("mines");
+
+    QTest::newRow("9x9") << 9 << 9 << 10;
+    QTest::newRow("16x30") << 16 << 30 << 99;
+    // rows span several words of a plane
+    QTest::newRow("100x150") << 100 << 150 << 2000;
+}
+
+void GameSnapshotTest::roundTrip()
+{
+    QFETCH(int, rows);
+    QFETCH(int, cols);
+    QFETCH(int, mines);
+
+    QVERIFY(m_dir.isValid());
+    const QString fileName = m_dir.path() + QLatin1String("/round-trip.kms");
+    MineField field;
+    GameSnapshot snapshot;
+    snapshot.setFileName(fileName);
+    snapshot.setLevel("Custom");
+    snapshot.setBotPlayed(false);
+    ReplayRecorder recorder;
+    startGame(&field, &snapshot, &recorder, rows, cols, mines);
+    CounterRandom random(rows);
+    // the game isn't won yet, snapshots of finished games are discarded
+    for(int i=0; i<20 && field.unrevealedCount() > mines + 1; ++i)
+        playMove(&field, &snapshot, &recorder, &random);
+    snapshot.setSeconds(42);
+
+    // a restored snapshot keeps being written
+    MineField restored;
+    GameSnapshot restoredSnapshot;
+    restoredSnapshot.setFileName(fileName);
+    QByteArray replay;
+    int seconds = 0;
+    QVERIFY(restoredSnapshot.restore(&restored, &replay, &seconds));
+    compareFields(field, restored);
+    QCOMPARE(replay, recorder.data());
+    QCOMPARE(seconds, 42);
+    QCOMPARE(restoredSnapshot.level(), QByteArray("Custom"));
+    QVERIFY(!restoredSnapshot.isBotPlayed());
+
+    for(int i=0; i<20 && restored.unrevealedCount() > mines + 1; ++i)
+        playMove(&restored, &restoredSnapshot, &recorder, &random);
+    restoredSnapshot.setSeconds(50);
+    restoredSnapshot.setBotPlayed(true);
+
+    MineField again;
+    GameSnapshot againSnapshot;
+    againSnapshot.setFileName(fileName);
+    QVERIFY(againSnapshot.restore(&again, &replay, &seconds));
+    compareFields(restored, again);
+    QCOMPARE(replay, recorder.data());
+    QCOMPARE(seconds, 50);
+    QCOMPARE(againSnapshot.level(), QByteArray("Custom"));
+    QVERIFY(againSnapshot.isBotPlayed());
+
+    againSnapshot.discard();
+    QVERIFY(!QFile::exists(fileName));
+}
+
+void GameSnapshotTest::truncatedFile()
+{
+    QVERIFY(m_dir.isValid());
+    const QString fileName = m_dir.path() + QLatin1String("/truncated.kms");
+    MineField field;
+    GameSnapshot snapshot;
+    snapshot.setFileName(fileName);
+    ReplayRecorder recorder;
+    startGame(&field, &snapshot, &recorder, 16, 30, 99);
+    snapshot.discard();
+    QVERIFY(!canRestore(fileName));
+
+    startGame(&field, &snapshot, &recorder, 16, 30, 99);
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QByteArray data = file.readAll();
+    file.close();
+    QVERIFY(canRestore(fileName));
+
+    // cut in the header, in the planes and in the log
+    const int planesEnd = GameSnapshot::HEADER_SIZE
+                          + MineField::PLANE_COUNT * field.planeWordCount() * int(sizeof(quint64));
+    const int sizes[] = { 0, GameSnapshot::HEADER_SIZE - 1, GameSnapshot::HEADER_SIZE,
+                          planesEnd - 1, data.size() - 1 };
+    for(int i=0; i<5; ++i)
+    {
+        const int size = sizes[i];
+        QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+        file.write(data.left(size));
+        file.close();
+        QVERIFY2(!canRestore(fileName), qPrintable(QString::number(size)));
+    }
+}
+
+void GameSnapshotTest::wrongByteOrder()
+{
+    QVERIFY(m_dir.isValid());
+    const QString fileName = m_dir.path() + QLatin1String("/byte-order.kms");
+    MineField field;
+    GameSnapshot snapshot;
+    snapshot.setFileName(fileName);
+    ReplayRecorder recorder;
+    startGame(&field, &snapshot, &recorder, 9, 9, 10);
+    QVERIFY(canRestore(fileName));
+
+    // byte order mark follows the magic, a machine of the other
+    // byte order reads it reversed
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    const quint32 mark = 0x01020304;
+    const quint32 swapped = 0x04030201;
+    QByteArray data = file.readAll();
+    QVERIFY(memcmp(data.constData() + 4, &mark, sizeof(mark)) == 0);
+    file.seek(4);
+    file.write(reinterpret_cast<const char*>(&swapped), sizeof(swapped));
+    file.close();
+    QVERIFY(!canRestore(fileName));
+}
+
+QTEST_GUILESS_MAIN(GameSnapshotTest)
+
+#include "gamesnapshottest.moc"
@@ -0,0 +1,261 @@
+/*
+    Copyright 2026 The KMines Authors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include <QObject>
+#include <QTest>
+
+#include "counterrandom.h"
+#include "minefield.h"
+#include "mineprobability.h"
+
+/**
+ * Counts mine positions agreeing with revealed digits cell by cell,
+ * dropping partial positions which can't satisfy some digit anymore
+ */
+struct Enumeration
+{
+    /**
+     * Digits around every unknown cell, by index of constraint
+     */
+    QVector<QVector<int> > constraintsOf;
+    /**
+     * Mines a digit still needs and its cells which aren't assigned yet
+     */
+    QVector<int> need;
+    QVector<int> open;
+    QVector<quint8> isMine;
+    /**
+     * Number of positions putting mine to every cell, and of all positions
+     */
+    QVector<double> hits;
+    double total;
+
+    void run(int pos, int minesLeft)
+    {
+        if(minesLeft < 0 || minesLeft > isMine.size() - pos)
+            return;
+        if(pos == isMine.size())
+        {
+            total++;
+            for(int i=0; i<isMine.size(); ++i)
+                hits[i] += isMine.at(i);
+            return;
+        }
+        for(int mine=0; mine<=1; ++mine)
+        {
+            bool valid = true;
+            foreach(int c, constraintsOf.at(pos))
+            {
+                open[c]--;
+                need[c] -= mine;
+                if(need.at(c) < 0 || need.at(c) > open.at(c))
+                    valid = false;
+            }
+            isMine[pos] = mine;
+            if(valid)
+                run(pos+1, minesLeft - mine);
+            foreach(int c, constraintsOf.at(pos))
+            {
+                open[c]++;
+                need[c] += mine;
+            }
+        }
+        isMine[pos] = 0;
+    }
+};
+
+/**
+ * Checks MineProbability against plain enumeration of all mine
+ * positions which agree with what the player sees
+ */
+class MineProbabilityTest : public QObject
+{
+    Q_OBJECT
+private slots:
+    void matchesEnumeration_data();
+    void matchesEnumeration();
+    void cacheMatchesFreshEngine();
+private:
+    /**
+     * Reveals a random safe cell and sometimes flags a random mine,
+     * the way a player who doesn't make mistakes would
+     */
+    static void playStep(MineField* field, CounterRandom* random);
+    /**
+     * Counts all mine positions agreeing with field and sets
+     * probability of every cell, 0 for revealed cells and 1 for flagged ones
+     */
+    static void enumerate(const MineField& field, QVector<double>* probability);
+};
+
+void MineProbabilityTest::playStep(MineField* field, CounterRandom* random)
+{
+    QVector<int> safe;
+    QVector<int> mines;
+    for(int idx=0; idx<field->cellCount(); ++idx)
+    {
+        if(field->isRevealed(idx) || field->isFlagged(idx))
+            continue;
+        if(field->hasMine(idx))
+            mines.append(idx);
+        else
+            safe.append(idx);
+    }
+    if(!mines.isEmpty() && random->bounded(3) == 0)
+        field->toggleMark(mines.at(random->bounded(mines.size())));
+    if(!safe.isEmpty())
+        field->reveal(safe.at(random->bounded(safe.size())));
+}
+
+void MineProbabilityTest::enumerate(const MineField& field, QVector<double>* probability)
+{
+    const int numCells = field.cellCount();
+    Enumeration enumeration;
+    QVector<int> localOf(numCells, -1);
+    QVector<int> unknown;
+    for(int idx=0; idx<numCells; ++idx)
+    {
+        if(!field.isRevealed(idx) && !field.isFlagged(idx))
+        {
+            localOf[idx] = unknown.size();
+            unknown.append(idx);
+        }
+    }
+    enumeration.constraintsOf.resize(unknown.size());
+
+    // mines every revealed digit still needs among unknown cells
+    int neighbours[MineField::MAX_NEIGHBOURS];
+    for(int idx=0; idx<numCells; ++idx)
+    {
+        if(!field.isRevealed(idx))
+            continue;
+        const int constraint = enumeration.need.size();
+        int need = field.digit(idx);
+        int open = 0;
+        const int count = field.adjasentCellsFor(idx, neighbours);
+        for(int i=0; i<count; ++i)
+        {
+            if(field.isFlagged(neighbours[i]))
+                need--;
+            else if(localOf.at(neighbours[i]) != -1)
+            {
+                enumeration.constraintsOf[localOf.at(neighbours[i])].append(constraint);
+                open++;
+            }
+        }
+        enumeration.need.append(need);
+        enumeration.open.append(open);
+    }
+
+    enumeration.isMine.fill(0, unknown.size());
+    enumeration.hits.fill(0, unknown.size());
+    enumeration.total = 0;
+    enumeration.run(0, field.minesCount() - field.flaggedCount());
+
+    probability->fill(0, numCells);
+    for(int idx=0; idx<numCells; ++idx)
+    {
+        if(field.isFlagged(idx))
+            (*probability)[idx] = 1;
+        else if(localOf.at(idx) != -1)
+            (*probability)[idx] = enumeration.hits.at(localOf.at(idx)) / enumeration.total;
+    }
+}
+
+void MineProbabilityTest::matchesEnumeration_data()
+{
+    QTest::addColumn<int>("rows");
+    QTest::addColumn<int>("cols");
+    QTest::addColumn<int>("mines");
+
+    QTest::newRow("4x4") << 4 << 4 << 3;
+    QTest::newRow("5x5") << 5 << 5 << 5;
+    QTest::newRow("4x7") << 4 << 7 << 6;
+    QTest::newRow("6x6") << 6 << 6 << 7;
+}
+
+void MineProbabilityTest::matchesEnumeration()
+{
+    QFETCH(int, rows);
+    QFETCH(int, cols);
+    QFETCH(int, mines);
+
+    for(quint64 seed=1; seed<=30; ++seed)
+    {
+        MineField field;
+        field.setUseQuestionMarks(false);
+        field.setEstimateGuesses(false);
+        field.setSeed(seed);
+        field.newGame(rows, cols, mines);
+        CounterRandom random(seed, 1);
+        field.reveal(random.bounded(field.cellCount()));
+
+        // one engine for the whole game, so cached components are checked too
+        MineProbability engine(&field);
+        QVector<double> expected;
+        while(!field.isGameOver())
+        {
+            engine.update();
+            enumerate(field, &expected);
+            QVERIFY(engine.isExact());
+            for(int idx=0; idx<field.cellCount(); ++idx)
+            {
+                QVERIFY2(qAbs(engine.probability(idx) - expected.at(idx)) < 1e-9,
+                         qPrintable(QStringLiteral("seed %1, cell %2: %3 instead of %4")
+                                    .arg(seed).arg(idx).arg(engine.probability(idx)).arg(expected.at(idx))));
+            }
+            playStep(&field, &random);
+        }
+    }
+}
+
+void MineProbabilityTest::cacheMatchesFreshEngine()
+{
+    int components = 0;
+    int recomputed = 0;
+    for(quint64 seed=1; seed<=10; ++seed)
+    {
+        MineField field;
+        field.setUseQuestionMarks(false);
+        field.setEstimateGuesses(false);
+        field.setSeed(seed);
+        field.newGame(16, 30, 99);
+        CounterRandom random(seed, 1);
+        field.reveal(random.bounded(field.cellCount()));
+
+        MineProbability cached(&field);
+        while(!field.isGameOver())
+        {
+            cached.update();
+            MineProbability fresh(&field);
+            fresh.update();
+            QCOMPARE(cached.componentCount(), fresh.componentCount());
+            for(int idx=0; idx<field.cellCount(); ++idx)
+                QVERIFY(qAbs(cached.probability(idx) - fresh.probability(idx)) < 1e-9);
+            components += cached.componentCount();
+            recomputed += cached.recomputedCount();
+            playStep(&field, &random);
+        }
+    }
+    // a single reveal mostly changes one component
+    QVERIFY(recomputed < components);
+}
+
+QTEST_GUILESS_MAIN(MineProbabilityTest)
+
+#include "mineprobabilitytest.moc"
@@ -0,0 +1,301 @@
+/*
+    Copyright 2026 The KMines Authors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include <QObject>
+#include <QTest>
+
+#include <climits>
+
+#include "chunkedminefield.h"
+#include "counterrandom.h"
+#include "minefield.h"
+#include "replayplayer.h"
+#include "replayreader.h"
+#include "replayrecorder.h"
+
+/**
+ * Writes logs with ReplayRecorder and checks that ReplayReader and
+ * ReplayPlayer get back what was written
+ */
+class ReplayTest : public QObject
+{
+    Q_OBJECT
+private slots:
+    void header_data();
+    void header();
+    void indexDeltas_data();
+    void indexDeltas();
+    void truncatedTail();
+    void endlessWindow();
+    void playsRecordedGame();
+    void resumeFollowsGameClock();
+};
+
+void ReplayTest::header_data()
+{
+    QTest::addColumn<quint64>("seed");
+    QTest::addColumn<int>("rows");
+    QTest::addColumn<int>("cols");
+    QTest::addColumn<int>("mines");
+
+    QTest::newRow("small") << quint64(1) << 9 << 9 << 10;
+    // first values needing one more varint byte
+    QTest::newRow("varint") << quint64(0x80) << 128 << 16384 << 127;
+    QTest::newRow("largest") << ~quint64(0) << INT_MAX << INT_MAX << INT_MAX;
+}
+
+void ReplayTest::header()
+{
+    QFETCH(quint64, seed);
+    QFETCH(int, rows);
+    QFETCH(int, cols);
+    QFETCH(int, mines);
+
+    ReplayRecorder recorder;
+    recorder.start(ReplayRecorder::NoGuess, seed, rows, cols, mines);
+    ReplayReader reader;
+    QVERIFY(reader.open(recorder.data()));
+    QCOMPARE(reader.mode(), ReplayRecorder::NoGuess);
+    QCOMPARE(reader.seed(), seed);
+    QCOMPARE(reader.rowCount(), rows);
+    QCOMPARE(reader.columnCount(), cols);
+    QCOMPARE(reader.minesCount(), mines);
+
+    ReplayReader::Event event;
+    QVERIFY(!reader.next(&event));
+    QVERIFY(!reader.hasError());
+}
+
+void ReplayTest::indexDeltas_data()
+{
+    QTest::addColumn<QVector<int> >("indices");
+
+    // zigzag turns deltas of -64 and 63 into the largest values of one
+    // varint byte before the action bits are added
+    QTest::newRow("one byte") << (QVector<int>() << 0 << 7 << 8 << 0 << 15);
+    QTest::newRow("zigzag bounds") << (QVector<int>() << 63 << 0 << 64 << 0 << 128 << 64 << 0);
+    QTest::newRow("jumps") << (QVector<int>() << 1000000 << 3 << 1 << 999999 << 0);
+    QTest::newRow("extremes") << (QVector<int>() << INT_MAX << 0 << INT_MAX << INT_MAX - 1 << 1 << INT_MAX);
+}
+
+void ReplayTest::indexDeltas()
+{
+    QFETCH(QVector<int>, indices);
+
+    const ReplayRecorder::Action actions[] = { ReplayRecorder::Press, ReplayRecorder::Reveal,
+                                               ReplayRecorder::Mark, ReplayRecorder::Chord };
+    ReplayRecorder recorder;
+    recorder.start(ReplayRecorder::RandomMines, 1, 10, 10, 10);
+    for(int i=0; i<indices.size(); ++i)
+        recorder.record(actions[i % 4], indices.at(i));
+    QCOMPARE(recorder.eventCount(), indices.size());
+
+    ReplayReader reader;
+    QVERIFY(reader.open(recorder.data()));
+    ReplayReader::Event event;
+    qint64 lastTime = 0;
+    for(int i=0; i<indices.size(); ++i)
+    {
+        QVERIFY(reader.next(&event));
+        QCOMPARE(event.action, actions[i % 4]);
+        QCOMPARE(event.idx, indices.at(i));
+        QVERIFY(event.time >= lastTime);
+        lastTime = event.time;
+    }
+    QVERIFY(!reader.next(&event));
+    QVERIFY(!reader.hasError());
+}
+
+void ReplayTest::truncatedTail()
+{
+    ReplayRecorder recorder;
+    recorder.start(ReplayRecorder::RandomMines, 5, 16, 30, 99);
+    const int headerSize = recorder.data().size();
+    // log size after every event, a cut anywhere else breaks the last event
+    QVector<int> ends;
+    recorder.record(ReplayRecorder::Reveal, 200);
+    ends << recorder.data().size();
+    recorder.record(ReplayRecorder::Mark, 100000);
+    ends << recorder.data().size();
+    recorder.setUseQuestionMarks(true);
+    ends << recorder.data().size();
+    recorder.recordFinish(false, 100000);
+    ends << recorder.data().size();
+
+    const QByteArray data = recorder.data();
+    for(int size=headerSize; size<=data.size(); ++size)
+    {
+        ReplayReader reader;
+        QVERIFY(reader.open(data.left(size)));
+        int count = 0;
+        ReplayReader::Event event;
+        while(reader.next(&event))
+            count++;
+
+        int complete = 0;
+        while(complete < ends.size() && ends.at(complete) <= size)
+            complete++;
+        QCOMPARE(count, complete);
+        QCOMPARE(reader.hasError(), !ends.contains(size) && size != headerSize);
+    }
+
+    // broken header isn't opened at all
+    ReplayReader reader;
+    QVERIFY(!reader.open(data.left(headerSize - 1)));
+    QVERIFY(!reader.open(data.left(ReplayRecorder::FIXED_HEADER_SIZE - 1)));
+
+    ReplayPlayer player(0, 0);
+    QVERIFY(!player.load(data.left(headerSize - 1)));
+}
+
+void ReplayTest::endlessWindow()
+{
+    const double density = 0.15;
+    ReplayRecorder recorder;
+    recorder.start(ReplayRecorder::Endless, 42, 0, 0, qRound(density * ReplayRecorder::DENSITY_SCALE));
+    recorder.recordWindow(0, 0, 20, 30);
+    recorder.record(ReplayRecorder::Reveal, 10*30 + 15);
+    // moving into negative coordinates keeps the index
+    recorder.recordWindow(-5, -1000000, 20, 30);
+    recorder.record(ReplayRecorder::Mark, 0);
+
+    ReplayReader reader;
+    QVERIFY(reader.open(recorder.data()));
+    QCOMPARE(reader.mode(), ReplayRecorder::Endless);
+    QCOMPARE(reader.rowCount(), 0);
+    QCOMPARE(reader.columnCount(), 0);
+    QCOMPARE(reader.density(), double(qRound(density * ReplayRecorder::DENSITY_SCALE)) / ReplayRecorder::DENSITY_SCALE);
+
+    ReplayReader::Event event;
+    QVERIFY(reader.next(&event));
+    QCOMPARE(event.action, ReplayRecorder::Window);
+    QVERIFY(reader.next(&event));
+    QCOMPARE(event.action, ReplayRecorder::Reveal);
+    QCOMPARE(event.idx, 10*30 + 15);
+    QVERIFY(reader.next(&event));
+    QCOMPARE(event.action, ReplayRecorder::Window);
+    QCOMPARE(event.idx, 10*30 + 15);
+    QCOMPARE(event.args[0], qint64(-5));
+    QCOMPARE(event.args[1], qint64(-1000000));
+    QCOMPARE(event.args[2], qint64(20));
+    QCOMPARE(event.args[3], qint64(30));
+    QVERIFY(reader.next(&event));
+    QCOMPARE(event.action, ReplayRecorder::Mark);
+    QCOMPARE(event.idx, 0);
+    QVERIFY(!reader.next(&event));
+    QVERIFY(!reader.hasError());
+
+    ChunkedMineField field;
+    ReplayPlayer player(0, &field);
+    QVERIFY(player.load(recorder.data()));
+    QVERIFY(player.isEndless());
+    player.playToEnd();
+    QVERIFY(!player.hasError());
+    QCOMPARE(field.originRow(), -5);
+    QCOMPARE(field.originCol(), -1000000);
+    QCOMPARE(field.rowCount(), 20);
+    QCOMPARE(field.columnCount(), 30);
+    QCOMPARE(field.flaggedCount(), 1);
+    QVERIFY(!field.isFirstClick());
+}
+
+void ReplayTest::playsRecordedGame()
+{
+    MineField field;
+    field.setSeed(7);
+    field.newGame(16, 16, 40);
+    ReplayRecorder recorder;
+    recorder.start(ReplayRecorder::RandomMines, 7, 16, 16, 40);
+    recorder.setUseQuestionMarks(true);
+
+    // reveal safe cells in random order, flagging some mines on the way
+    CounterRandom random(7);
+    field.reveal(0);
+    recorder.record(ReplayRecorder::Reveal, 0);
+    while(!field.isGameOver())
+    {
+        const int idx = random.bounded(field.cellCount());
+        if(field.isRevealed(idx))
+            continue;
+        const ReplayRecorder::Action action = field.hasMine(idx) ? ReplayRecorder::Mark : ReplayRecorder::Reveal;
+        if(action == ReplayRecorder::Mark && field.isFlagged(idx))
+            continue;
+        if(action == ReplayRecorder::Mark)
+            field.toggleMark(idx);
+        else
+            field.reveal(idx);
+        recorder.record(action, idx);
+    }
+    QVERIFY(field.isWon());
+    recorder.recordFinish(true, 12);
+
+    MineField replayField;
+    ReplayPlayer player(&replayField, 0);
+    QVERIFY(player.load(recorder.data()));
+    player.playToEnd();
+    QVERIFY(!player.hasError());
+    QVERIFY(player.isAtEnd());
+    QVERIFY(player.isWon());
+    QVERIFY(player.hasClaim());
+    QVERIFY(player.claimedWon());
+    QCOMPARE(player.claimedSeconds(), qint64(12));
+    for(int idx=0; idx<field.cellCount(); ++idx)
+    {
+        QCOMPARE(replayField.isRevealed(idx), field.isRevealed(idx));
+        QCOMPARE(replayField.isFlagged(idx), field.isFlagged(idx));
+    }
+}
+
+void ReplayTest::resumeFollowsGameClock()
+{
+    ReplayRecorder recorder;
+    recorder.start(ReplayRecorder::RandomMines, 3, 9, 9, 10);
+    // revealing a flagged cell doesn't start the clock
+    recorder.record(ReplayRecorder::Mark, 0);
+    recorder.record(ReplayRecorder::Reveal, 0);
+    recorder.record(ReplayRecorder::Mark, 0);
+    recorder.record(ReplayRecorder::Reveal, 40);
+    const QByteArray running = recorder.data();
+    recorder.recordPause(true);
+    const QByteArray paused = recorder.data();
+
+    // the player idled after the last event, game clock shows 5 seconds
+    MineField field;
+    ReplayPlayer player(&field, 0);
+    QVERIFY(recorder.resume(running, 5));
+    recorder.recordFinish(false, 5);
+    QVERIFY(player.load(recorder.data()));
+    player.playToEnd();
+    QVERIFY(!player.hasError());
+    QVERIFY(qAbs(player.playTime() - 5000) < 500);
+
+    // paused clock doesn't run, the log already has all of its time
+    QVERIFY(recorder.resume(paused, 0));
+    recorder.recordPause(false);
+    recorder.recordFinish(false, 0);
+    QVERIFY(player.load(recorder.data()));
+    player.playToEnd();
+    QVERIFY(!player.hasError());
+    QVERIFY(player.playTime() < 500);
+
+    QVERIFY(!recorder.resume(running.left(running.size() - 1), 5));
+}
+
+QTEST_GUILESS_MAIN(ReplayTest)
+
+#include "replaytest.moc"
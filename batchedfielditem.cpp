@@ -0,0 +1,150 @@
+/*
+    Copyright 2026 The KMines Authors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#include "batchedfielditem.h"
+
+#include <QStyleOptionGraphicsItem>
+
+BatchedFieldItem::BatchedFieldItem(TileAtlas* atlas, QGraphicsItem* parent)
+    : QGraphicsItem(parent), m_atlas(atlas), m_numRows(0), m_numCols(0), m_cellSize(0),
+      m_dirtyCount(0)
+{
+    // paint() needs the exposed rect
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+}
+
+void BatchedFieldItem::setFieldShape(const BoardShape& shape)
+{
+    prepareGeometryChange();
+    m_numRows = shape.rowCount();
+    m_numCols = shape.columnCount();
+    const int stride = m_numCols+2;
+    m_tiles.fill(NO_TILE, (m_numRows+2)*stride);
+    m_positions.resize(0);
+    if(!shape.isRectangle())
+        m_positions.reserve(shape.cellCount());
+    for(int row=0; row<m_numRows; ++row)
+    {
+        for(int col=0; col<m_numCols; ++col)
+        {
+            if(!shape.contains(row, col))
+                continue;
+            const int position = (row+1)*stride + col+1;
+            m_tiles[position] = TileAtlas::ReleasedTile;
+            if(!shape.isRectangle())
+                m_positions.append(position);
+        }
+    }
+    foreach(const BoardShape::BorderTile& tile, shape.outline())
+        m_tiles[tile.row*stride + tile.col] = TileAtlas::borderTile(tile.element);
+    m_tilesBeforePress.clear();
+    update();
+}
+
+void BatchedFieldItem::setCellSize(int size)
+{
+    prepareGeometryChange();
+    m_cellSize = size;
+    update();
+}
+
+void BatchedFieldItem::setCellState(int idx, KMinesState::CellState state, int digit, bool hasMine, bool exploded)
+{
+    // new state replaces press, as in CellItem
+    m_tilesBeforePress.remove(idx);
+    setTile(idx, TileAtlas::cellTile(state, digit, hasMine, exploded));
+}
+
+void BatchedFieldItem::press(int idx)
+{
+    const int tile = m_tiles.at(positionOf(idx));
+    if(tile == TileAtlas::ReleasedTile || tile == TileAtlas::HintTile)
+    {
+        m_tilesBeforePress.insert(idx, tile);
+        setTile(idx, TileAtlas::PressedTile);
+    }
+}
+
+void BatchedFieldItem::undoPress(int idx)
+{
+    if(isPressed(idx))
+        setTile(idx, m_tilesBeforePress.take(idx));
+}
+
+void BatchedFieldItem::setTile(int idx, int tile)
+{
+    const int position = positionOf(idx);
+    if(m_tiles.at(position) == tile)
+        return;
+    m_tiles[position] = tile;
+
+    // a few separate rects are cheaper to repaint than their bounding
+    // rect, but after a big flood fill tracking them costs more than
+    // painting everything exposed
+    if(m_dirtyCount < MAX_DIRTY_RECTS)
+    {
+        const int row = position / (m_numCols+2);
+        const int col = position % (m_numCols+2);
+        update(col*m_cellSize, row*m_cellSize, m_cellSize, m_cellSize);
+    }
+    else if(m_dirtyCount == MAX_DIRTY_RECTS)
+        update();
+    m_dirtyCount++;
+}
+
+QRectF BatchedFieldItem::boundingRect() const
+{
+    // +2 - because of border on each side
+    return QRectF(0, 0, m_cellSize*(m_numCols+2), m_cellSize*(m_numRows+2));
+}
+
+void BatchedFieldItem::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget)
+{
+    Q_UNUSED(widget);
+    m_dirtyCount = 0;
+    const QPixmap& tiles = m_atlas->pixmap();
+    if(m_cellSize <= 0 || tiles.isNull())
+        return;
+
+    // only cells intersecting the exposed rect are painted
+    const QRectF exposed = option->exposedRect & boundingRect();
+    if(exposed.isEmpty())
+        return;
+    const int firstRow = qMax(0, static_cast<int>(exposed.top() / m_cellSize));
+    const int lastRow = qMin(m_numRows+1, static_cast<int>(exposed.bottom() / m_cellSize));
+    const int firstCol = qMax(0, static_cast<int>(exposed.left() / m_cellSize));
+    const int lastCol = qMin(m_numCols+1, static_cast<int>(exposed.right() / m_cellSize));
+
+    // fragments are positioned by their centers. tiles may still
+    // have the old size, then they are scaled
+    const qreal half = m_cellSize / 2.0;
+    const qreal scale = qreal(m_cellSize) / m_atlas->tileSize();
+    m_fragments.resize(0);
+    for(int row=firstRow; row<=lastRow; ++row)
+    {
+        const quint8* rowTiles = m_tiles.constData() + row*(m_numCols+2);
+        for(int col=firstCol; col<=lastCol; ++col)
+        {
+            if(rowTiles[col] == NO_TILE)
+                continue; // hole
+            const QRectF source = m_atlas->sourceRect(rowTiles[col]);
+            m_fragments.append(QPainter::PixmapFragment::create(
+                QPointF(col*m_cellSize + half, row*m_cellSize + half), source, scale, scale));
+        }
+    }
+    painter->drawPixmapFragments(m_fragments.constData(), m_fragments.size(), tiles);
+}
@@ -0,0 +1,142 @@
+/*
+    Copyright 2026 The KMines Authors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#ifndef BATCHEDFIELDITEM_H
+#define BATCHEDFIELDITEM_H
+
+#include <QGraphicsItem>
+#include <QHash>
+#include <QPainter>
+#include <QVector>
+
+#include "tileatlas.h"
+#include "boardshape.h"
+
+/**
+ * Graphics item painting a whole field with its border.
+ * Used instead of CellItems and BorderItems on big fields: it keeps
+ * a single byte per cell and paint() blits tiles of the TileAtlas for
+ * exposed cells only, in one batch.
+ *
+ * Like CellItem it only shows what MineFieldItem tells it to.
+ * Cells are addressed by index as in MineField.
+ */
+class BatchedFieldItem : public QGraphicsItem
+{
+public:
+    /**
+     * Constructor
+     *
+     * @param atlas tiles to paint with, shared with MineFieldItem
+     */
+    BatchedFieldItem(TileAtlas* atlas, QGraphicsItem* parent);
+    /**
+     * Shows field of given shape with all cells released,
+     * surrounded by its outline
+     */
+    void setFieldShape(const BoardShape& shape);
+    /**
+     * Sets size of cells. Tiles of the atlas are scaled
+     * to it until tiles of this size are ready
+     */
+    void setCellSize(int size);
+    /**
+     * Makes cell at idx show given state,
+     * see CellItem::setCellState()
+     */
+    void setCellState(int idx, KMinesState::CellState state, int digit, bool hasMine, bool exploded);
+    /**
+     * Shows cell at idx as pressed if it is released or shows a hint
+     */
+    void press(int idx);
+    /**
+     * Shows pressed cell at idx as it was before press()
+     */
+    void undoPress(int idx);
+    /**
+     * @return whether cell at idx is shown as pressed
+     */
+    bool isPressed(int idx) const { return m_tiles.at(positionOf(idx)) == TileAtlas::PressedTile; }
+    /**
+     * Reimplemented from QGraphicsItem
+     */
+    QRectF boundingRect() const;
+    /**
+     * Reimplemented from QGraphicsItem
+     */
+    void paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget = 0);
+
+    // enable use of qgraphicsitem_cast
+    enum { Type = UserType + 2 };
+    virtual int type() const { return Type; }
+
+    /**
+     * After this many changed cells between two paints
+     * the whole item is updated at once
+     */
+    static const int MAX_DIRTY_RECTS = 64;
+private:
+    /**
+     * Shows given tile in cell at idx and schedules its repaint
+     */
+    void setTile(int idx, int tile);
+    /**
+     * @return position of cell at idx in m_tiles
+     */
+    int positionOf(int idx) const
+        {
+            if(!m_positions.isEmpty())
+                return m_positions.at(idx);
+            const int row = idx / m_numCols;
+            return (row+1)*(m_numCols+2) + idx - row*m_numCols + 1;
+        }
+
+    /**
+     * Position in m_tiles which shows nothing
+     */
+    static const quint8 NO_TILE = 0xff;
+
+    TileAtlas* m_atlas;
+    /**
+     * Tile shown at every position of the field including border,
+     * row by row, so that cells start at (1,1). Holes of a shaped
+     * field and positions far from cells have NO_TILE
+     */
+    QVector<quint8> m_tiles;
+    /**
+     * Position in m_tiles of every cell of a shaped field,
+     * empty for rectangles
+     */
+    QVector<int> m_positions;
+    /**
+     * Tiles of pressed cells to return to in undoPress()
+     */
+    QHash<int, quint8> m_tilesBeforePress;
+    /**
+     * Reused by paint() to avoid allocations
+     */
+    QVector<QPainter::PixmapFragment> m_fragments;
+    int m_numRows;
+    int m_numCols;
+    int m_cellSize;
+    /**
+     * Number of cells changed since the last paint
+     */
+    int m_dirtyCount;
+};
+
+#endif
@@ -0,0 +1,310 @@
+/*
+    Copyright 2026 The KMines Authors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#include "batchmodes.h"
+
+#include <klocalizedstring.h>
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include "replayverifier.h"
+#include "gamesimulator.h"
+#include "tournament.h"
+#include "botserver.h"
+
+static QCommandLineOption verifyReplaysOption()
+{
+    return QCommandLineOption(QStringLiteral("verify-replays"),
+                              i18n("Check all replays in <dir> without starting the game"),
+                              QStringLiteral("dir"));
+}
+
+/**
+ * Checks all replays in given directory, printing a line for each
+ *
+ * @return exit code, 0 if all of them are valid and 1 if some aren't
+ * or the directory can't be read
+ */
+static int verifyReplays(const QString& dirName)
+{
+    const QDir dir(dirName);
+    if(!dir.exists() || !dir.isReadable())
+    {
+        QTextStream err(stderr);
+        err << "cannot read directory " << dirName << endl;
+        return 1;
+    }
+    QStringList fileNames;
+    foreach(const QString& name, dir.entryList(QStringList() << QStringLiteral("*.kmr"), QDir::Files, QDir::Name))
+        fileNames << dir.filePath(name);
+
+    QElapsedTimer timer;
+    timer.start();
+    const QVector<ReplayVerifier::Result> results = ReplayVerifier::verifyFiles(fileNames);
+    const qint64 elapsed = timer.elapsed();
+
+    QTextStream out(stdout);
+    int valid = 0;
+    foreach(const ReplayVerifier::Result& result, results)
+    {
+        out << result.fileName << ": " << ReplayVerifier::statusName(result.status);
+        if(result.status != ReplayVerifier::Unreadable && result.status != ReplayVerifier::Corrupt)
+            out << (result.won ? " won" : " lost") << " in " << result.playTime / 1000.0
+                << " s, claimed " << result.claimedSeconds << " s";
+        out << endl;
+        if(result.status == ReplayVerifier::Valid)
+            valid++;
+    }
+    out << valid << "/" << results.size() << " replays valid, checked in " << elapsed << " ms" << endl;
+    return valid == results.size() ? 0 : 1;
+}
+
+static QList<QCommandLineOption> simulateOptions()
+{
+    return QList<QCommandLineOption>()
+        << QCommandLineOption(QStringLiteral("simulate"),
+                              i18n("Let the solver play <games> games without starting the game"),
+                              QStringLiteral("games"))
+        << QCommandLineOption(QStringLiteral("rows"), i18n("Number of rows of simulated games"),
+                              QStringLiteral("rows"), QStringLiteral("16"))
+        << QCommandLineOption(QStringLiteral("columns"), i18n("Number of columns of simulated games"),
+                              QStringLiteral("columns"), QStringLiteral("30"))
+        << QCommandLineOption(QStringLiteral("mines"), i18n("Number of mines of simulated games"),
+                              QStringLiteral("mines"), QStringLiteral("99"))
+        << QCommandLineOption(QStringLiteral("seed"), i18n("Seed of the first simulated game"),
+                              QStringLiteral("seed"), QStringLiteral("1"))
+        << QCommandLineOption(QStringLiteral("no-guess"), i18n("Simulate fields which need no guessing"))
+        << QCommandLineOption(QStringLiteral("format"), i18n("Format of simulation results: csv or json"),
+                              QStringLiteral("format"), QStringLiteral("csv"))
+        << QCommandLineOption(QStringLiteral("strategy"), i18n("Strategy of the simulated player"),
+                              QStringLiteral("name"), QLatin1String(GameSimulator::STRATEGIES[0].name))
+        << QCommandLineOption(QStringLiteral("tournament"),
+                              i18n("Let strategies play <games> games each on the same fields"),
+                              QStringLiteral("games"))
+        << QCommandLineOption(QStringLiteral("strategies"),
+                              i18n("Comma separated strategies playing the tournament, all by default"),
+                              QStringLiteral("names"));
+}
+
+/**
+ * Reads settings of simulated games from options of simulateOptions()
+ *
+ * @param countOption option giving the number of games
+ * @return false if some of them are invalid
+ */
+static bool readSimulationSettings(const QCommandLineParser& parser, const QString& countOption,
+                                   GameSimulator::Settings* settings)
+{
+    bool countOk, rowsOk, colsOk, minesOk, seedOk;
+    settings->count = parser.value(countOption).toInt(&countOk);
+    settings->rows = parser.value(QStringLiteral("rows")).toInt(&rowsOk);
+    settings->cols = parser.value(QStringLiteral("columns")).toInt(&colsOk);
+    settings->mines = parser.value(QStringLiteral("mines")).toInt(&minesOk);
+    settings->firstSeed = parser.value(QStringLiteral("seed")).toULongLong(&seedOk);
+    settings->mode = parser.isSet(QStringLiteral("no-guess")) ? MineField::NoGuess : MineField::RandomMines;
+    settings->strategy = GameSimulator::findStrategy(parser.value(QStringLiteral("strategy")));
+    // sides are checked before they are multiplied
+    return countOk && settings->count >= 1 && rowsOk && colsOk && minesOk && seedOk && settings->firstSeed != 0
+        && settings->rows >= 1 && settings->cols >= 1 && settings->mines >= 1
+        && settings->rows <= GameSimulator::MAX_FIELD_SIDE && settings->cols <= GameSimulator::MAX_FIELD_SIDE
+        && settings->mines <= settings->rows*settings->cols - MineField::MINIMAL_FREE
+        && settings->strategy != -1;
+}
+
+/**
+ * Plays games as set by simulateOptions(), printing a line
+ * for each game as soon as it's over
+ *
+ * @return exit code
+ */
+static int simulate(const QCommandLineParser& parser)
+{
+    QTextStream err(stderr);
+    GameSimulator::Settings settings;
+    const QString format = parser.value(QStringLiteral("format"));
+    const bool json = format == QLatin1String("json");
+    if(!readSimulationSettings(parser, QStringLiteral("simulate"), &settings)
+       || (!json && format != QLatin1String("csv")))
+    {
+        err << "invalid simulation parameters" << endl;
+        return 1;
+    }
+
+    QTextStream out(stdout);
+    if(!json)
+        out << "seed,won,clicks,guesses,3bv,time_us" << endl;
+    QElapsedTimer timer;
+    timer.start();
+    GameSimulator simulator(settings);
+    simulator.start();
+    QVector<GameSimulator::Result> results;
+    int won = 0;
+    qint64 guesses = 0;
+    while(simulator.takeResults(&results))
+    {
+        foreach(const GameSimulator::Result& result, results)
+        {
+            if(json)
+                out << "{\"seed\":" << result.seed << ",\"won\":" << (result.won ? "true" : "false")
+                    << ",\"clicks\":" << result.clicks << ",\"guesses\":" << result.guesses
+                    << ",\"3bv\":" << result.boardValue << ",\"time_us\":" << result.micros << "}\n";
+            else
+                out << result.seed << ',' << int(result.won) << ',' << result.clicks << ','
+                    << result.guesses << ',' << result.boardValue << ',' << result.micros << '\n';
+            if(result.won)
+                won++;
+            guesses += result.guesses;
+        }
+        out.flush();
+    }
+    const qint64 elapsed = qMax(qint64(1), timer.elapsed());
+    err << settings.count << " games, " << won * 100.0 / settings.count << " % won, "
+        << double(guesses) / settings.count << " guesses per game, "
+        << settings.count * 1000.0 / elapsed << " games/s" << endl;
+    return 0;
+}
+
+/**
+ * Lets strategies play the same games, printing a table of results
+ *
+ * @return exit code
+ */
+static int playTournament(const QCommandLineParser& parser)
+{
+    QTextStream err(stderr);
+    GameSimulator::Settings settings;
+    if(!readSimulationSettings(parser, QStringLiteral("tournament"), &settings))
+    {
+        err << "invalid tournament parameters" << endl;
+        return 1;
+    }
+    Tournament tournament(settings);
+    if(parser.isSet(QStringLiteral("strategies")))
+    {
+        foreach(const QString& name, parser.value(QStringLiteral("strategies")).split(QLatin1Char(',')))
+        {
+            const int strategy = GameSimulator::findStrategy(name.trimmed());
+            if(strategy == -1)
+            {
+                err << "unknown strategy " << name << endl;
+                return 1;
+            }
+            tournament.addStrategy(strategy);
+        }
+    }
+    else
+    {
+        for(int strategy=0; strategy<GameSimulator::STRATEGY_COUNT; ++strategy)
+            tournament.addStrategy(strategy);
+    }
+
+    QTextStream out(stdout);
+    out << settings.count << " games of " << settings.cols << "x" << settings.rows << " with "
+        << settings.mines << " mines, seeds from " << settings.firstSeed << endl;
+    out << "strategy      won       95% interval  guesses  decision us  games/s   vs first" << endl;
+    const QVector<Tournament::Standing> standings = tournament.run();
+    foreach(const Tournament::Standing& standing, standings)
+    {
+        out << QString::fromLatin1(GameSimulator::STRATEGIES[standing.strategy].name).leftJustified(10)
+            << QStringLiteral("%1%").arg(100.0 * standing.won / standing.games, 6, 'f', 2)
+            << QStringLiteral("  %1% - %2%").arg(100 * standing.winRateLow, 6, 'f', 2)
+                                            .arg(100 * standing.winRateHigh, 6, 'f', 2)
+            << QStringLiteral("%1").arg(standing.meanGuesses, 9, 'f', 3)
+            << QStringLiteral("%1").arg(standing.meanDecisionMicros, 13, 'f', 2)
+            << QStringLiteral("%1").arg(standing.gamesPerSecond, 9, 'f', 0)
+            << QStringLiteral("   +%1 -%2").arg(standing.onlyThisWon).arg(standing.onlyFirstWon) << endl;
+    }
+    return 0;
+}
+
+static QList<QCommandLineOption> botOptions()
+{
+    return QList<QCommandLineOption>()
+        << QCommandLineOption(QStringLiteral("bot-socket"),
+                              i18n("Let a bot play over local socket <name>"),
+                              QStringLiteral("name"))
+        << QCommandLineOption(QStringLiteral("headless"),
+                              i18n("Serve the bot without showing the game, "
+                                   "the first game is set by --rows, --columns and --mines"));
+}
+
+/**
+ * Serves bots on a field without any GUI until killed
+ *
+ * @return exit code
+ */
+static int serveBots(QCoreApplication& app, const QCommandLineParser& parser)
+{
+    QTextStream err(stderr);
+    const int rows = parser.value(QStringLiteral("rows")).toInt();
+    const int cols = parser.value(QStringLiteral("columns")).toInt();
+    const int mines = parser.value(QStringLiteral("mines")).toInt();
+    if(!parser.isSet(QStringLiteral("bot-socket")) || rows < 1 || cols < 1
+       || rows > BotServer::MAX_FIELD_SIDE || cols > BotServer::MAX_FIELD_SIDE
+       || mines < 1 || mines > rows*cols - MineField::MINIMAL_FREE)
+    {
+        err << "invalid bot server parameters" << endl;
+        return 1;
+    }
+
+    BotServer::FieldGame game;
+    game.botNewGame(rows, cols, mines, 0);
+    BotServer server(&game);
+    if(!server.listen(parser.value(QStringLiteral("bot-socket"))))
+    {
+        err << server.errorString() << endl;
+        return 1;
+    }
+    return app.exec();
+}
+
+bool BatchModes::isRequested(int argc, char** argv)
+{
+    for(int i=1; i<argc; ++i)
+    {
+        const QByteArray arg(argv[i]);
+        if(arg.startsWith("--verify-replays") || arg.startsWith("--simulate")
+           || arg.startsWith("--tournament") || arg == "--headless")
+            return true;
+    }
+    return false;
+}
+
+void BatchModes::addOptions(QCommandLineParser* parser)
+{
+    parser->addOption(verifyReplaysOption());
+    foreach(const QCommandLineOption& option, simulateOptions() + botOptions())
+        parser->addOption(option);
+}
+
+int BatchModes::run(int& argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+    QCommandLineParser parser;
+    addOptions(&parser);
+    parser.process(app);
+    if(parser.isSet(QStringLiteral("verify-replays")))
+        return verifyReplays(parser.value(QStringLiteral("verify-replays")));
+    if(parser.isSet(QStringLiteral("headless")))
+        return serveBots(app, parser);
+    if(parser.isSet(QStringLiteral("tournament")))
+        return playTournament(parser);
+    return simulate(parser);
+}
@@ -0,0 +1,46 @@
+/*
+    Copyright 2026 The KMines Authors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#ifndef BATCHMODES_H
+#define BATCHMODES_H
+
+class QCommandLineParser;
+
+/**
+ * Modes of kmines which run without a display and exit when done:
+ * --verify-replays, --simulate, --tournament and --headless bot server
+ */
+namespace BatchModes
+{
+    /**
+     * @return whether arguments ask for one of the batch modes
+     */
+    bool isRequested(int argc, char** argv);
+    /**
+     * Adds options of all batch modes to parser, the GUI lists them
+     * in --help and serves bots with --bot-socket
+     */
+    void addOptions(QCommandLineParser* parser);
+    /**
+     * Runs the batch mode asked for by arguments
+     *
+     * @return exit code
+     */
+    int run(int& argc, char** argv);
+}
+
+#endif
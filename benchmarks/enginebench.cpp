@@ -0,0 +1,321 @@
+/*
+    Copyright 2026 The KMines Authors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+// Micro-benchmarks of MineField operations.
+// Prints the average cost of a single operation for every board size.
+
+#include <QElapsedTimer>
+
+#include <cstdio>
+
+#include "bitplanes.h"
+#include "minefield.h"
+#include "mineprobability.h"
+
+struct BoardSize
+{
+    const char* name;
+    int rows;
+    int cols;
+    int mines;
+};
+
+static const BoardSize s_boardSizes[] = {
+    { "Easy", 9, 9, 10 },
+    { "Medium", 16, 16, 40 },
+    { "Hard", 16, 30, 99 },
+    { "500x500", 500, 500, 51563 } // same density as Hard
+};
+
+/**
+ * Starts new game and opens the field in its center
+ */
+static void openField(MineField& field, const BoardSize& size)
+{
+    field.newGame(size.rows, size.cols, size.mines);
+    field.reveal(field.indexOf(size.rows/2, size.cols/2));
+}
+
+/**
+ * Repeats openField() enough times to get stable numbers
+ * @return average time of new game + first reveal in ns
+ */
+static double benchOpen(const BoardSize& size)
+{
+    MineField field;
+    const int repeats = qMax(10, 2000000 / (size.rows*size.cols));
+    QElapsedTimer timer;
+    timer.start();
+    for(int i=0; i<repeats; ++i)
+        openField(field, size);
+    return double(timer.nsecsElapsed()) / repeats;
+}
+
+/**
+ * Flags all mines, then chords every revealed digit
+ * @return average time of a single chord in ns
+ */
+static double benchChord(const BoardSize& size)
+{
+    MineField field;
+    const int repeats = qMax(10, 2000000 / (size.rows*size.cols));
+    qint64 elapsed = 0;
+    qint64 chords = 0;
+    QElapsedTimer timer;
+    for(int i=0; i<repeats; ++i)
+    {
+        openField(field, size);
+        for(int idx=0; idx<field.cellCount(); ++idx)
+        {
+            if(field.hasMine(idx))
+                field.toggleMark(idx);
+        }
+
+        timer.start();
+        for(int idx=0; idx<field.cellCount() && !field.isGameOver(); ++idx)
+        {
+            if(field.isRevealed(idx) && field.digit(idx) != 0)
+            {
+                field.chord(idx);
+                chords++;
+            }
+        }
+        elapsed += timer.nsecsElapsed();
+    }
+    return chords ? double(elapsed) / chords : 0;
+}
+
+/**
+ * Reveals free cells one by one, as a perfect player would.
+ * Stops after MAX_REVEALS cells to keep huge boards in reasonable time
+ * @return average time of a single reveal in ns
+ */
+static double benchReveal(const BoardSize& size)
+{
+    const int MAX_REVEALS = 1000;
+    MineField field;
+    const int repeats = qMax(10, 2000000 / (size.rows*size.cols));
+    qint64 elapsed = 0;
+    qint64 reveals = 0;
+    QElapsedTimer timer;
+    for(int i=0; i<repeats; ++i)
+    {
+        openField(field, size);
+        int count = 0;
+        timer.start();
+        for(int idx=0; idx<field.cellCount() && count<MAX_REVEALS && !field.isGameOver(); ++idx)
+        {
+            if(!field.hasMine(idx) && field.reveal(idx))
+                count++;
+        }
+        reveals += count;
+        elapsed += timer.nsecsElapsed();
+    }
+    return reveals ? double(elapsed) / reveals : 0;
+}
+
+/**
+ * Generates fields which can be solved without guessing
+ * @return number of generated fields per second
+ */
+static double benchNoGuess(const BoardSize& size)
+{
+    MineField field;
+    field.setGenerationMode(MineField::NoGuess);
+    const int repeats = qMax(10, 200000 / (size.rows*size.cols));
+    QElapsedTimer timer;
+    timer.start();
+    for(int i=0; i<repeats; ++i)
+        openField(field, size);
+    return repeats * 1e9 / timer.nsecsElapsed();
+}
+
+/**
+ * Plays like a careful player: reveals safe cells next to the already
+ * revealed area and refreshes mine probabilities after every reveal,
+ * as the hint overlay does
+ * @return average time of a single probability update in us
+ */
+static double benchProbability(const BoardSize& size)
+{
+    const int MAX_REVEALS = 1000;
+    MineField field;
+    MineProbability probabilities(&field);
+    openField(field, size);
+    probabilities.update();
+
+    int neighbours[MineField::MAX_NEIGHBOURS];
+    qint64 elapsed = 0;
+    int updates = 0;
+    QElapsedTimer timer;
+    for(int idx=0; idx<field.cellCount() && updates<MAX_REVEALS && !field.isGameOver(); ++idx)
+    {
+        if(field.hasMine(idx) || field.isRevealed(idx))
+            continue;
+        bool onFrontier = false;
+        const int count = field.adjasentCellsFor(idx, neighbours);
+        for(int i=0; i<count; ++i)
+            onFrontier = onFrontier || field.isRevealed(neighbours[i]);
+        if(!onFrontier)
+            continue;
+
+        field.reveal(idx);
+        timer.start();
+        probabilities.update();
+        elapsed += timer.nsecsElapsed();
+        updates++;
+        // start over, revealed area has grown
+        idx = -1;
+    }
+    return updates ? elapsed / 1000.0 / updates : 0;
+}
+
+/**
+ * Replays a scripted game on a size x size field with the density of
+ * Hard: safe cells are revealed in a fixed pseudo-random order and after
+ * every seventh reveal a mine is flagged. The script is prepared on
+ * a copy of the field before timing, keeping only clicks which change
+ * something, so only the engine is measured. If every click costs
+ * O(changed cells), time per changed cell stays flat as the field grows
+ * @return average time of a single click and per changed cell in ns
+ */
+static void benchReplay(int size, double* perClick, double* perCell)
+{
+    const int MAX_CLICKS = 2000;
+    MineField field;
+    field.setSeed(size);
+    field.newGame(size, size, size*size*99/480);
+    field.reveal(field.indexOf(size/2, size/2));
+
+    QVector<int> safeCells;
+    QVector<int> mineCells;
+    for(int idx=0; idx<field.cellCount(); ++idx)
+        (field.hasMine(idx) ? mineCells : safeCells).append(idx);
+    quint64 state = size;
+    for(int i=safeCells.size()-1; i>0; --i)
+    {
+        state = state*6364136223846793005ULL + 1442695040888963407ULL;
+        qSwap(safeCells[i], safeCells[int((state >> 33) % (i+1))]);
+    }
+
+    // negative actions flag mine at -1-action
+    MineField trial(field);
+    QVector<int> script;
+    int flagged = 0;
+    for(int i=0; i<safeCells.size() && script.size()<MAX_CLICKS; ++i)
+    {
+        if(!trial.reveal(safeCells.at(i)) || trial.isGameOver())
+            continue;
+        script.append(safeCells.at(i));
+        if(script.size() % 8 == 7 && flagged < mineCells.size())
+        {
+            trial.toggleMark(mineCells.at(flagged));
+            script.append(-1 - mineCells.at(flagged++));
+        }
+    }
+
+    qint64 changed = 0;
+    QElapsedTimer timer;
+    timer.start();
+    foreach(int action, script)
+    {
+        if(action < 0)
+            field.toggleMark(-1 - action);
+        else
+            field.reveal(action);
+        changed += field.changedCells().size();
+    }
+    const double elapsed = timer.nsecsElapsed();
+    *perClick = elapsed / script.size();
+    *perCell = elapsed / changed;
+}
+
+/**
+ * Counts neighbours of random mines on a rows x cols plane laid out
+ * like MineField does
+ * @return time of a single pass in ms and its memory traffic in GB/s
+ */
+static void benchCountPass(int rows, int cols, double* ms, double* bandwidth)
+{
+    const int repeats = 10;
+    const int rowWords = (cols+2 + 63) / 64;
+    const int planeWords = (rows+2)*rowWords + 2;
+    QVector<quint64> mines(planeWords, 0);
+    QVector<quint64> digitPlanes[BitPlanes::DIGIT_PLANES];
+    for(int k=0; k<BitPlanes::DIGIT_PLANES; ++k)
+        digitPlanes[k].fill(0, planeWords);
+    quint64* const digits[BitPlanes::DIGIT_PLANES] = { digitPlanes[0].data(), digitPlanes[1].data(),
+                                                       digitPlanes[2].data(), digitPlanes[3].data() };
+
+    // random bits are enough, the pass doesn't depend on density
+    quint64 state = 1;
+    for(int word=1+rowWords; word<1+(rows+1)*rowWords; ++word)
+    {
+        state = state*6364136223846793005ULL + 1442695040888963407ULL;
+        mines[word] = state ^ (state >> 29);
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    for(int i=0; i<repeats; ++i)
+        BitPlanes::countNeighbours(mines.constData(), digits, 1 + rowWords, rows*rowWords, rowWords);
+    const double seconds = timer.nsecsElapsed() / 1e9 / repeats;
+
+    // mines are read once, every digit plane is written once
+    const double bytes = double(rows)*rowWords*sizeof(quint64)*(1 + BitPlanes::DIGIT_PLANES);
+    *ms = seconds * 1e3;
+    *bandwidth = bytes / seconds / 1e9;
+}
+
+int main()
+{
+    printf("%-10s %16s %12s %12s\n", "board", "open (ns)", "chord (ns)", "reveal (ns)");
+    for(const BoardSize& size : s_boardSizes)
+    {
+        printf("%-10s %16.0f %12.1f %12.1f\n", size.name,
+               benchOpen(size), benchChord(size), benchReveal(size));
+    }
+
+    printf("\n%-10s %16s\n", "board", "no-guess/s");
+    for(const BoardSize& size : s_boardSizes)
+    {
+        // enumeration makes huge fields impractical
+        if(size.rows*size.cols > 10000)
+            continue;
+        printf("%-10s %16.1f\n", size.name, benchNoGuess(size));
+    }
+
+    printf("\n%-10s %16s\n", "board", "probability (us)");
+    for(const BoardSize& size : s_boardSizes)
+        printf("%-10s %16.1f\n", size.name, benchProbability(size));
+
+    printf("\n%-10s %16s %12s\n", "board", "replay (ns)", "per cell");
+    const int replaySizes[] = { 125, 250, 500, 1000 };
+    for(int size : replaySizes)
+    {
+        double perClick, perCell;
+        benchReplay(size, &perClick, &perCell);
+        printf("%4dx%-5d %16.1f %12.1f\n", size, size, perClick, perCell);
+    }
+
+    double ms, bandwidth;
+    benchCountPass(10000, 10000, &ms, &bandwidth);
+    printf("\n%-10s %16s %12s   (%s)\n", "board", "count (ms)", "GB/s", BitPlanes::instructionSet());
+    printf("%-10s %16.1f %12.1f\n", "10000^2", ms, bandwidth);
+    return 0;
+}
@@ -0,0 +1,248 @@
+/*
+    Copyright 2026 The KMines Authors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+// Simple bot for testing BotServer. Connects to a running
+// "kmines --bot-socket NAME" (with or without --headless), plays games
+// with trivial logic and reports how long the server takes to answer.
+//
+// Usage: kmines_stubbot NAME [GAMES [ROWS COLUMNS MINES]]
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QLocalSocket>
+#include <QVector>
+
+#include <cstdio>
+#include <cstdlib>
+
+#include "botserver.h"
+
+/**
+ * What the bot knows about the board
+ */
+struct Board
+{
+    int rows;
+    int cols;
+    int mines;
+    /**
+     * BotServer::Cell or digit of every cell
+     */
+    QVector<quint8> cells;
+    BotServer::Status status;
+};
+
+static void appendNumber(QByteArray* data, quint64 value, int size)
+{
+    for(int i=0; i<size; ++i)
+        data->append(static_cast<char>(value >> (8*i)));
+}
+
+static quint64 readNumber(const QByteArray& data, int pos, int size)
+{
+    quint64 value = 0;
+    for(int i=0; i<size; ++i)
+        value |= quint64(quint8(data.at(pos+i))) << (8*i);
+    return value;
+}
+
+/**
+ * Reads exactly size bytes, exits if the server went away
+ */
+static QByteArray readBytes(QLocalSocket* socket, int size)
+{
+    while(socket->bytesAvailable() < size)
+    {
+        if(!socket->waitForReadyRead(10000))
+        {
+            fprintf(stderr, "server doesn't answer\n");
+            exit(1);
+        }
+    }
+    return socket->read(size);
+}
+
+/**
+ * Reads a single message into board
+ * @return type of the message
+ */
+static char readMessage(QLocalSocket* socket, Board* board)
+{
+    const char type = readBytes(socket, 1).at(0);
+    if(type == BotServer::BoardMessage)
+    {
+        const QByteArray data = readBytes(socket, 8);
+        board->rows = readNumber(data, 0, 2);
+        board->cols = readNumber(data, 2, 2);
+        board->mines = readNumber(data, 4, 4);
+        board->cells.fill(BotServer::Hidden, board->rows*board->cols);
+        board->status = BotServer::Playing;
+    }
+    else if(type == BotServer::UpdateMessage)
+    {
+        const QByteArray header = readBytes(socket, 5);
+        board->status = static_cast<BotServer::Status>(header.at(0));
+        const int count = readNumber(header, 1, 4);
+        const QByteArray data = readBytes(socket, count*5);
+        for(int i=0; i<count; ++i)
+            board->cells[readNumber(data, i*5, 4)] = data.at(i*5 + 4);
+    }
+    else
+    {
+        fprintf(stderr, "unknown message %d\n", type);
+        exit(1);
+    }
+    return type;
+}
+
+/**
+ * Sends command and reads messages until the reply comes
+ */
+static void send(QLocalSocket* socket, const QByteArray& command, Board* board)
+{
+    socket->write(command);
+    socket->flush();
+    const char reply = command.at(0) == BotServer::NewGame ? BotServer::BoardMessage : BotServer::UpdateMessage;
+    while(readMessage(socket, board) != reply)
+        ;
+}
+
+static QByteArray move(BotServer::Command command, int idx)
+{
+    QByteArray data;
+    data.append(static_cast<char>(command));
+    appendNumber(&data, idx, 4);
+    return data;
+}
+
+/**
+ * Chords digits with all mines flagged, flags cells around digits
+ * which need all of them, otherwise guesses
+ */
+static QByteArray chooseMove(const Board& board, quint64* random)
+{
+    int hidden[8];
+    for(int row=0; row<board.rows; ++row)
+    {
+        for(int col=0; col<board.cols; ++col)
+        {
+            const int digit = board.cells.at(row*board.cols + col);
+            if(digit > 8)
+                continue;
+            int numHidden = 0, numFlags = 0;
+            for(int r=qMax(0, row-1); r<=qMin(board.rows-1, row+1); ++r)
+            {
+                for(int c=qMax(0, col-1); c<=qMin(board.cols-1, col+1); ++c)
+                {
+                    const int cell = board.cells.at(r*board.cols + c);
+                    if(cell == BotServer::Hidden)
+                        hidden[numHidden++] = r*board.cols + c;
+                    else if(cell == BotServer::Flagged)
+                        numFlags++;
+                }
+            }
+            if(numHidden == 0)
+                continue;
+            if(numFlags == digit)
+                return digit == 0 ? move(BotServer::Reveal, hidden[0])
+                                  : move(BotServer::Chord, row*board.cols + col);
+            if(numFlags + numHidden == digit)
+                return move(BotServer::Mark, hidden[0]);
+        }
+    }
+
+    QVector<int> candidates;
+    for(int idx=0; idx<board.cells.size(); ++idx)
+    {
+        if(board.cells.at(idx) == BotServer::Hidden)
+            candidates.append(idx);
+    }
+    *random = *random * 6364136223846793005ULL + 1442695040888963407ULL;
+    return move(BotServer::Reveal, candidates.at(int((*random >> 33) % candidates.size())));
+}
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+    if(argc < 2)
+    {
+        fprintf(stderr, "usage: %s NAME [GAMES [ROWS COLUMNS MINES]]\n", argv[0]);
+        return 1;
+    }
+    const int games = argc > 2 ? atoi(argv[2]) : 1000;
+    const int rows = argc > 5 ? atoi(argv[3]) : 16;
+    const int cols = argc > 5 ? atoi(argv[4]) : 30;
+    const int mines = argc > 5 ? atoi(argv[5]) : 99;
+
+    QLocalSocket socket;
+    socket.connectToServer(QString::fromLocal8Bit(argv[1]));
+    if(!socket.waitForConnected(10000))
+    {
+        fprintf(stderr, "can't connect: %s\n", qPrintable(socket.errorString()));
+        return 1;
+    }
+    Board board;
+    // the server describes the current game first
+    readMessage(&socket, &board);
+
+    quint64 random = 1;
+    int won = 0;
+    qint64 commands = 0;
+    qint64 roundTrip = 0;
+    qint64 maxRoundTrip = 0;
+    QElapsedTimer total;
+    total.start();
+    QElapsedTimer timer;
+    for(int game=0; game<games; ++game)
+    {
+        QByteArray command;
+        command.append(static_cast<char>(BotServer::NewGame));
+        appendNumber(&command, rows, 2);
+        appendNumber(&command, cols, 2);
+        appendNumber(&command, mines, 4);
+        appendNumber(&command, game + 1, 8);
+        send(&socket, command, &board);
+        if(board.rows*board.cols == 0)
+        {
+            fprintf(stderr, "server has no game to play\n");
+            return 1;
+        }
+
+        command = move(BotServer::Reveal, (board.rows/2)*board.cols + board.cols/2);
+        while(true)
+        {
+            timer.start();
+            send(&socket, command, &board);
+            const qint64 elapsed = timer.nsecsElapsed();
+            roundTrip += elapsed;
+            maxRoundTrip = qMax(maxRoundTrip, elapsed);
+            commands++;
+            if(board.status != BotServer::Playing)
+                break;
+            command = chooseMove(board, &random);
+        }
+        if(board.status == BotServer::Won)
+            won++;
+    }
+
+    const double seconds = total.nsecsElapsed() / 1e9;
+    printf("%d games, %d won, %.1f games/s\n", games, won, games / seconds);
+    printf("%lld moves, round trip %.1f us on average, %.1f us at most\n", commands,
+           commands ? roundTrip / 1000.0 / commands : 0.0, maxRoundTrip / 1000.0);
+    return 0;
+}
@@ -0,0 +1,157 @@
+/*
+    Copyright 2026 The KMines Authors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#include "bitplanes.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+
+/**
+ * Plain 64-bit words, used for tails and when no SIMD is available
+ */
+struct ScalarOps
+{
+    typedef quint64 Word;
+    static const int WIDTH = 1;
+    static Word load(const quint64* p) { return *p; }
+    static void store(quint64* p, Word v) { *p = v; }
+    static Word andOf(Word a, Word b) { return a & b; }
+    static Word orOf(Word a, Word b) { return a | b; }
+    static Word xorOf(Word a, Word b) { return a ^ b; }
+    static Word andNot(Word a, Word b) { return ~a & b; }
+    template<int N> static Word shiftLeft(Word v) { return v << N; }
+    template<int N> static Word shiftRight(Word v) { return v >> N; }
+};
+
+#if defined(__AVX2__)
+struct SimdOps
+{
+    typedef __m256i Word;
+    static const int WIDTH = 4;
+    static Word load(const quint64* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+    static void store(quint64* p, Word v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+    static Word andOf(Word a, Word b) { return _mm256_and_si256(a, b); }
+    static Word orOf(Word a, Word b) { return _mm256_or_si256(a, b); }
+    static Word xorOf(Word a, Word b) { return _mm256_xor_si256(a, b); }
+    static Word andNot(Word a, Word b) { return _mm256_andnot_si256(a, b); }
+    template<int N> static Word shiftLeft(Word v) { return _mm256_slli_epi64(v, N); }
+    template<int N> static Word shiftRight(Word v) { return _mm256_srli_epi64(v, N); }
+};
+#elif defined(__SSE2__)
+struct SimdOps
+{
+    typedef __m128i Word;
+    static const int WIDTH = 2;
+    static Word load(const quint64* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+    static void store(quint64* p, Word v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+    static Word andOf(Word a, Word b) { return _mm_and_si128(a, b); }
+    static Word orOf(Word a, Word b) { return _mm_or_si128(a, b); }
+    static Word xorOf(Word a, Word b) { return _mm_xor_si128(a, b); }
+    static Word andNot(Word a, Word b) { return _mm_andnot_si128(a, b); }
+    template<int N> static Word shiftLeft(Word v) { return _mm_slli_epi64(v, N); }
+    template<int N> static Word shiftRight(Word v) { return _mm_srli_epi64(v, N); }
+};
+#endif
+
+/**
+ * Adds three one-bit planes, giving sum and carry
+ */
+template<class Ops>
+inline void fullAdd(typename Ops::Word a, typename Ops::Word b, typename Ops::Word c,
+                    typename Ops::Word* sum, typename Ops::Word* carry)
+{
+    const typename Ops::Word ab = Ops::xorOf(a, b);
+    *sum = Ops::xorOf(ab, c);
+    *carry = Ops::orOf(Ops::andOf(a, b), Ops::andOf(ab, c));
+}
+
+/**
+ * Counts neighbours of Ops::WIDTH words starting at mines[i]
+ */
+template<class Ops>
+inline void countWords(const quint64* mines, quint64* const digits[BitPlanes::DIGIT_PLANES],
+                       int i, int rowWords)
+{
+    typedef typename Ops::Word Word;
+    Word inputs[8];
+    int n = 0;
+    for(int row=-1; row<=1; ++row)
+    {
+        const quint64* p = mines + i + row*rowWords;
+        const Word center = Ops::load(p);
+        // a cell's left neighbour is the bit below it,
+        // the lowest bit comes from the previous word
+        inputs[n++] = Ops::orOf(Ops::template shiftLeft<1>(center),
+                                Ops::template shiftRight<63>(Ops::load(p-1)));
+        inputs[n++] = Ops::orOf(Ops::template shiftRight<1>(center),
+                                Ops::template shiftLeft<63>(Ops::load(p+1)));
+        if(row != 0)
+            inputs[n++] = center;
+    }
+
+    // bit-sliced sum of 8 one-bit inputs
+    Word s1, c1, s2, c2, ones, c4, twos, c5;
+    fullAdd<Ops>(inputs[0], inputs[1], inputs[2], &s1, &c1);
+    fullAdd<Ops>(inputs[3], inputs[4], inputs[5], &s2, &c2);
+    const Word s3 = Ops::xorOf(inputs[6], inputs[7]);
+    const Word c3 = Ops::andOf(inputs[6], inputs[7]);
+    fullAdd<Ops>(s1, s2, s3, &ones, &c4);
+    fullAdd<Ops>(c1, c2, c3, &twos, &c5);
+    const Word c6 = Ops::andOf(twos, c4);
+    twos = Ops::xorOf(twos, c4);
+    const Word fours = Ops::xorOf(c5, c6);
+    const Word eights = Ops::andOf(c5, c6);
+
+    // cells holding mine have no digit
+    const Word mine = Ops::load(mines + i);
+    Ops::store(digits[0] + i, Ops::andNot(mine, ones));
+    Ops::store(digits[1] + i, Ops::andNot(mine, twos));
+    Ops::store(digits[2] + i, Ops::andNot(mine, fours));
+    Ops::store(digits[3] + i, Ops::andNot(mine, eights));
+}
+
+}
+
+void BitPlanes::countNeighbours(const quint64* mines, quint64* const digits[DIGIT_PLANES],
+                                int first, int count, int rowWords)
+{
+    const int end = first + count;
+    int i = first;
+#if defined(__AVX2__) || defined(__SSE2__)
+    for(; i + SimdOps::WIDTH <= end; i += SimdOps::WIDTH)
+        countWords<SimdOps>(mines, digits, i, rowWords);
+#endif
+    for(; i < end; ++i)
+        countWords<ScalarOps>(mines, digits, i, rowWords);
+}
+
+const char* BitPlanes::instructionSet()
+{
+#if defined(__AVX2__)
+    return "AVX2";
+#elif defined(__SSE2__)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
@@ -0,0 +1,89 @@
+/*
+    Copyright 2026 The KMines Authors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#ifndef BITPLANES_H
+#define BITPLANES_H
+
+#include <QtGlobal>
+
+/**
+ * Helpers for fields stored as bit-planes: one bit per cell, rows of
+ * 64-bit words following each other. Bit b of word w in a row is the
+ * cell at column w*64+b.
+ */
+namespace BitPlanes
+{
+    /**
+     * Number of digit planes, enough for digits up to 15
+     */
+    const int DIGIT_PLANES = 4;
+
+    /**
+     * Counts set neighbours of every bit in words [first, first+count)
+     * of mines, where rows are rowWords long. Result is stored bit-sliced:
+     * bit k of the count goes to digits[k]. Bits set in mines get 0.
+     *
+     * mines is read from first-rowWords-1 to first+count+rowWords, so rows
+     * above and below and one word on each side must exist. Bits on the
+     * edges of rows are counted together with the next or previous row,
+     * so the caller must keep an empty column between rows.
+     *
+     * Uses AVX2 or SSE2 if the build enables them.
+     */
+    void countNeighbours(const quint64* mines, quint64* const digits[DIGIT_PLANES],
+                         int first, int count, int rowWords);
+
+    /**
+     * @return name of instruction set used by countNeighbours()
+     */
+    const char* instructionSet();
+
+    /**
+     * @return number of the lowest set bit, word must not be 0
+     */
+    inline int lowestBit(quint64 word)
+    {
+#if defined(__GNUC__)
+        return __builtin_ctzll(word);
+#else
+        int bit = 0;
+        while(!(word & 1))
+        {
+            word >>= 1;
+            bit++;
+        }
+        return bit;
+#endif
+    }
+
+    /**
+     * @return number of set bits in word
+     */
+    inline int bitCount(quint64 word)
+    {
+#if defined(__GNUC__)
+        return __builtin_popcountll(word);
+#else
+        int count = 0;
+        for(; word; word &= word - 1)
+            count++;
+        return count;
+#endif
+    }
+}
+
+#endif
@@ -0,0 +1,318 @@
+/*
+    Copyright 2026 The KMines Authors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#include "boardgenerator.h"
+
+#include <QRunnable>
+#include <QThread>
+#include "counterrandom.h"
+#include "minefield.h"
+#include "minesolver.h"
+
+class BoardGenerator::Worker : public QRunnable
+{
+public:
+    Worker(BoardGenerator* generator, int worker)
+        : m_generator(generator), m_worker(worker) {}
+    void run() { m_generator->work(m_worker); }
+private:
+    BoardGenerator* m_generator;
+    int m_worker;
+};
+
+BoardGenerator::BoardGenerator(QObject* parent)
+    : QObject(parent), m_rows(0), m_cols(0), m_mines(0), m_generation(0),
+      m_failedAttempts(0), m_prefetching(false), m_running(false), m_stopping(false),
+      m_requestField(0), m_requestStart(-1), m_requestId(0), m_nextAttempt(0),
+      m_solvedAttempt(-1), m_triedBelow(0), m_requestDone(false)
+{
+    m_baseSeed = CounterRandom::randomSeed();
+}
+
+BoardGenerator::~BoardGenerator()
+{
+    stop();
+}
+
+void BoardGenerator::setParameters(int rows, int cols, int mines)
+{
+    QMutexLocker locker(&m_mutex);
+    if(m_running && rows == m_rows && cols == m_cols && mines == m_mines)
+        return;
+
+    m_rows = rows;
+    m_cols = cols;
+    m_mines = mines;
+    m_generation++;
+    m_failedAttempts = 0;
+    m_queue.clear();
+    m_prefetching = true;
+
+    startWorkers();
+    m_wakeWorkers.wakeAll();
+}
+
+void BoardGenerator::startWorkers()
+{
+    if(m_running)
+        return;
+    m_running = true;
+    m_stopping = false;
+    const int numWorkers = qMax(1, QThread::idealThreadCount());
+    m_pool.setMaxThreadCount(numWorkers);
+    for(int i=0; i<numWorkers; ++i)
+        m_pool.start(new Worker(this, i));
+}
+
+void BoardGenerator::stop()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if(!m_running)
+            return;
+        m_stopping = true;
+        m_queue.clear();
+        m_wakeWorkers.wakeAll();
+    }
+    m_pool.waitForDone();
+
+    QMutexLocker locker(&m_mutex);
+    m_running = false;
+    m_stopping = false;
+    m_prefetching = false;
+    delete m_requestField;
+    m_requestField = 0;
+    m_requestDone = false;
+}
+
+void BoardGenerator::requestBoard(const MineField& field, int startIdx)
+{
+    QMutexLocker locker(&m_mutex);
+    delete m_requestField;
+    m_requestField = new MineField(field);
+    m_requestStart = startIdx;
+    m_requestId++;
+    m_nextAttempt = 0;
+    m_solvedAttempt = -1;
+    m_triedBelow = 0;
+    m_tried.fill(0, MineField::MAX_NO_GUESS_ATTEMPTS);
+    m_requestDone = false;
+
+    startWorkers();
+    m_wakeWorkers.wakeAll();
+}
+
+void BoardGenerator::cancelRequest()
+{
+    QMutexLocker locker(&m_mutex);
+    delete m_requestField;
+    m_requestField = 0;
+    m_requestDone = false;
+}
+
+bool BoardGenerator::takeRequestedBoard(Board* board)
+{
+    QMutexLocker locker(&m_mutex);
+    if(!m_requestField || !m_requestDone)
+        return false;
+    *board = m_requestResult;
+    delete m_requestField;
+    m_requestField = 0;
+    m_requestDone = false;
+    return true;
+}
+
+bool BoardGenerator::hasRequestWork() const
+{
+    if(!m_requestField || m_requestDone)
+        return false;
+    // boards after a solvable one can't win anymore
+    const int end = m_solvedAttempt == -1 ? MineField::MAX_NO_GUESS_ATTEMPTS : m_solvedAttempt;
+    return m_nextAttempt < end;
+}
+
+void BoardGenerator::finishAttempt(int attempt, bool solvable, const Board& board)
+{
+    if(solvable && (m_solvedAttempt == -1 || attempt < m_solvedAttempt))
+    {
+        m_solvedAttempt = attempt;
+        m_requestResult = board;
+    }
+    else if(m_solvedAttempt == -1 && attempt == MineField::MAX_NO_GUESS_ATTEMPTS-1)
+    {
+        // like MineField does, the last board is played
+        // if none of them is solvable
+        m_requestResult = board;
+    }
+
+    m_tried[attempt] = 1;
+    while(m_triedBelow < m_tried.size() && m_tried.at(m_triedBelow))
+        m_triedBelow++;
+    // a solvable board only wins once all the boards before it are tried
+    if((m_solvedAttempt != -1 && m_triedBelow >= m_solvedAttempt)
+       || m_triedBelow == MineField::MAX_NO_GUESS_ATTEMPTS)
+    {
+        m_requestDone = true;
+        emit requestReady();
+    }
+}
+
+bool BoardGenerator::takeBoard(Board* board)
+{
+    QMutexLocker locker(&m_mutex);
+    if(m_queue.isEmpty())
+        return false;
+    *board = m_queue.dequeue();
+    m_wakeWorkers.wakeAll();
+    return true;
+}
+
+int BoardGenerator::queuedCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_queue.size();
+}
+
+void BoardGenerator::work(int worker)
+{
+    // every worker reuses its own field and solver
+    MineField field;
+    MineSolver solver(&field);
+    Board board;
+    quint64 candidate = 0;
+    int generation = -1;
+
+    QMutexLocker locker(&m_mutex);
+    forever
+    {
+        while(!m_stopping && !hasRequestWork() && (!m_prefetching || m_queue.size() >= PREFETCH_COUNT))
+            m_wakeWorkers.wait(&m_mutex);
+        if(m_stopping)
+            return;
+
+        // the player waits for a requested field, so it goes first
+        if(hasRequestWork())
+        {
+            const int requestId = m_requestId;
+            const int startIdx = m_requestStart;
+            const int attempt = m_nextAttempt++;
+            field = *m_requestField;
+
+            locker.unlock();
+            const bool solvable = tryAttempt(startIdx, attempt, &board, &field, &solver);
+            locker.relock();
+
+            if(requestId == m_requestId && m_requestField)
+                finishAttempt(attempt, solvable, board);
+            continue;
+        }
+
+        if(generation != m_generation)
+        {
+            // start a new sequence of seeds for new parameters
+            generation = m_generation;
+            candidate = 0;
+        }
+        const int rows = m_rows;
+        const int cols = m_cols;
+        const int mines = m_mines;
+        const quint64 seed = candidateSeed(m_baseSeed + generation, worker, candidate++);
+
+        locker.unlock();
+        const bool solvable = generateBoard(rows, cols, mines, seed, &board, &field, &solver);
+        locker.relock();
+
+        if(generation != m_generation)
+            continue; // parameters changed meanwhile
+        if(!solvable && ++m_failedAttempts < MineField::MAX_NO_GUESS_ATTEMPTS)
+            continue;
+
+        // like MineField does, give up after too many attempts
+        // and hand out a field which needs guessing
+        m_failedAttempts = 0;
+        if(m_queue.size() < PREFETCH_COUNT)
+        {
+            m_queue.enqueue(board);
+            emit boardReady();
+        }
+    }
+}
+
+quint64 BoardGenerator::candidateSeed(quint64 baseSeed, int worker, quint64 n)
+{
+    // every worker has its own stream, so workers never
+    // need to agree on which seeds were taken
+    const quint64 seed = CounterRandom(baseSeed, worker).at(n);
+    // 0 would mean a random seed for MineField
+    return seed ? seed : 1;
+}
+
+bool BoardGenerator::generateBoard(int rows, int cols, int mines, quint64 seed, Board* board)
+{
+    MineField field;
+    MineSolver solver(&field);
+    return generateBoard(rows, cols, mines, seed, board, &field, &solver);
+}
+
+bool BoardGenerator::generateBoard(int rows, int cols, int mines, quint64 seed, Board* board,
+                                   MineField* field, MineSolver* solver)
+{
+    // start cell is chosen by the same seed, from a stream
+    // which placing mines doesn't use
+    CounterRandom startRandom(seed, START_STREAM);
+    const int startIdx = startRandom.bounded(rows*cols);
+
+    field->setGenerationMode(MineField::RandomMines);
+    field->setSeed(seed);
+    field->setFirstAttempt(0);
+    // the solver below tells whether guessing is needed
+    field->setEstimateGuesses(false);
+    field->newGame(rows, cols, mines);
+    field->reveal(startIdx);
+    fillBoard(startIdx, field, solver, board);
+    return board->noGuess;
+}
+
+bool BoardGenerator::tryAttempt(int startIdx, int attempt, Board* board,
+                                MineField* field, MineSolver* solver)
+{
+    // the copy keeps the seed of the game, only the
+    // board of that seed is chosen here
+    field->setGenerationMode(MineField::RandomMines);
+    field->setFirstAttempt(attempt);
+    field->setEstimateGuesses(false);
+    field->reveal(startIdx);
+    fillBoard(startIdx, field, solver, board);
+    return board->noGuess;
+}
+
+void BoardGenerator::fillBoard(int startIdx, MineField* field, MineSolver* solver, Board* board)
+{
+    solver->reset();
+    board->rows = field->rowCount();
+    board->cols = field->columnCount();
+    board->mines = field->minesCount();
+    board->startIdx = startIdx;
+    board->seed = field->seed();
+    board->noGuess = solver->solve();
+    board->mineCells.resize(0);
+    for(int idx=0; idx<field->cellCount(); ++idx)
+    {
+        if(field->hasMine(idx))
+            board->mineCells.append(idx);
+    }
+}
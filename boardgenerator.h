@@ -0,0 +1,256 @@
+/*
+    Copyright 2026 The KMines Authors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#ifndef BOARDGENERATOR_H
+#define BOARDGENERATOR_H
+
+#include <QObject>
+#include <QVector>
+#include <QQueue>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QThreadPool>
+
+class MineField;
+class MineSolver;
+
+/**
+ * Generates fields which can be solved without guessing in background
+ * threads and keeps a few of them ready, so that starting a new game
+ * never waits for the solver.
+ *
+ * Every field is prepared for its own start cell. Each candidate field
+ * is generated from a seed derived from the base seed, the worker number
+ * and the number of candidates the worker has tried, so any produced
+ * field can be reproduced with generateBoard().
+ *
+ * Workers take candidates one by one and go on as long as the queue
+ * isn't full, so faster workers simply end up doing more of them.
+ *
+ * If the player starts somewhere else, requestBoard() makes all workers
+ * look for the field of that first click instead. They try boards of the
+ * game's own seed in parallel and the lowest solvable one wins, so the
+ * result is the same field MineField would generate in NoGuess mode.
+ */
+class BoardGenerator : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * Field prepared by the generator
+     */
+    struct Board
+    {
+        int rows;
+        int cols;
+        int mines;
+        /**
+         * Cell which has to be revealed first
+         */
+        int startIdx;
+        /**
+         * Seed the field was generated from
+         */
+        quint64 seed;
+        /**
+         * False if no solvable field was found in
+         * MineField::MAX_NO_GUESS_ATTEMPTS candidates
+         */
+        bool noGuess;
+        /**
+         * Indexes of cells holding mines
+         */
+        QVector<int> mineCells;
+    };
+
+    /**
+     * Constructor. Doesn't start any threads until setParameters() is called
+     */
+    explicit BoardGenerator(QObject* parent = 0);
+    /**
+     * Stops all workers and waits for them
+     */
+    ~BoardGenerator();
+    /**
+     * Sets size of fields to generate and starts workers.
+     * Queued fields of other size are dropped
+     */
+    void setParameters(int rows, int cols, int mines);
+    /**
+     * Stops all workers, drops queued fields and the current request
+     */
+    void stop();
+    /**
+     * Starts looking for the field which field would get in NoGuess mode
+     * if startIdx is revealed first. Workers leave prefetching until it
+     * is found. Any earlier request is dropped. requestReady() is emitted
+     * when the field is known
+     *
+     * @param field new game, its size, shape and seed are used
+     * @param startIdx cell revealed first
+     */
+    void requestBoard(const MineField& field, int startIdx);
+    /**
+     * Drops the current request
+     */
+    void cancelRequest();
+    /**
+     * Takes the field asked for by requestBoard()
+     *
+     * @return false if it isn't known yet
+     */
+    bool takeRequestedBoard(Board* board);
+    /**
+     * Sets seed from which seeds of candidate fields are derived.
+     * Takes effect on the next setParameters() call
+     */
+    void setBaseSeed(quint64 seed) { m_baseSeed = seed; }
+    /**
+     * Takes a prepared field out of the queue
+     *
+     * @return false if no field is ready yet
+     */
+    bool takeBoard(Board* board);
+    /**
+     * @return number of fields ready in the queue
+     */
+    int queuedCount() const;
+    /**
+     * Generates a single candidate field, exactly as the workers do
+     *
+     * @return whether it can be solved without guessing
+     */
+    static bool generateBoard(int rows, int cols, int mines, quint64 seed, Board* board);
+    /**
+     * Seed of the n-th candidate of given worker
+     */
+    static quint64 candidateSeed(quint64 baseSeed, int worker, quint64 n);
+
+    /**
+     * Number of fields kept ready
+     */
+    static const int PREFETCH_COUNT = 4;
+    /**
+     * Stream of the seed used to choose the start cell,
+     * MineField uses the first ones to place mines
+     */
+    static const quint64 START_STREAM = ~quint64(0);
+signals:
+    /**
+     * Emitted from a worker thread when a field was added to the queue
+     */
+    void boardReady();
+    /**
+     * Emitted from a worker thread when the field asked
+     * for by requestBoard() is known
+     */
+    void requestReady();
+private:
+    class Worker;
+    /**
+     * Starts worker threads unless they run already. Called with m_mutex held
+     */
+    void startWorkers();
+    /**
+     * @return whether some board of the current request is left to try.
+     * Called with m_mutex held
+     */
+    bool hasRequestWork() const;
+    /**
+     * Takes result of a tried board of the current request.
+     * Called with m_mutex held
+     */
+    void finishAttempt(int attempt, bool solvable, const Board& board);
+    /**
+     * Loop of a single worker thread
+     */
+    void work(int worker);
+    /**
+     * generateBoard() reusing field and solver of the worker
+     */
+    static bool generateBoard(int rows, int cols, int mines, quint64 seed, Board* board,
+                              MineField* field, MineSolver* solver);
+    /**
+     * Places given board of the seed of field, which is a copy of the
+     * requested game, and checks whether it can be solved from startIdx
+     */
+    static bool tryAttempt(int startIdx, int attempt, Board* board,
+                           MineField* field, MineSolver* solver);
+    /**
+     * Fills board with the field played by solver
+     */
+    static void fillBoard(int startIdx, MineField* field, MineSolver* solver, Board* board);
+
+    QThreadPool m_pool;
+    mutable QMutex m_mutex;
+    /**
+     * Wakes workers when there's space in the queue or they have to stop
+     */
+    QWaitCondition m_wakeWorkers;
+    QQueue<Board> m_queue;
+    int m_rows;
+    int m_cols;
+    int m_mines;
+    /**
+     * Increased whenever parameters change, so that workers can
+     * drop fields of the old size
+     */
+    int m_generation;
+    /**
+     * Candidates tried since the last field was queued
+     */
+    int m_failedAttempts;
+    quint64 m_baseSeed;
+    /**
+     * Whether fields for setParameters() are prepared
+     */
+    bool m_prefetching;
+    bool m_running;
+    bool m_stopping;
+
+    /**
+     * New game given to requestBoard(), 0 if there's no request
+     */
+    MineField* m_requestField;
+    int m_requestStart;
+    /**
+     * Increased with every request, so that workers can
+     * drop results of an old one
+     */
+    int m_requestId;
+    /**
+     * Next board of the seed to try
+     */
+    int m_nextAttempt;
+    /**
+     * Lowest solvable board found so far, -1 if none
+     */
+    int m_solvedAttempt;
+    /**
+     * Boards below this one are all tried
+     */
+    int m_triedBelow;
+    QVector<quint8> m_tried;
+    /**
+     * Field of m_solvedAttempt, or of the last board
+     * if none of the ones tried is solvable
+     */
+    Board m_requestResult;
+    bool m_requestDone;
+};
+
+#endif
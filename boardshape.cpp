@@ -0,0 +1,149 @@
+/*
+    Copyright 2026 The KMines Authors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#include "boardshape.h"
+
+#include <QList>
+
+BoardShape::BoardShape(int numRows, int numCols)
+    : m_numRows(numRows), m_numCols(numCols), m_numCells(0),
+      m_bits((numRows*numCols + 63) / 64, 0)
+{
+}
+
+BoardShape BoardShape::rectangle(int numRows, int numCols)
+{
+    BoardShape shape(numRows, numCols);
+    shape.m_bits.fill(~quint64(0));
+    // bits after the last position stay clear
+    const int tail = (numRows*numCols) & 63;
+    if(tail)
+        shape.m_bits.last() = (quint64(1) << tail) - 1;
+    shape.m_numCells = numRows*numCols;
+    return shape;
+}
+
+void BoardShape::setCell(int row, int col, bool cell)
+{
+    if(contains(row, col) == cell)
+        return;
+    const int bit = row*m_numCols + col;
+    m_bits[bit >> 6] ^= quint64(1) << (bit & 63);
+    m_numCells += cell ? 1 : -1;
+}
+
+void BoardShape::trim()
+{
+    int firstRow = m_numRows, lastRow = -1;
+    int firstCol = m_numCols, lastCol = -1;
+    for(int row=0; row<m_numRows; ++row)
+    {
+        for(int col=0; col<m_numCols; ++col)
+        {
+            if(!contains(row, col))
+                continue;
+            firstRow = qMin(firstRow, row);
+            lastRow = row;
+            firstCol = qMin(firstCol, col);
+            lastCol = qMax(lastCol, col);
+        }
+    }
+    if(lastRow == -1)
+    {
+        *this = BoardShape();
+        return;
+    }
+    if(firstRow == 0 && lastRow == m_numRows-1 && firstCol == 0 && lastCol == m_numCols-1)
+        return;
+
+    BoardShape trimmed(lastRow - firstRow + 1, lastCol - firstCol + 1);
+    for(int row=0; row<trimmed.m_numRows; ++row)
+        for(int col=0; col<trimmed.m_numCols; ++col)
+            trimmed.setCell(row, col, contains(firstRow + row, firstCol + col));
+    *this = trimmed;
+}
+
+QVector<BoardShape::BorderTile> BoardShape::outline() const
+{
+    // (row,col) is a position of the widened rectangle,
+    // the cell there is (row-1,col-1)
+    QVector<BorderTile> tiles;
+    for(int row=0; row<m_numRows+2; ++row)
+    {
+        for(int col=0; col<m_numCols+2; ++col)
+        {
+            if(contains(row-1, col-1))
+                continue;
+            BorderTile tile = { row, col, KMinesState::BorderNorth };
+            // edges face cells next to them, the cell below wins
+            // in holes which have cells on more sides
+            if(contains(row, col-1))
+                tile.element = KMinesState::BorderNorth;
+            else if(contains(row-2, col-1))
+                tile.element = KMinesState::BorderSouth;
+            else if(contains(row-1, col))
+                tile.element = KMinesState::BorderWest;
+            else if(contains(row-1, col-2))
+                tile.element = KMinesState::BorderEast;
+            else if(contains(row, col))
+                tile.element = KMinesState::BorderCornerNW;
+            else if(contains(row, col-2))
+                tile.element = KMinesState::BorderCornerNE;
+            else if(contains(row-2, col))
+                tile.element = KMinesState::BorderCornerSW;
+            else if(contains(row-2, col-2))
+                tile.element = KMinesState::BorderCornerSE;
+            else
+                continue; // far from any cell
+            tiles.append(tile);
+        }
+    }
+    return tiles;
+}
+
+bool BoardShape::loadText(const QByteArray& data)
+{
+    QList<QByteArray> lines;
+    int numCols = 0;
+    foreach(QByteArray line, data.split('\n'))
+    {
+        if(line.startsWith('!'))
+            continue;
+        // trailing spaces and line ends of any platform are holes anyway
+        while(!line.isEmpty() && (line.endsWith(' ') || line.endsWith('\r') || line.endsWith('\t')))
+            line.chop(1);
+        lines.append(line);
+        numCols = qMax(numCols, line.size());
+    }
+    // the bounding rectangle is checked before anything is allocated,
+    // so huge input can't take a lot of memory
+    if(lines.size() > MAX_SIDE || numCols > MAX_SIDE)
+        return false;
+
+    BoardShape shape(lines.size(), numCols);
+    for(int row=0; row<lines.size(); ++row)
+    {
+        const QByteArray& line = lines.at(row);
+        for(int col=0; col<line.size(); ++col)
+            shape.setCell(row, col, line.at(col) != '.' && line.at(col) != ' ' && line.at(col) != '\t');
+    }
+    shape.trim();
+    if(shape.cellCount() == 0)
+        return false;
+    *this = shape;
+    return true;
+}
@@ -0,0 +1,127 @@
+/*
+    Copyright 2026 The KMines Authors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#ifndef BOARDSHAPE_H
+#define BOARDSHAPE_H
+
+#include <QVector>
+#include <QByteArray>
+
+#include "commondefs.h"
+
+/**
+ * Shape of a bounded field: which positions of its bounding rectangle
+ * are cells and which are holes. Kept as a packed bitmask, one bit per
+ * position in row-major order, so a shape costs an eighth of a byte per
+ * position however many holes it has.
+ *
+ * MineField numbers only the cells of a shape, in row-major order, so
+ * holes take no memory or time in the game itself.
+ *
+ * Shapes are loaded from plain text, see loadText(). Any picture can be
+ * turned into a shape with setCell(), which is how the GUI loads images.
+ */
+class BoardShape
+{
+public:
+    /**
+     * Piece of the border drawn around a shape, see outline()
+     */
+    struct BorderTile
+    {
+        /**
+         * Position in the bounding rectangle widened by one on each side,
+         * so that cell (0,0) is at row 1, column 1
+         */
+        int row;
+        int col;
+        KMinesState::BorderElement element;
+    };
+
+    /**
+     * Constructor. Creates shape of given size without any cells
+     */
+    explicit BoardShape(int numRows = 0, int numCols = 0);
+    /**
+     * @return shape where every position is a cell
+     */
+    static BoardShape rectangle(int numRows, int numCols);
+    /**
+     * @return number of rows of the bounding rectangle
+     */
+    int rowCount() const { return m_numRows; }
+    /**
+     * @return number of columns of the bounding rectangle
+     */
+    int columnCount() const { return m_numCols; }
+    /**
+     * @return number of cells
+     */
+    int cellCount() const { return m_numCells; }
+    /**
+     * @return whether there are no holes
+     */
+    bool isRectangle() const { return m_numCells == m_numRows*m_numCols; }
+    /**
+     * @return whether (row,col) is a cell, false for positions
+     * outside of the bounding rectangle
+     */
+    bool contains(int row, int col) const
+        {
+            if(row < 0 || row >= m_numRows || col < 0 || col >= m_numCols)
+                return false;
+            const int bit = row*m_numCols + col;
+            return m_bits.at(bit >> 6) & (quint64(1) << (bit & 63));
+        }
+    /**
+     * Makes (row,col) a cell or a hole
+     */
+    void setCell(int row, int col, bool cell);
+    /**
+     * Removes rows and columns without cells from the edges
+     */
+    void trim();
+    /**
+     * @return border around the cells: every hole or position around the
+     * bounding rectangle which touches a cell, in row-major order. A hole
+     * next to a cell gets the edge facing it, one which only touches a cell
+     * diagonally gets a corner. Border of a rectangle is its usual frame
+     */
+    QVector<BorderTile> outline() const;
+    /**
+     * Reads shape from text, where every line is a row. '.' and spaces
+     * are holes, any other character is a cell and lines starting with
+     * '!' are comments. Shorter lines end with holes, and empty rows and
+     * columns around the cells are removed
+     *
+     * @return false if data has no cells or is bigger than MAX_SIDE,
+     * then the shape is left as it was
+     */
+    bool loadText(const QByteArray& data);
+
+    /**
+     * Maximal number of rows or columns of a shape
+     */
+    static const int MAX_SIDE = 2000;
+private:
+    int m_numRows;
+    int m_numCols;
+    int m_numCells;
+    QVector<quint64> m_bits;
+};
+
+#endif
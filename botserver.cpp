@@ -0,0 +1,303 @@
+/*
+    Copyright 2026 The KMines Authors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#include "botserver.h"
+
+#include <QLocalServer>
+#include <QLocalSocket>
+
+/**
+ * Appends size lowest bytes of value, lowest first
+ */
+static inline void appendNumber(QByteArray* data, quint64 value, int size)
+{
+    for(int i=0; i<size; ++i)
+        data->append(static_cast<char>(value >> (8*i)));
+}
+
+/**
+ * @return number of size bytes at data, lowest first
+ */
+static inline quint64 readNumber(const char* data, int size)
+{
+    quint64 value = 0;
+    for(int i=0; i<size; ++i)
+        value |= quint64(quint8(data[i])) << (8*i);
+    return value;
+}
+
+BotServer::FieldGame::FieldGame()
+{
+    m_field.setUseQuestionMarks(false);
+}
+
+bool BotServer::FieldGame::botMove(Command command, int idx)
+{
+    switch(command)
+    {
+        case Reveal:
+            m_field.reveal(idx);
+            return true;
+        case Mark:
+            m_field.toggleMark(idx);
+            return true;
+        case Chord:
+            m_field.chord(idx);
+            return true;
+        case NewGame:
+            break;
+    }
+    return false;
+}
+
+void BotServer::FieldGame::botNewGame(int rows, int cols, int mines, quint64 seed)
+{
+    m_field.setSeed(seed);
+    m_field.newGame(rows, cols, mines);
+}
+
+BotServer::BotServer(Game* game, QObject* parent)
+    : QObject(parent), m_game(game), m_socket(0), m_movePending(false)
+{
+    m_server = new QLocalServer(this);
+    connect(m_server, &QLocalServer::newConnection, this, &BotServer::acceptBot);
+}
+
+bool BotServer::listen(const QString& name)
+{
+    QLocalServer::removeServer(name);
+    return m_server->listen(name);
+}
+
+QString BotServer::errorString() const
+{
+    return m_server->errorString();
+}
+
+void BotServer::sendBoard()
+{
+    if(!m_socket)
+        return;
+    // the pending move is gone with its game
+    if(m_movePending)
+    {
+        m_movePending = false;
+        appendUpdate(Rejected, QVector<int>());
+        appendBoard();
+        runCommands();
+    }
+    else
+        appendBoard();
+    flush();
+}
+
+void BotServer::sendChanges(const QVector<int>& cells)
+{
+    const MineField* field = m_game->botField();
+    if(!m_socket || !field)
+        return;
+    appendUpdate(statusOf(field), cells);
+    if(m_movePending)
+    {
+        m_movePending = false;
+        runCommands();
+    }
+    flush();
+}
+
+void BotServer::acceptBot()
+{
+    while(QLocalSocket* socket = m_server->nextPendingConnection())
+    {
+        if(m_socket)
+        {
+            // someone is playing already
+            socket->disconnectFromServer();
+            socket->deleteLater();
+            continue;
+        }
+        m_socket = socket;
+        m_input.clear();
+        connect(m_socket, &QLocalSocket::readyRead, this, &BotServer::readCommands);
+        connect(m_socket, &QLocalSocket::disconnected, this, &BotServer::dropBot);
+
+        appendBoard();
+        const MineField* field = m_game->botField();
+        if(field)
+        {
+            m_visibleCells.resize(0);
+            for(int idx=0; idx<field->cellCount(); ++idx)
+            {
+                if(cellCode(field, idx) != Hidden)
+                    m_visibleCells.append(idx);
+            }
+            if(!m_visibleCells.isEmpty())
+                appendUpdate(statusOf(field), m_visibleCells);
+        }
+        flush();
+    }
+}
+
+void BotServer::readCommands()
+{
+    if(!m_socket)
+        return;
+    m_input.append(m_socket->readAll());
+    runCommands();
+    flush();
+}
+
+void BotServer::runCommands()
+{
+    // replies to everything which came at once go out together
+    int pos = 0;
+    while(pos < m_input.size() && !m_movePending)
+    {
+        const int size = commandSize(m_input.at(pos));
+        if(size == 0)
+        {
+            m_socket->abort();
+            dropBot();
+            return;
+        }
+        if(pos + size > m_input.size())
+            break;
+        runCommand(m_input.constData() + pos);
+        pos += size;
+        if(!m_socket)
+            return;
+    }
+    m_input.remove(0, pos);
+}
+
+void BotServer::dropBot()
+{
+    if(!m_socket)
+        return;
+    m_socket->disconnect(this);
+    m_socket->deleteLater();
+    m_socket = 0;
+    m_input.clear();
+    m_output.clear();
+    m_movePending = false;
+}
+
+void BotServer::runCommand(const char* data)
+{
+    const Command command = static_cast<Command>(data[0]);
+    if(command == NewGame)
+    {
+        const int rows = readNumber(data + 1, 2);
+        const int cols = readNumber(data + 3, 2);
+        const int mines = readNumber(data + 5, 4);
+        const quint64 seed = readNumber(data + 9, 8);
+        // the old board stays if the new one makes no sense
+        if(rows >= 1 && cols >= 1 && rows <= MAX_FIELD_SIDE && cols <= MAX_FIELD_SIDE
+           && mines >= 1 && mines <= rows*cols - MineField::MINIMAL_FREE)
+            m_game->botNewGame(rows, cols, mines, seed);
+        appendBoard();
+        return;
+    }
+
+    const int idx = readNumber(data + 1, 4);
+    const MineField* field = m_game->botField();
+    if(!field || idx < 0 || idx >= field->cellCount() || field->isGameOver()
+       || !m_game->botMove(command, idx))
+    {
+        appendUpdate(Rejected, QVector<int>());
+        return;
+    }
+    // the update comes with sendChanges()
+    if(m_game->isMovePending())
+    {
+        m_movePending = true;
+        return;
+    }
+    appendUpdate(statusOf(field), field->changedCells());
+}
+
+void BotServer::appendBoard()
+{
+    const MineField* field = m_game->botField();
+    m_output.append(static_cast<char>(BoardMessage));
+    appendNumber(&m_output, field ? field->rowCount() : 0, 2);
+    appendNumber(&m_output, field ? field->columnCount() : 0, 2);
+    appendNumber(&m_output, field ? field->minesCount() : 0, 4);
+}
+
+void BotServer::appendUpdate(Status status, const QVector<int>& cells)
+{
+    const MineField* field = m_game->botField();
+    m_output.append(static_cast<char>(UpdateMessage));
+    m_output.append(static_cast<char>(status));
+    appendNumber(&m_output, cells.size(), 4);
+    foreach(int idx, cells)
+    {
+        appendNumber(&m_output, idx, 4);
+        m_output.append(static_cast<char>(cellCode(field, idx)));
+    }
+}
+
+void BotServer::flush()
+{
+    if(!m_socket || m_output.isEmpty())
+        return;
+    m_socket->write(m_output);
+    // don't wait for the event loop, bots wait for the reply
+    m_socket->flush();
+    m_output.resize(0);
+}
+
+int BotServer::commandSize(char command)
+{
+    switch(command)
+    {
+        case NewGame:
+            return 17;
+        case Reveal:
+        case Mark:
+        case Chord:
+            return 5;
+    }
+    return 0;
+}
+
+BotServer::Status BotServer::statusOf(const MineField* field)
+{
+    if(!field->isGameOver())
+        return Playing;
+    return field->isWon() ? Won : Lost;
+}
+
+quint8 BotServer::cellCode(const MineField* field, int idx)
+{
+    switch(field->cellState(idx))
+    {
+        case KMinesState::Flagged:
+            return Flagged;
+        case KMinesState::Questioned:
+            return Questioned;
+        case KMinesState::Error:
+            return WrongFlag;
+        case KMinesState::Revealed:
+            if(field->hasMine(idx))
+                return field->isExploded(idx) ? ExplodedMine : Mine;
+            return field->digit(idx);
+        default:
+            return Hidden;
+    }
+}
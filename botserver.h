@@ -0,0 +1,240 @@
+/*
+    Copyright 2026 The KMines Authors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#ifndef BOTSERVER_H
+#define BOTSERVER_H
+
+#include <QObject>
+#include <QVector>
+#include <QByteArray>
+#include <QString>
+
+#include "minefield.h"
+
+class QLocalServer;
+class QLocalSocket;
+
+/**
+ * Lets an external program (a bot) play over a local socket.
+ *
+ * The protocol is binary, all numbers are little-endian. A bot sends
+ * commands of fixed size, starting with the command byte:
+ * @li NewGame: u16 rows, u16 columns, u32 mines, u64 seed (0 is random)
+ * @li Reveal, Mark, Chord: u32 index of the cell (row*columns+column)
+ *
+ * The server sends two kinds of messages:
+ * @li BoardMessage: u16 rows, u16 columns, u32 mines. Sent when a bot
+ *     connects, as a reply to NewGame and when a new game is started
+ *     from elsewhere. All cells of a new board are Hidden
+ * @li UpdateMessage: u8 status (see Status), u32 count, then count times
+ *     u32 index and u8 cell (see Cell). Only cells changed by the move are
+ *     listed. Every move gets exactly one, which is empty if the move
+ *     changed nothing. Moves made from elsewhere are sent too. The first
+ *     Reveal of a game may wait for its field to be generated, commands
+ *     sent meanwhile are run after its update
+ *
+ * A bot connecting in the middle of a game gets an update of all cells
+ * which aren't hidden right after the board. Only one bot can be
+ * connected at a time, others are disconnected right away, and so is
+ * a bot sending anything the protocol doesn't know.
+ */
+class BotServer : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * Command bytes sent by bots
+     */
+    enum Command
+    {
+        NewGame = 'N',
+        Reveal = 'R',
+        /// cycle marks of the cell, see MineField::toggleMark()
+        Mark = 'M',
+        Chord = 'C'
+    };
+    /**
+     * Message bytes sent by the server
+     */
+    enum Message
+    {
+        BoardMessage = 'B',
+        UpdateMessage = 'U'
+    };
+    /**
+     * Status of the game sent with every update
+     */
+    enum Status
+    {
+        Playing,
+        Won,
+        Lost,
+        /// the move wasn't allowed, e.g. the game is over or paused
+        Rejected
+    };
+    /**
+     * What a bot sees in a cell. Revealed cells without mine are
+     * sent as their digit, 0 to 8
+     */
+    enum Cell
+    {
+        Hidden = 9,
+        Flagged,
+        Questioned,
+        /// revealed when the game is lost
+        Mine,
+        ExplodedMine,
+        /// flag on a cell without mine, shown when the game is lost
+        WrongFlag
+    };
+
+    /**
+     * Game played by bots
+     */
+    class Game
+    {
+    public:
+        virtual ~Game() {}
+        /**
+         * @return field played by bots, 0 if they can't play now
+         */
+        virtual const MineField* botField() const = 0;
+        /**
+         * Makes a move. Changed cells are then taken from changedCells()
+         * of the field
+         *
+         * @return false if the move is not allowed now
+         */
+        virtual bool botMove(Command command, int idx) = 0;
+        /**
+         * @return whether the last accepted move is finished later.
+         * Its changes are then given to sendChanges()
+         */
+        virtual bool isMovePending() const { return false; }
+        /**
+         * Starts a new game. Parameters have been checked already
+         */
+        virtual void botNewGame(int rows, int cols, int mines, quint64 seed) = 0;
+    };
+
+    /**
+     * Game without any GUI playing a MineField, for headless servers
+     */
+    class FieldGame : public Game
+    {
+    public:
+        FieldGame();
+        const MineField* botField() const { return &m_field; }
+        bool botMove(Command command, int idx);
+        void botNewGame(int rows, int cols, int mines, quint64 seed);
+    private:
+        MineField m_field;
+    };
+
+    /**
+     * Constructor
+     *
+     * @param game game bots play, must outlive the server
+     */
+    explicit BotServer(Game* game, QObject* parent = 0);
+    /**
+     * Starts listening on local socket of given name.
+     * A stale socket left by a crashed server is removed
+     *
+     * @return false if it isn't possible
+     */
+    bool listen(const QString& name);
+    /**
+     * @return description of the last error
+     */
+    QString errorString() const;
+    /**
+     * @return whether a bot is connected
+     */
+    bool hasBot() const { return m_socket != 0; }
+    /**
+     * Tells the bot that a new game was started from elsewhere
+     */
+    void sendBoard();
+    /**
+     * Tells the bot about a move made from elsewhere,
+     * or finishes its own pending move
+     */
+    void sendChanges(const QVector<int>& cells);
+
+    /**
+     * Bigger boards can't be asked for by NewGame
+     */
+    static const int MAX_FIELD_SIDE = 2000;
+private slots:
+    void acceptBot();
+    void readCommands();
+    void dropBot();
+private:
+    /**
+     * Runs complete commands in m_input until a move is pending
+     */
+    void runCommands();
+    /**
+     * Runs a single complete command starting at data
+     */
+    void runCommand(const char* data);
+    /**
+     * Appends BoardMessage to m_output
+     */
+    void appendBoard();
+    /**
+     * Appends UpdateMessage with given cells to m_output
+     */
+    void appendUpdate(Status status, const QVector<int>& cells);
+    /**
+     * Sends everything in m_output
+     */
+    void flush();
+    /**
+     * @return size of command starting with given byte, 0 if it's unknown
+     */
+    static int commandSize(char command);
+    /**
+     * @return status sent with updates of given field
+     */
+    static Status statusOf(const MineField* field);
+    /**
+     * @return what a bot sees in cell at idx
+     */
+    static quint8 cellCode(const MineField* field, int idx);
+
+    Game* m_game;
+    QLocalServer* m_server;
+    QLocalSocket* m_socket;
+    /**
+     * Bytes of an incomplete command
+     */
+    QByteArray m_input;
+    QByteArray m_output;
+    /**
+     * True while the last move of the bot waits for the game,
+     * see Game::isMovePending()
+     */
+    bool m_movePending;
+    /**
+     * Cells which aren't hidden, sent to a newly connected bot
+     */
+    QVector<int> m_visibleCells;
+};
+
+#endif
@@ -19,16 +19,11 @@
 
 #include "cellitem.h"
 
-#include "settings.h"
+#include "tileatlas.h"
 
-QHash<int, QString> CellItem::s_digitNames;
-QHash<KMinesState::CellState, QList<QString> > CellItem::s_stateNames;
-
-CellItem::CellItem(KGameRenderer* renderer, QGraphicsItem* parent)
-    : KGameRenderedItem(renderer, QLatin1String( "" ), parent)
+CellItem::CellItem(TileAtlas* atlas, QGraphicsItem* parent)
+    : QGraphicsPixmapItem(parent), m_atlas(atlas), m_cellSize(0)
 {
-    if(s_digitNames.isEmpty())
-        fillNameHashes();
     setShapeMode(BoundingRectShape);
     reset();
 }
@@ -36,6 +31,7 @@ CellItem::CellItem(KGameRenderer* renderer, QGraphicsItem* parent)
 void CellItem::reset()
 {
     m_state = KMinesState::Released;
+    m_stateBeforePress = KMinesState::Released;
     m_hasMine = false;
     m_exploded = false;
     m_digit = 0;
@@ -44,93 +40,37 @@ void CellItem::reset()
 
 void CellItem::updatePixmap()
 {
-    QList<QGraphicsItem*> children = childItems();
-    qDeleteAll(children);
-
-    QList<QString> spriteKeys = s_stateNames[m_state];
-    setSpriteKey(spriteKeys[0]);
-    for(int i=1; i<spriteKeys.count(); i++)
-        addOverlay(spriteKeys[i]);
-    if(m_state == KMinesState::Revealed)
-    {
-        if(m_digit != 0)
-            addOverlay(s_digitNames[m_digit]);
-        else if(m_hasMine)
-        {
-            if(m_exploded)
-                addOverlay(QLatin1String( "explosion" ));
-            addOverlay(QLatin1String( "mine" ));
-        }
-    }
+    // pixmaps are implicitly shared, so this doesn't copy anything
+    setPixmap(m_atlas->tile(TileAtlas::cellTile(m_state, m_digit, m_hasMine, m_exploded)));
+    const int tileSize = m_atlas->tileSize();
+    setScale(tileSize > 0 ? qreal(m_cellSize) / tileSize : 1.0);
 }
 
-void CellItem::setRenderSize(const QSize &renderSize)
+void CellItem::setCellSize(int size)
 {
-    KGameRenderedItem::setRenderSize(renderSize);
-    QList<QGraphicsItem*> children = childItems();
-    foreach( QGraphicsItem* item, children)
-    {
-        ((KGameRenderedItem*)item)->setRenderSize(renderSize);
-    }
+    m_cellSize = size;
+    updatePixmap();
 }
 
 void CellItem::press()
 {
-    if(m_state == KMinesState::Released)
+    if(m_state == KMinesState::Released || m_state == KMinesState::Hint)
     {
+        m_stateBeforePress = m_state;
         m_state = KMinesState::Pressed;
         updatePixmap();
     }
 }
 
-void CellItem::release(bool force)
+void CellItem::setCellState(KMinesState::CellState state, int digit, bool hasMine, bool exploded)
 {
-    // special case for mid-button magic
-    if(force && (m_state == KMinesState::Flagged || m_state == KMinesState::Questioned))
+    if(m_state == state && m_digit == digit && m_hasMine == hasMine && m_exploded == exploded)
         return;
 
-    if(m_state == KMinesState::Pressed || force)
-    {
-        // if we hold mine, let's explode
-        m_exploded = m_hasMine;
-        reveal();
-    }
-}
-
-void CellItem::mark()
-{
-    // this will provide cycling through
-    // Released -> "?"-mark -> "RedFlag"-mark -> Released
-
-    bool useQuestion = Settings::useQuestionMarks();
-
-    switch(m_state)
-    {
-        case KMinesState::Released:
-            m_state = KMinesState::Flagged;
-            break;
-        case KMinesState::Flagged:
-            m_state = useQuestion ? KMinesState::Questioned : KMinesState::Released;
-            break;
-        case KMinesState::Questioned:
-            m_state = KMinesState::Released;
-            break;
-        default:
-            // shouldn't be here
-            break;
-    } // end switch
-    updatePixmap();
-}
-
-void CellItem::reveal()
-{
-    if(isRevealed())
-        return; // already revealed
-
-    if(m_state == KMinesState::Flagged && m_hasMine == false)
-        m_state = KMinesState::Error;
-    else
-        m_state = KMinesState::Revealed;
+    m_state = state;
+    m_digit = digit;
+    m_hasMine = hasMine;
+    m_exploded = exploded;
     updatePixmap();
 }
 
@@ -138,38 +78,7 @@ void CellItem::undoPress()
 {
     if(m_state == KMinesState::Pressed)
     {
-        m_state = KMinesState::Released;
+        m_state = m_stateBeforePress;
         updatePixmap();
     }
 }
-
-void CellItem::fillNameHashes()
-{
-    s_digitNames[1] = QLatin1String( "arabicOne" );
-    s_digitNames[2] = QLatin1String( "arabicTwo" );
-    s_digitNames[3] = QLatin1String( "arabicThree" );
-    s_digitNames[4] = QLatin1String( "arabicFour" );
-    s_digitNames[5] = QLatin1String( "arabicFive" );
-    s_digitNames[6] = QLatin1String( "arabicSix" );
-    s_digitNames[7] = QLatin1String( "arabicSeven" );
-    s_digitNames[8] = QLatin1String( "arabicEight" );
-
-    s_stateNames[KMinesState::Released].append(QLatin1String( "cell_up" ));
-    s_stateNames[KMinesState::Pressed].append(QLatin1String( "cell_down" ));
-    s_stateNames[KMinesState::Revealed].append(QLatin1String( "cell_down" ));
-    s_stateNames[KMinesState::Questioned].append(QLatin1String( "cell_up" ));
-    s_stateNames[KMinesState::Questioned].append(QLatin1String( "question" ));
-    s_stateNames[KMinesState::Flagged].append(QLatin1String( "cell_up" ));
-    s_stateNames[KMinesState::Flagged].append(QLatin1String( "flag" ));
-    s_stateNames[KMinesState::Error].append(QLatin1String( "cell_down" ));
-    s_stateNames[KMinesState::Error].append(QLatin1String( "mine" ));
-    s_stateNames[KMinesState::Error].append(QLatin1String( "error" ));
-    s_stateNames[KMinesState::Hint].append(QLatin1String( "cell_up" ));
-    s_stateNames[KMinesState::Hint].append(QLatin1String( "hint" ));
-}
-
-void CellItem::addOverlay(const QString& spriteKey)
-{
-    KGameRenderedItem* overlay = new KGameRenderedItem(renderer(), spriteKey, this);
-    overlay->setRenderSize(renderSize());
-}
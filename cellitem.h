@@ -19,105 +19,83 @@
 #ifndef CELLITEM_H
 #define CELLITEM_H
 
-#include <KGameRenderedItem>
+#include <QGraphicsPixmapItem>
 
 #include "commondefs.h"
 
-class KGameRenderer;
+class TileAtlas;
 
 /**
  * Graphics item representing single cell on
  * the game field.
- * Handles clicks, emits signals when something important happens :)
+ * Only shows the state of the cell which is kept in MineField.
+ * Pixmaps come from a TileAtlas shared by all cells, with overlays
+ * already composited, so changing state just swaps the pixmap
  */
-class CellItem : public KGameRenderedItem
+class CellItem : public QGraphicsPixmapItem
 {
 public:
-    CellItem(KGameRenderer* renderer, QGraphicsItem* parent);
     /**
-     * Updates item pixmap according to its current
-     * state and properties
-     */
-    void updatePixmap();
-    /**
-     * Reimplemented to pass the call on to any child items as well
-     */
-    void setRenderSize(const QSize &renderSize);
-    // FIXME: will it EVER be needed to setHasMine(false)???
-    /**
-     * Sets whether this item holds mine or not
-     */
-    void setHasMine(bool hasMine) { m_hasMine = hasMine; }
-    /**
-     * @return whether this item holds mine
-     */
-    bool hasMine() const { return m_hasMine; }
-    /**
-     * Sets this item so it holds a digit
+     * Constructor
      *
-     * @param digit digit number (1 to 8)
-     */
-    void setDigit(int digit) { m_digit = digit; updatePixmap(); }
-    /**
-     * @return digit this item holds or 0 if none
+     * @param atlas tiles to show, shared with MineFieldItem
      */
-    int digit() const { return m_digit; }
+    CellItem(TileAtlas* atlas, QGraphicsItem* parent);
     /**
-     * Shows what this item hides :)
-     * Can be a bomb, a digit, an empty square
+     * Updates item pixmap according to its current
+     * state and properties. Call it after tiles of the atlas
+     * were dropped
      */
-    void reveal();
+    void updatePixmap();
     /**
-     * Hides what this item shows ;).
-     * I.e. resets revealed state
+     * Sets size of the cell. Tiles of the atlas are scaled
+     * to it until tiles of this size are ready
      */
-    void unreveal() { m_state = KMinesState::Released; updatePixmap(); }
+    void setCellSize(int size);
     /**
-     * @return whether this cell is revealed
+     * Updates item to show given state of the cell.
+     * Pixmap is updated only if something actually changed
+     *
+     * @param state state of the cell as stored in MineField
+     * @param digit digit number (0 to 8)
+     * @param hasMine whether cell holds mine
+     * @param exploded whether mine in the cell is exploded
      */
-    bool isRevealed() const { return ( m_state == KMinesState::Revealed || m_state == KMinesState::Error); }
+    void setCellState(KMinesState::CellState state, int digit, bool hasMine, bool exploded);
     /**
-     * @return whether this cell is marked with flag
+     * @return state this item currently shows
      */
-    bool isFlagged() const { return m_state == KMinesState::Flagged; }
+    KMinesState::CellState cellState() const { return m_state; }
     /**
-     * @return whether this cell is marked with question
+     * Resets all properties & state of an item to default ones
      */
-    bool isQuestioned() const { return m_state == KMinesState::Questioned; }
+    void reset();
     /**
-     * @return whether this cell is exploded
+     * Shows item as pressed if it is released or shows a hint.
+     * Pressing is purely visual, the game engine doesn't know about it
      */
-    bool isExploded() const { return m_exploded; }
+    void press();
     /**
-     * Resets all properties & state of an item to default ones
+     * Shows pressed item as it was before press()
      */
-    void reset();
-    // TODO docs
-    void press();
-    void release(bool force=false);
     void undoPress();
-    void mark();
     // enable use of qgraphicsitem_cast
     enum { Type = UserType + 1 };
     virtual int type() const { return Type; }
-signals:
-    /**
-     * Emitted when this item is revealed with mouse click
-     */
-    void revealed();
+private:
     /**
-     * Emitted when flag (not question mark) is set or unset on this item
-     * New flagged state can be retrieved via isFlagged()
+     * Tiles to show
      */
-    void flaggedStateChanged();
-private:
-    static QHash<int, QString> s_digitNames;
-    static QHash<KMinesState::CellState, QList<QString> > s_stateNames;
-    static void fillNameHashes();
+    TileAtlas* m_atlas;
+    int m_cellSize;
     /**
      * Current state of this item
      */
     KMinesState::CellState m_state;
+    /**
+     * State to return to from KMinesState::Pressed
+     */
+    KMinesState::CellState m_stateBeforePress;
     /**
      * True if this item holds mine
      */
@@ -130,10 +108,6 @@ private:
      * Specifies a digit this item holds. 0 if none
      */
     int m_digit;
-    /**
-     * Add a child object to display an overlayed pixmap
-     */
-    void addOverlay(const QString& spriteKey);
 };
 
 #endif
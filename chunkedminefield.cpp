@@ -0,0 +1,497 @@
+/*
+    Copyright 2026 The KMines Authors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#include "chunkedminefield.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "counterrandom.h"
+
+namespace
+{
+
+/**
+ * Densities below this would let empty space spread without end
+ */
+const double MIN_DENSITY = 0.15;
+const double MAX_DENSITY = 0.5;
+
+/**
+ * @return v divided by the chunk size, rounded down also for negative v
+ */
+inline int chunkOf(int v)
+{
+    return v >= 0 ? v / ChunkedMineField::CHUNK_SIZE : -((-(v+1)) / ChunkedMineField::CHUNK_SIZE) - 1;
+}
+
+inline quint64 chunkKey(int chunkRow, int chunkCol)
+{
+    return (static_cast<quint64>(static_cast<quint32>(chunkRow)) << 32) | static_cast<quint32>(chunkCol);
+}
+
+}
+
+ChunkedMineField::ChunkedMineField()
+    : m_seed(0), m_mineThreshold(0), m_originRow(0), m_originCol(0), m_numRows(0), m_numCols(0),
+      m_startRow(0), m_startCol(0), m_explodedRow(0), m_explodedCol(0),
+      m_flaggedCount(0), m_revealedCount(0), m_firstClick(true), m_gameOver(false),
+      m_useQuestionMarks(true)
+{
+}
+
+ChunkedMineField::~ChunkedMineField()
+{
+    qDeleteAll(m_chunks);
+}
+
+void ChunkedMineField::newGame(quint64 seed, double density)
+{
+    qDeleteAll(m_chunks);
+    m_chunks.clear();
+    m_resolved.clear();
+    m_changedCells.resize(0);
+
+    m_seed = seed ? seed : CounterRandom::randomSeed();
+    density = qBound(MIN_DENSITY, density, MAX_DENSITY);
+    m_mineThreshold = static_cast<quint32>(density * 4294967296.0);
+    m_flaggedCount = 0;
+    m_revealedCount = 0;
+    m_firstClick = true;
+    m_gameOver = false;
+}
+
+void ChunkedMineField::setWindow(int originRow, int originCol, int numRows, int numCols)
+{
+    m_originRow = originRow;
+    m_originCol = originCol;
+    m_numRows = numRows;
+    m_numCols = numCols;
+    m_changedCells.resize(0);
+    // nothing can be generated before the first reveal
+    if(!m_firstClick)
+        loadWindowChunks();
+    dropChunks();
+}
+
+void ChunkedMineField::loadWindowChunks()
+{
+    if(m_numRows == 0 || m_numCols == 0)
+        return;
+    int localRow, localCol;
+    const int lastChunkRow = chunkOf(m_originRow + m_numRows - 1);
+    const int lastChunkCol = chunkOf(m_originCol + m_numCols - 1);
+    for(int chunkRow=chunkOf(m_originRow); chunkRow<=lastChunkRow; ++chunkRow)
+        for(int chunkCol=chunkOf(m_originCol); chunkCol<=lastChunkCol; ++chunkCol)
+            chunkAt(chunkRow*CHUNK_SIZE, chunkCol*CHUNK_SIZE, &localRow, &localCol);
+}
+
+bool ChunkedMineField::isVisible(const Chunk* chunk) const
+{
+    return chunk->chunkRow >= chunkOf(m_originRow) && chunk->chunkRow <= chunkOf(m_originRow + m_numRows - 1) &&
+           chunk->chunkCol >= chunkOf(m_originCol) && chunk->chunkCol <= chunkOf(m_originCol + m_numCols - 1);
+}
+
+void ChunkedMineField::dropChunks()
+{
+    // resolved chunks are in m_resolved, untouched ones are
+    // the same as when they were generated
+    QVector<QPair<qint64, quint64> > unfinished;
+    QHash<quint64, Chunk*>::iterator it = m_chunks.begin();
+    while(it != m_chunks.end())
+    {
+        Chunk* chunk = it.value();
+        if(isVisible(chunk))
+            ++it;
+        else if(chunk->resolved || !chunk->touched)
+        {
+            delete chunk;
+            it = m_chunks.erase(it);
+        }
+        else
+        {
+            const qint64 dr = chunk->chunkRow - chunkOf(m_originRow);
+            const qint64 dc = chunk->chunkCol - chunkOf(m_originCol);
+            unfinished.append(qMakePair(dr*dr + dc*dc, it.key()));
+            ++it;
+        }
+    }
+
+    const int excess = m_chunks.size() - MAX_LOADED_CHUNKS;
+    if(excess <= 0)
+        return;
+    // the furthest ones go first
+    std::sort(unfinished.begin(), unfinished.end());
+    for(int i=0; i<excess && i<unfinished.size(); ++i)
+    {
+        const quint64 key = unfinished.at(unfinished.size()-1-i).second;
+        abandonChunk(m_chunks.value(key));
+        delete m_chunks.take(key);
+    }
+}
+
+bool ChunkedMineField::isMineAt(int row, int col) const
+{
+    // the first revealed cell is empty
+    if(qAbs(row - m_startRow) <= 1 && qAbs(col - m_startCol) <= 1)
+        return false;
+    const quint64 pos = (static_cast<quint64>(static_cast<quint32>(row)) << 32) | static_cast<quint32>(col);
+    return (CounterRandom::hash(m_seed, pos) >> 32) < m_mineThreshold;
+}
+
+ChunkedMineField::Chunk* ChunkedMineField::loadChunk(int chunkRow, int chunkCol)
+{
+    Chunk* chunk = new Chunk;
+    chunk->chunkRow = chunkRow;
+    chunk->chunkCol = chunkCol;
+    chunk->mines.fill(0, PLANE_WORDS);
+    quint64* digits[BitPlanes::DIGIT_PLANES];
+    for(int k=0; k<BitPlanes::DIGIT_PLANES; ++k)
+    {
+        chunk->digits[k].fill(0, PLANE_WORDS);
+        digits[k] = chunk->digits[k].data();
+    }
+
+    // plane row r holds local row r-1, bit c holds local column c-1
+    const int firstRow = chunkRow*CHUNK_SIZE - 1;
+    const int firstCol = chunkCol*CHUNK_SIZE - 1;
+    int mines = 0;
+    for(int r=0; r<CHUNK_SIZE+2; ++r)
+        for(int c=0; c<CHUNK_SIZE+2; ++c)
+        {
+            if(!isMineAt(firstRow + r, firstCol + c))
+                continue;
+            chunk->mines[1 + r*PLANE_ROW_WORDS + (c >> 6)] |= quint64(1) << (c & 63);
+            if(r >= 1 && r <= CHUNK_SIZE && c >= 1 && c <= CHUNK_SIZE)
+                mines++;
+        }
+    BitPlanes::countNeighbours(chunk->mines.constData(), digits,
+                               1 + PLANE_ROW_WORDS, CHUNK_SIZE*PLANE_ROW_WORDS, PLANE_ROW_WORDS);
+
+    std::memset(chunk->revealed, 0, sizeof(chunk->revealed));
+    std::memset(chunk->flagged, 0, sizeof(chunk->flagged));
+    std::memset(chunk->questioned, 0, sizeof(chunk->questioned));
+    chunk->unrevealedSafe = CHUNK_SIZE*CHUNK_SIZE - mines;
+    chunk->touched = false;
+
+    const quint64 key = chunkKey(chunkRow, chunkCol);
+    chunk->resolved = m_resolved.contains(key);
+    if(chunk->resolved)
+    {
+        // its flags are still counted in m_flaggedCount
+        for(int r=0; r<CHUNK_SIZE; ++r)
+        {
+            chunk->flagged[r] = mineRow(chunk, r);
+            chunk->revealed[r] = ~chunk->flagged[r];
+        }
+        chunk->unrevealedSafe = 0;
+    }
+    m_chunks.insert(key, chunk);
+    return chunk;
+}
+
+ChunkedMineField::Chunk* ChunkedMineField::chunkAt(int row, int col, int* localRow, int* localCol)
+{
+    const int chunkRow = chunkOf(row);
+    const int chunkCol = chunkOf(col);
+    *localRow = row - chunkRow*CHUNK_SIZE;
+    *localCol = col - chunkCol*CHUNK_SIZE;
+    Chunk* chunk = m_chunks.value(chunkKey(chunkRow, chunkCol));
+    return chunk ? chunk : loadChunk(chunkRow, chunkCol);
+}
+
+const ChunkedMineField::Chunk* ChunkedMineField::findChunk(int row, int col, int* localRow, int* localCol) const
+{
+    const int chunkRow = chunkOf(row);
+    const int chunkCol = chunkOf(col);
+    *localRow = row - chunkRow*CHUNK_SIZE;
+    *localCol = col - chunkCol*CHUNK_SIZE;
+    return m_chunks.value(chunkKey(chunkRow, chunkCol));
+}
+
+quint64 ChunkedMineField::mineRow(const Chunk* chunk, int localRow)
+{
+    // skip the halo column on the left
+    const quint64* row = chunk->mines.constData() + 1 + (localRow+1)*PLANE_ROW_WORDS;
+    return (row[0] >> 1) | (row[1] << 63);
+}
+
+int ChunkedMineField::digitAt(const Chunk* chunk, int localRow, int localCol)
+{
+    const int word = 1 + (localRow+1)*PLANE_ROW_WORDS + ((localCol+1) >> 6);
+    const int bit = (localCol+1) & 63;
+    int digit = 0;
+    for(int k=0; k<BitPlanes::DIGIT_PLANES; ++k)
+        digit |= ((chunk->digits[k].at(word) >> bit) & 1) << k;
+    return digit;
+}
+
+KMinesState::CellState ChunkedMineField::stateAt(const Chunk* chunk, int localRow, int localCol) const
+{
+    const quint64 bit = quint64(1) << localCol;
+    const bool flagged = chunk->flagged[localRow] & bit;
+    if(chunk->revealed[localRow] & bit)
+        return flagged ? KMinesState::Error : KMinesState::Revealed;
+    if(m_gameOver)
+    {
+        // all mines and wrong flags are shown on loss
+        const bool mine = mineRow(chunk, localRow) & bit;
+        if(mine != flagged)
+            return flagged ? KMinesState::Error : KMinesState::Revealed;
+    }
+    if(flagged)
+        return KMinesState::Flagged;
+    return (chunk->questioned[localRow] & bit) ? KMinesState::Questioned : KMinesState::Released;
+}
+
+KMinesState::CellState ChunkedMineField::cellState(int idx) const
+{
+    const FieldPos pos = worldPos(idx);
+    int localRow, localCol;
+    const Chunk* chunk = findChunk(pos.first, pos.second, &localRow, &localCol);
+    // chunks in the window are loaded once the game starts
+    return chunk ? stateAt(chunk, localRow, localCol) : KMinesState::Released;
+}
+
+bool ChunkedMineField::hasMine(int idx) const
+{
+    const FieldPos pos = worldPos(idx);
+    int localRow, localCol;
+    const Chunk* chunk = findChunk(pos.first, pos.second, &localRow, &localCol);
+    return chunk && (mineRow(chunk, localRow) & (quint64(1) << localCol));
+}
+
+bool ChunkedMineField::isExploded(int idx) const
+{
+    const FieldPos pos = worldPos(idx);
+    return m_gameOver && pos.first == m_explodedRow && pos.second == m_explodedCol;
+}
+
+int ChunkedMineField::digit(int idx) const
+{
+    const FieldPos pos = worldPos(idx);
+    int localRow, localCol;
+    const Chunk* chunk = findChunk(pos.first, pos.second, &localRow, &localCol);
+    return chunk ? digitAt(chunk, localRow, localCol) : 0;
+}
+
+int ChunkedMineField::adjasentCellsFor(int idx, int* neighbours) const
+{
+    const FieldPos pos = rowColFromIndex(idx);
+    int count = 0;
+    for(int row=pos.first-1; row<=pos.first+1; ++row)
+        for(int col=pos.second-1; col<=pos.second+1; ++col)
+        {
+            if((row == pos.first && col == pos.second) ||
+               row < 0 || row >= m_numRows || col < 0 || col >= m_numCols)
+                continue;
+            neighbours[count++] = indexOf(row, col);
+        }
+    return count;
+}
+
+void ChunkedMineField::cellChanged(int row, int col)
+{
+    row -= m_originRow;
+    col -= m_originCol;
+    if(row >= 0 && row < m_numRows && col >= 0 && col < m_numCols)
+        m_changedCells.append(indexOf(row, col));
+}
+
+void ChunkedMineField::windowChanged()
+{
+    m_changedCells.resize(0);
+    for(int idx=0; idx<cellCount(); ++idx)
+        m_changedCells.append(idx);
+}
+
+bool ChunkedMineField::reveal(int idx)
+{
+    m_changedCells.resize(0);
+    const FieldPos pos = worldPos(idx);
+    if(m_firstClick && !m_gameOver)
+    {
+        m_firstClick = false;
+        m_startRow = pos.first;
+        m_startCol = pos.second;
+        loadWindowChunks();
+    }
+    return revealAt(pos.first, pos.second);
+}
+
+bool ChunkedMineField::revealAt(int row, int col)
+{
+    if(m_gameOver)
+        return false;
+    int localRow, localCol;
+    Chunk* chunk = chunkAt(row, col, &localRow, &localCol);
+    if(stateAt(chunk, localRow, localCol) != KMinesState::Released)
+        return false; // revealed or marked
+    chunk->touched = true;
+
+    if(mineRow(chunk, localRow) & (quint64(1) << localCol))
+    {
+        // all mines in the window are shown now
+        chunk->revealed[localRow] |= quint64(1) << localCol;
+        m_explodedRow = row;
+        m_explodedCol = col;
+        m_gameOver = true;
+        windowChanged();
+        return true;
+    }
+
+    revealCell(chunk, row, col, localRow, localCol);
+    if(digitAt(chunk, localRow, localCol) == 0)
+        revealEmptySpace(row, col);
+    return true;
+}
+
+void ChunkedMineField::revealCell(Chunk* chunk, int row, int col, int localRow, int localCol)
+{
+    const quint64 bit = quint64(1) << localCol;
+    chunk->revealed[localRow] |= bit;
+    chunk->questioned[localRow] &= ~bit;
+    chunk->touched = true;
+    m_revealedCount++;
+    cellChanged(row, col);
+    if(--chunk->unrevealedSafe == 0)
+        resolveChunk(chunk);
+}
+
+void ChunkedMineField::revealEmptySpace(int row, int col)
+{
+    // same as MineField::revealEmptySpace(), but neighbours
+    // may be in other chunks, which get loaded if needed
+    int revealed = 0;
+    m_floodStack.resize(0);
+    m_floodStack.append(qMakePair(row, col));
+    while(!m_floodStack.isEmpty() && revealed < MAX_FLOOD_CELLS)
+    {
+        const FieldPos current = m_floodStack.last();
+        m_floodStack.removeLast();
+
+        for(int r=current.first-1; r<=current.first+1; ++r)
+            for(int c=current.second-1; c<=current.second+1; ++c)
+            {
+                int localRow, localCol;
+                Chunk* chunk = chunkAt(r, c, &localRow, &localCol);
+                if(stateAt(chunk, localRow, localCol) != KMinesState::Released)
+                    continue; // revealed or marked, also the current cell
+                revealCell(chunk, r, c, localRow, localCol);
+                revealed++;
+                if(digitAt(chunk, localRow, localCol) == 0)
+                    m_floodStack.append(qMakePair(r, c));
+            }
+    }
+}
+
+void ChunkedMineField::resolveChunk(Chunk* chunk)
+{
+    chunk->resolved = true;
+    m_resolved.insert(chunkKey(chunk->chunkRow, chunk->chunkCol));
+    for(int r=0; r<CHUNK_SIZE; ++r)
+    {
+        const quint64 mines = mineRow(chunk, r);
+        quint64 pending = mines & ~chunk->flagged[r];
+        chunk->flagged[r] = mines;
+        chunk->questioned[r] = 0;
+        while(pending)
+        {
+            const int c = BitPlanes::lowestBit(pending);
+            pending &= pending - 1;
+            m_flaggedCount++;
+            cellChanged(chunk->chunkRow*CHUNK_SIZE + r, chunk->chunkCol*CHUNK_SIZE + c);
+        }
+    }
+}
+
+void ChunkedMineField::abandonChunk(Chunk* chunk)
+{
+    // it isn't in the window, so nothing has to be redrawn. revealed
+    // cells aren't counted, the player didn't reveal them
+    for(int r=0; r<CHUNK_SIZE; ++r)
+    {
+        const quint64 mines = mineRow(chunk, r);
+        m_flaggedCount += BitPlanes::bitCount(mines & ~chunk->flagged[r]);
+        m_flaggedCount -= BitPlanes::bitCount(chunk->flagged[r] & ~mines);
+    }
+    chunk->resolved = true;
+    m_resolved.insert(chunkKey(chunk->chunkRow, chunk->chunkCol));
+}
+
+bool ChunkedMineField::toggleMark(int idx)
+{
+    m_changedCells.resize(0);
+    if(m_gameOver || m_firstClick)
+        return false;
+
+    const FieldPos pos = worldPos(idx);
+    int localRow, localCol;
+    Chunk* chunk = chunkAt(pos.first, pos.second, &localRow, &localCol);
+    if(chunk->resolved)
+        return false;
+
+    const quint64 bit = quint64(1) << localCol;
+    switch(stateAt(chunk, localRow, localCol))
+    {
+        case KMinesState::Released:
+            chunk->flagged[localRow] |= bit;
+            m_flaggedCount++;
+            break;
+        case KMinesState::Flagged:
+            chunk->flagged[localRow] &= ~bit;
+            if(m_useQuestionMarks)
+                chunk->questioned[localRow] |= bit;
+            m_flaggedCount--;
+            break;
+        case KMinesState::Questioned:
+            chunk->questioned[localRow] &= ~bit;
+            break;
+        default:
+            // revealed cells can't be marked
+            return false;
+    }
+    chunk->touched = true;
+    m_changedCells.append(idx);
+    return true;
+}
+
+bool ChunkedMineField::chord(int idx)
+{
+    m_changedCells.resize(0);
+    if(m_gameOver || cellState(idx) != KMinesState::Revealed)
+        return false;
+
+    const FieldPos pos = worldPos(idx);
+    int numFlags = 0;
+    for(int r=pos.first-1; r<=pos.first+1; ++r)
+        for(int c=pos.second-1; c<=pos.second+1; ++c)
+        {
+            int localRow, localCol;
+            const Chunk* chunk = chunkAt(r, c, &localRow, &localCol);
+            numFlags += (stateAt(chunk, localRow, localCol) == KMinesState::Flagged);
+        }
+
+    if(numFlags != digit(idx) || numFlags == 0)
+        return false;
+
+    // revealAt() skips revealed and marked cells
+    for(int r=pos.first-1; r<=pos.first+1; ++r)
+        for(int c=pos.second-1; c<=pos.second+1; ++c)
+            revealAt(r, c);
+    return true;
+}
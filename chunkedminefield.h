@@ -0,0 +1,383 @@
+/*
+    Copyright 2026 The KMines Authors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#ifndef CHUNKEDMINEFIELD_H
+#define CHUNKEDMINEFIELD_H
+
+#include <QVector>
+#include <QHash>
+#include <QSet>
+
+#include "minefield.h"
+
+/**
+ * Game engine of the endless mode: a field without edges, stored as
+ * square chunks of CHUNK_SIZE cells.
+ *
+ * Whether a cell holds mine only depends on the seed and the cell's
+ * coordinates (see CounterRandom::hash()), so a chunk is generated when it's first needed and can be
+ * dropped and generated again at any time. The only exception are cells
+ * around the first revealed cell, which never hold mine.
+ *
+ * A chunk is resolved once all its safe cells are revealed. Its mines
+ * are flagged then and it can't be changed anymore. Loaded chunks which
+ * are outside the window and are either resolved or were never touched
+ * by the player are dropped, resolved ones are remembered by their
+ * coordinates only. If the player leaves more than MAX_LOADED_CHUNKS
+ * unfinished, the ones furthest from the window are abandoned: they are
+ * resolved as if the player finished them and dropped too. So cells take
+ * at most MAX_LOADED_CHUNKS chunks of memory no matter how far the player
+ * goes, only coordinates of resolved chunks grow with the explored area.
+ *
+ * The game is lost by revealing mine and is never won.
+ *
+ * Like MineField it doesn't depend on any GUI class. The player sees
+ * a window of the field at a time (see setWindow()) and cells are
+ * addressed by index in the window, which is row*columnCount()+col,
+ * with the same functions as in MineField. Cells outside the window
+ * are addressed by world coordinates.
+ */
+class ChunkedMineField
+{
+public:
+    /**
+     * Constructor. Creates empty field, call newGame() to set it up
+     */
+    ChunkedMineField();
+    ~ChunkedMineField();
+    /**
+     * Starts new game and drops all chunks. Mines are placed
+     * with given density, which is kept between MIN_DENSITY and
+     * MAX_DENSITY. Cells around the first revealed cell are always empty.
+     *
+     * @param seed seed of mine positions, 0 means a random one
+     * @param density probability that a cell holds mine
+     */
+    void newGame(quint64 seed, double density);
+    /**
+     * Sets the part of the field which is visible: numRows x numCols cells
+     * starting at world coordinates (originRow, originCol). Loads chunks
+     * it covers and drops the ones which aren't needed anymore
+     */
+    void setWindow(int originRow, int originCol, int numRows, int numCols);
+    /**
+     * @return world row of the first row of the window
+     */
+    int originRow() const { return m_originRow; }
+    /**
+     * @return world column of the first column of the window
+     */
+    int originCol() const { return m_originCol; }
+    /**
+     * @return num rows in window
+     */
+    int rowCount() const { return m_numRows; }
+    /**
+     * @return num columns in window
+     */
+    int columnCount() const { return m_numCols; }
+    /**
+     * @return total number of cells in window
+     */
+    int cellCount() const { return m_numRows*m_numCols; }
+    /**
+     * @return index of cell at (row,col) of the window
+     */
+    int indexOf(int row, int col) const { return row*m_numCols + col; }
+    /**
+     * Calculates (row,col) in the window from given index and returns them in QPair
+     */
+    FieldPos rowColFromIndex(int idx) const
+        {
+            int row = idx/m_numCols;
+            return qMakePair(row, idx - row*m_numCols);
+        }
+    /**
+     * Fills neighbours with indexes of adjasent cells for cell at idx
+     * which are inside the window
+     *
+     * @param neighbours array of at least MineField::MAX_NEIGHBOURS elements
+     * @return number of adjasent cells
+     */
+    int adjasentCellsFor(int idx, int* neighbours) const;
+
+    /**
+     * Reveals cell at idx. Revealing an empty cell opens the empty space
+     * around it, also outside the window, revealing a mine loses the game.
+     *
+     * @return true if cell was revealed
+     */
+    bool reveal(int idx);
+    /**
+     * Cycles marks of unrevealed cell at idx, see MineField::toggleMark().
+     * Cells can't be marked before the first reveal or in resolved chunks
+     *
+     * @return true if mark was changed
+     */
+    bool toggleMark(int idx);
+    /**
+     * Reveals all unmarked neighbours of revealed cell at idx
+     * if the number of flags around it equals its digit
+     *
+     * @return true if neighbours were revealed
+     */
+    bool chord(int idx);
+    /**
+     * Returns indexes of cells in the window whose state was changed by
+     * the last call of reveal(), toggleMark() or chord(). Changes outside
+     * the window aren't reported, all cells of the window are
+     * after the game is lost
+     */
+    const QVector<int>& changedCells() const { return m_changedCells; }
+    /**
+     * Sets whether toggleMark() should cycle through question mark
+     */
+    void setUseQuestionMarks(bool use) { m_useQuestionMarks = use; }
+
+    /**
+     * @return current state of cell at idx
+     */
+    KMinesState::CellState cellState(int idx) const;
+    /**
+     * @return whether cell at idx holds mine, always false before the first reveal
+     */
+    bool hasMine(int idx) const;
+    /**
+     * @return whether mine in cell at idx is exploded
+     */
+    bool isExploded(int idx) const;
+    /**
+     * @return digit cell at idx holds or 0 if none
+     */
+    int digit(int idx) const;
+
+    /**
+     * @return seed of mine positions
+     */
+    quint64 seed() const { return m_seed; }
+    /**
+     * @return number of flagged cells
+     */
+    int flaggedCount() const { return m_flaggedCount; }
+    /**
+     * @return number of revealed safe cells
+     */
+    qint64 revealedCount() const { return m_revealedCount; }
+    /**
+     * @return true if nothing is revealed yet
+     */
+    bool isFirstClick() const { return m_firstClick; }
+    /**
+     * @return true if game is lost
+     */
+    bool isGameOver() const { return m_gameOver; }
+    /**
+     * @return number of chunks held in memory
+     */
+    int loadedChunkCount() const { return m_chunks.size(); }
+    /**
+     * @return number of resolved chunks
+     */
+    int resolvedChunkCount() const { return m_resolved.size(); }
+
+    /**
+     * Number of rows and columns of a chunk
+     */
+    static const int CHUNK_SIZE = 64;
+    /**
+     * Maximal number of cells opened by a single empty cell. Empty space
+     * can't be infinite with MIN_DENSITY, this only limits bad luck
+     */
+    static const int MAX_FLOOD_CELLS = 1 << 20;
+    /**
+     * Maximal number of chunks kept in memory, unless more are needed
+     * to cover the window. A chunk takes about 7 KiB
+     */
+    static const int MAX_LOADED_CHUNKS = 1024;
+private:
+    /**
+     * Words in a row of the mines and digits planes of a chunk:
+     * CHUNK_SIZE cells, one cell of halo on each side and an empty gap
+     */
+    static const int PLANE_ROW_WORDS = 2;
+    /**
+     * Words in the mines and digits planes of a chunk: a padding word,
+     * CHUNK_SIZE rows with one row of halo above and below, a padding word
+     */
+    static const int PLANE_WORDS = (CHUNK_SIZE+2)*PLANE_ROW_WORDS + 2;
+
+    /**
+     * Loaded part of the field
+     */
+    struct Chunk
+    {
+        /**
+         * Mines and digits, laid out for BitPlanes::countNeighbours(). Mines
+         * have a one cell wide halo, so digits on edges are right, too
+         */
+        QVector<quint64> mines;
+        QVector<quint64> digits[BitPlanes::DIGIT_PLANES];
+        /**
+         * Marks and revealed cells, a word per row
+         */
+        quint64 revealed[CHUNK_SIZE];
+        quint64 flagged[CHUNK_SIZE];
+        quint64 questioned[CHUNK_SIZE];
+        /**
+         * Row and column of the chunk, in chunks
+         */
+        int chunkRow;
+        int chunkCol;
+        /**
+         * Number of safe cells which aren't revealed yet
+         */
+        int unrevealedSafe;
+        /**
+         * Whether all safe cells are revealed
+         */
+        bool resolved;
+        /**
+         * Whether player revealed or marked something here,
+         * chunks which weren't touched can be generated again
+         */
+        bool touched;
+    };
+
+    /**
+     * @return chunk holding cell at world (row,col), loads it if needed.
+     * Sets local coordinates of the cell in the chunk
+     */
+    Chunk* chunkAt(int row, int col, int* localRow, int* localCol);
+    /**
+     * @return chunk holding cell at world (row,col) or 0 if it isn't loaded
+     */
+    const Chunk* findChunk(int row, int col, int* localRow, int* localCol) const;
+    /**
+     * Generates chunk at given chunk coordinates
+     */
+    Chunk* loadChunk(int chunkRow, int chunkCol);
+    /**
+     * Loads all chunks covered by the window
+     */
+    void loadWindowChunks();
+    /**
+     * Drops chunks outside the window which can be generated again,
+     * abandons unfinished ones if there are too many
+     */
+    void dropChunks();
+    /**
+     * @return whether the chunk intersects the window
+     */
+    bool isVisible(const Chunk* chunk) const;
+    /**
+     * @return whether cell at world (row,col) holds mine
+     */
+    bool isMineAt(int row, int col) const;
+    /**
+     * @return mines of a row of the chunk, bit per column
+     */
+    static quint64 mineRow(const Chunk* chunk, int localRow);
+    /**
+     * @return digit of cell at given local coordinates
+     */
+    static int digitAt(const Chunk* chunk, int localRow, int localCol);
+    /**
+     * @return state of cell at given local coordinates
+     */
+    KMinesState::CellState stateAt(const Chunk* chunk, int localRow, int localCol) const;
+    /**
+     * @return world coordinates of cell at idx of the window
+     */
+    FieldPos worldPos(int idx) const
+        {
+            const FieldPos pos = rowColFromIndex(idx);
+            return qMakePair(m_originRow + pos.first, m_originCol + pos.second);
+        }
+    /**
+     * Reveals cell at world (row,col) if it's released
+     */
+    bool revealAt(int row, int col);
+    /**
+     * Reveals a single safe cell and records it in m_changedCells
+     */
+    void revealCell(Chunk* chunk, int row, int col, int localRow, int localCol);
+    /**
+     * Reveals all empty cells around cell at world (row,col),
+     * until it finds cells with digits (which are also revealed)
+     */
+    void revealEmptySpace(int row, int col);
+    /**
+     * Flags all mines of the chunk once its safe cells are revealed
+     */
+    void resolveChunk(Chunk* chunk);
+    /**
+     * Resolves unfinished chunk: reveals its safe cells
+     * and flags its mines, removing wrong flags
+     */
+    void abandonChunk(Chunk* chunk);
+    /**
+     * Records change of cell at world (row,col) if it's in the window
+     */
+    void cellChanged(int row, int col);
+    /**
+     * Reports all cells of the window as changed
+     */
+    void windowChanged();
+
+    /**
+     * Loaded chunks by chunkKey()
+     */
+    QHash<quint64, Chunk*> m_chunks;
+    /**
+     * Keys of resolved chunks
+     */
+    QSet<quint64> m_resolved;
+    QVector<int> m_changedCells;
+    /**
+     * World coordinates of cells whose neighbours still have
+     * to be revealed by revealEmptySpace()
+     */
+    QVector<FieldPos> m_floodStack;
+    quint64 m_seed;
+    /**
+     * Cells hold mine if upper half of their hash is below this
+     */
+    quint32 m_mineThreshold;
+    int m_originRow;
+    int m_originCol;
+    int m_numRows;
+    int m_numCols;
+    /**
+     * World coordinates of the first revealed cell
+     */
+    int m_startRow;
+    int m_startCol;
+    /**
+     * World coordinates of exploded mine
+     */
+    int m_explodedRow;
+    int m_explodedCol;
+    int m_flaggedCount;
+    qint64 m_revealedCount;
+    bool m_firstClick;
+    bool m_gameOver;
+    bool m_useQuestionMarks;
+
+    Q_DISABLE_COPY(ChunkedMineField)
+};
+
+#endif
@@ -0,0 +1,31 @@
+/*
+    Copyright 2026 The KMines Authors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#include "counterrandom.h"
+
+#include <KRandom>
+
+quint64 CounterRandom::randomSeed()
+{
+    // KRandom gives 31 bits at a time
+    quint64 seed = 0;
+    for(int i=0; i<3; ++i)
+        seed = (seed << 31) ^ static_cast<quint64>(KRandom::random());
+    // mixing spreads the bits, 0 is left for "random seed"
+    seed = mix(seed);
+    return seed ? seed : 1;
+}
@@ -0,0 +1,106 @@
+/*
+    Copyright 2026 The KMines Authors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#ifndef COUNTERRANDOM_H
+#define COUNTERRANDOM_H
+
+#include <QtGlobal>
+
+/**
+ * Counter-based random numbers. The n-th number of a stream is a hash
+ * (the splitmix64 finalizer) of the stream's key and n, and the key is a
+ * hash of a 64-bit seed and a stream number, e.g. number of a board
+ * generated from the seed. So any number can be computed without the
+ * ones before it, and different boards of the same seed, or boards
+ * generated in different threads, never share any state.
+ *
+ * Numbers only depend on the seed and are the same on every platform,
+ * so a board is fully described by its seed.
+ */
+class CounterRandom
+{
+public:
+    /**
+     * Constructor
+     *
+     * @param seed seed of the stream
+     * @param stream number of the stream of given seed
+     */
+    explicit CounterRandom(quint64 seed = 0, quint64 stream = 0)
+        : m_key(hash(seed, stream)), m_counter(0) {}
+    /**
+     * Starts stream of given seed from its beginning
+     */
+    void setStream(quint64 seed, quint64 stream)
+    {
+        m_key = hash(seed, stream);
+        m_counter = 0;
+    }
+    /**
+     * @return next number of the stream
+     */
+    quint64 next() { return at(m_counter++); }
+    /**
+     * @return n-th number of the stream, doesn't move it
+     */
+    quint64 at(quint64 n) const { return mix(m_key + n*GOLDEN_GAMMA); }
+    /**
+     * @return next number of the stream reduced to [0, bound),
+     * without bias. bound must be positive
+     */
+    quint32 bounded(quint32 bound)
+    {
+        // multiply and take the upper half, rejecting the few
+        // products which would make low results more likely
+        quint64 product = (next() >> 32) * bound;
+        if(static_cast<quint32>(product) < bound)
+        {
+            const quint32 threshold = static_cast<quint32>(-bound) % bound;
+            while(static_cast<quint32>(product) < threshold)
+                product = (next() >> 32) * bound;
+        }
+        return static_cast<quint32>(product >> 32);
+    }
+
+    /**
+     * splitmix64 finalizer, a bijection which mixes all bits of z
+     */
+    static quint64 mix(quint64 z)
+    {
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+    /**
+     * @return hash of value keyed by seed
+     */
+    static quint64 hash(quint64 seed, quint64 value) { return mix(seed ^ mix(value + GOLDEN_GAMMA)); }
+    /**
+     * @return a new random seed, never 0
+     */
+    static quint64 randomSeed();
+
+    /**
+     * Increment of splitmix64
+     */
+    static const quint64 GOLDEN_GAMMA = 0x9E3779B97F4A7C15ULL;
+private:
+    quint64 m_key;
+    quint64 m_counter;
+};
+
+#endif
@@ -0,0 +1,199 @@
+/*
+    Copyright 2026 The KMines Authors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#include "gamesimulator.h"
+
+#include <QElapsedTimer>
+#include <QRunnable>
+#include <QThread>
+#include "minesolver.h"
+#include "mineprobability.h"
+
+/**
+ * Number of chunks each worker may be ahead of takeResults()
+ */
+static const int CHUNKS_AHEAD = 4;
+/**
+ * Stream of random guesses of a game, boards of its seed use the first ones
+ */
+static const quint64 GUESS_STREAM = ~quint64(0);
+
+const GameSimulator::Strategy GameSimulator::STRATEGIES[] = {
+    { "safest", "all rules of the solver, reveals the safest cell when stuck",
+      MineSolver::DEFAULT_MAX_COMPONENT_SIZE, SafestCell },
+    { "logic", "all rules of the solver, reveals a random cell when stuck",
+      MineSolver::DEFAULT_MAX_COMPONENT_SIZE, RandomCell },
+    { "local", "single cell and pair rules only, reveals a random cell when stuck",
+      0, RandomCell }
+};
+const int GameSimulator::STRATEGY_COUNT = sizeof(STRATEGIES) / sizeof(STRATEGIES[0]);
+
+class GameSimulator::Worker : public QRunnable
+{
+public:
+    explicit Worker(GameSimulator* simulator) : m_simulator(simulator) {}
+    void run()
+    {
+        const Settings& settings = m_simulator->m_settings;
+        MineField field;
+        field.setUseQuestionMarks(false);
+        field.setGenerationMode(settings.mode);
+        // games are played by the solver anyway
+        field.setEstimateGuesses(false);
+        MineSolver solver(&field);
+        solver.setMaxComponentSize(STRATEGIES[settings.strategy].maxComponentSize);
+        MineProbability probability(&field);
+        QVector<Result> results;
+        results.reserve(CHUNK_SIZE);
+        forever
+        {
+            int chunk;
+            {
+                QMutexLocker locker(&m_simulator->m_mutex);
+                while(m_simulator->m_nextChunk < m_simulator->m_chunkCount
+                      && m_simulator->m_nextChunk >= m_simulator->m_takenChunks + m_simulator->m_chunks.size())
+                    m_simulator->m_wakeWorkers.wait(&m_simulator->m_mutex);
+                if(m_simulator->m_nextChunk >= m_simulator->m_chunkCount)
+                    return;
+                chunk = m_simulator->m_nextChunk++;
+            }
+
+            results.resize(0);
+            const int first = chunk*CHUNK_SIZE;
+            const int last = qMin(first + CHUNK_SIZE, settings.count);
+            for(int i=first; i<last; ++i)
+                results.append(play(&field, &solver, &probability, settings, settings.firstSeed + i));
+
+            QMutexLocker locker(&m_simulator->m_mutex);
+            const int slot = chunk % m_simulator->m_chunks.size();
+            m_simulator->m_chunks[slot].swap(results);
+            m_simulator->m_chunkReady[slot] = 1;
+            m_simulator->m_chunkDone.wakeAll();
+        }
+    }
+private:
+    GameSimulator* m_simulator;
+};
+
+GameSimulator::GameSimulator(const Settings& settings)
+    : m_settings(settings), m_chunkCount(0), m_nextChunk(0), m_takenChunks(0)
+{
+}
+
+GameSimulator::~GameSimulator()
+{
+    {
+        // don't start any more chunks
+        QMutexLocker locker(&m_mutex);
+        m_chunkCount = m_nextChunk;
+        m_wakeWorkers.wakeAll();
+    }
+    m_pool.waitForDone();
+}
+
+void GameSimulator::start()
+{
+    m_chunkCount = (qMax(0, m_settings.count) + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    const int numWorkers = qBound(1, QThread::idealThreadCount(), qMax(1, m_chunkCount));
+    m_chunks.fill(QVector<Result>(), numWorkers*CHUNKS_AHEAD);
+    m_chunkReady.fill(0, m_chunks.size());
+    m_pool.setMaxThreadCount(numWorkers);
+    for(int i=0; i<numWorkers; ++i)
+        m_pool.start(new Worker(this));
+}
+
+bool GameSimulator::takeResults(QVector<Result>* results)
+{
+    QMutexLocker locker(&m_mutex);
+    if(m_takenChunks >= m_chunkCount)
+        return false;
+    const int slot = m_takenChunks % m_chunks.size();
+    while(!m_chunkReady.at(slot))
+        m_chunkDone.wait(&m_mutex);
+    results->swap(m_chunks[slot]);
+    m_chunkReady[slot] = 0;
+    m_takenChunks++;
+    m_wakeWorkers.wakeAll();
+    return true;
+}
+
+GameSimulator::Result GameSimulator::play(MineField* field, MineSolver* solver, MineProbability* probability,
+                                          const Settings& settings, quint64 seed)
+{
+    QElapsedTimer timer;
+    timer.start();
+    field->setSeed(seed);
+    field->newGame(settings.rows, settings.cols, settings.mines);
+    solver->reset();
+    probability->reset();
+
+    Result result;
+    result.seed = seed;
+    result.guesses = 0;
+    field->reveal(field->indexOf(settings.rows/2, settings.cols/2));
+    const qint64 firstClickTime = timer.nsecsElapsed();
+    const Guessing guessing = STRATEGIES[settings.strategy].guessing;
+    CounterRandom random(seed, GUESS_STREAM);
+    while(!field->isGameOver())
+    {
+        if(solver->solve() || field->isGameOver())
+            break;
+
+        // stuck, guess
+        const int unknownCount = field->unrevealedCount() - solver->knownMinesCount();
+        if(unknownCount <= 0)
+            break;
+        if(guessing == SafestCell)
+            probability->update();
+        int rank = guessing == RandomCell ? random.bounded(unknownCount) : 0;
+        int best = -1;
+        for(int idx=0; idx<field->cellCount(); ++idx)
+        {
+            if(field->isRevealed(idx) || solver->isKnownMine(idx))
+                continue;
+            if(guessing == RandomCell)
+            {
+                if(rank-- == 0)
+                {
+                    best = idx;
+                    break;
+                }
+            }
+            else if(best == -1 || probability->probability(idx) < probability->probability(best))
+                best = idx;
+        }
+        field->reveal(best);
+        result.guesses++;
+    }
+    const qint64 elapsed = timer.nsecsElapsed();
+    result.micros = elapsed / 1000;
+    result.decisionMicros = (elapsed - firstClickTime) / 1000;
+    result.won = field->isWon();
+    result.clicks = 1 + solver->revealCount() + result.guesses;
+    result.boardValue = field->metrics().boardValue;
+    return result;
+}
+
+int GameSimulator::findStrategy(const QString& name)
+{
+    for(int i=0; i<STRATEGY_COUNT; ++i)
+    {
+        if(name == QLatin1String(STRATEGIES[i].name))
+            return i;
+    }
+    return -1;
+}
@@ -0,0 +1,182 @@
+/*
+    Copyright 2026 The KMines Authors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#ifndef GAMESIMULATOR_H
+#define GAMESIMULATOR_H
+
+#include <QVector>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QThreadPool>
+#include <QString>
+
+#include "minefield.h"
+
+class MineSolver;
+class MineProbability;
+
+/**
+ * Plays many games without any GUI to measure how hard a kind of field
+ * is. Every game is opened in the center and played by MineSolver. When
+ * the solver is stuck, a cell chosen by the strategy is revealed, which
+ * counts as a guess. Built-in strategies are listed in STRATEGIES.
+ *
+ * Games are split into chunks of consecutive seeds which worker threads
+ * take one by one, every worker reusing its own field and solver.
+ * Results are handed out in the order of seeds while the rest is still
+ * being played, workers stay at most a few chunks ahead of the reader.
+ */
+class GameSimulator
+{
+public:
+    /**
+     * How a cell is chosen when the solver is stuck
+     */
+    enum Guessing
+    {
+        /// the cell least likely to hold mine according to MineProbability
+        SafestCell,
+        /// any unknown cell, random numbers come from the seed of the game
+        RandomCell
+    };
+    /**
+     * Way of playing
+     */
+    struct Strategy
+    {
+        const char* name;
+        const char* description;
+        /**
+         * See MineSolver::setMaxComponentSize(), 0 leaves
+         * the solver with single cell and pair rules only
+         */
+        int maxComponentSize;
+        Guessing guessing;
+    };
+    /**
+     * What to play
+     */
+    struct Settings
+    {
+        int rows;
+        int cols;
+        int mines;
+        MineField::GenerationMode mode;
+        /**
+         * Seed of the first game, the others take the next ones.
+         * Must not be 0, which would mean a random seed
+         */
+        quint64 firstSeed;
+        int count;
+        /**
+         * Index in STRATEGIES
+         */
+        int strategy;
+    };
+    /**
+     * Outcome of a single game
+     */
+    struct Result
+    {
+        quint64 seed;
+        bool won;
+        /**
+         * Number of revealed cells, including the first click and guesses
+         */
+        int clicks;
+        /**
+         * Number of cells revealed without proof that they are safe
+         */
+        int guesses;
+        /**
+         * 3BV of the field: minimal number of clicks which clear it
+         */
+        int boardValue;
+        /**
+         * Time spent by generating and playing the field
+         */
+        qint64 micros;
+        /**
+         * Part of micros after the first click, i.e. time the strategy
+         * needed to make all the other clicks
+         */
+        qint64 decisionMicros;
+    };
+
+    /**
+     * Constructor. Doesn't start anything until start() is called
+     */
+    explicit GameSimulator(const Settings& settings);
+    /**
+     * Stops workers which still play and waits for them
+     */
+    ~GameSimulator();
+    /**
+     * Starts workers on all cores
+     */
+    void start();
+    /**
+     * Waits until the next chunk of games is played
+     *
+     * @param results replaced by results of the chunk, in the order of seeds
+     * @return false if all games have been taken already
+     */
+    bool takeResults(QVector<Result>* results);
+
+    /**
+     * Plays a single game on given field
+     */
+    static Result play(MineField* field, MineSolver* solver, MineProbability* probability,
+                       const Settings& settings, quint64 seed);
+    /**
+     * @return index of strategy of given name in STRATEGIES, -1 if there's none
+     */
+    static int findStrategy(const QString& name);
+
+    /**
+     * Built-in strategies, the first one is the default
+     */
+    static const Strategy STRATEGIES[];
+    static const int STRATEGY_COUNT;
+
+    /**
+     * Number of games in a chunk
+     */
+    static const int CHUNK_SIZE = 256;
+    /**
+     * Bigger boards aren't simulated, every worker allocates one
+     */
+    static const int MAX_FIELD_SIDE = 2000;
+private:
+    class Worker;
+
+    Settings m_settings;
+    QMutex m_mutex;
+    QWaitCondition m_chunkDone;
+    QWaitCondition m_wakeWorkers;
+    /**
+     * Results of chunks not taken yet, chunk i is at i % m_chunks.size()
+     */
+    QVector<QVector<Result> > m_chunks;
+    QVector<quint8> m_chunkReady;
+    int m_chunkCount;
+    int m_nextChunk;
+    int m_takenChunks;
+    QThreadPool m_pool;
+};
+
+#endif
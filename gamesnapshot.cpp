@@ -0,0 +1,254 @@
+/*
+    Copyright 2026 The KMines Authors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#include "gamesnapshot.h"
+
+#include <climits>
+#include <cstddef>
+#include <cstring>
+#include "minefield.h"
+
+namespace
+{
+const char MAGIC[4] = { 'K', 'M', 'S', 'N' };
+const quint32 VERSION = 1;
+/**
+ * Reads differently on a machine of the other byte order
+ */
+const quint32 BYTE_ORDER_MARK = 0x01020304;
+/**
+ * Bigger fields are taken for a broken file
+ */
+const int MAX_FIELD_SIDE = 1 << 15;
+
+/**
+ * Longest level key kept in the header
+ */
+const int LEVEL_SIZE = 16;
+/**
+ * Bits of Header::flags
+ */
+const quint32 BOT_PLAYED = 1;
+
+/**
+ * Start of the file, GameSnapshot::HEADER_SIZE bytes. Snapshots written
+ * before level and flags were added have them zero: no level, no bot
+ */
+struct Header
+{
+    char magic[4];
+    quint32 byteOrder;
+    quint32 version;
+    qint32 rows;
+    qint32 cols;
+    qint32 mines;
+    quint64 seed;
+    qint32 seconds;
+    qint32 planeWords;
+    qint32 replaySize;
+    char level[LEVEL_SIZE];
+    quint32 flags;
+};
+}
+
+Q_STATIC_ASSERT(sizeof(Header) == GameSnapshot::HEADER_SIZE);
+
+GameSnapshot::GameSnapshot()
+    : m_planeWords(0), m_replaySize(0), m_botPlayed(false)
+{
+}
+
+void GameSnapshot::setFileName(const QString& fileName)
+{
+    m_file.close();
+    m_file.setFileName(fileName);
+}
+
+qint64 GameSnapshot::wordOffset(int plane, int word) const
+{
+    return HEADER_SIZE + (qint64(plane) * m_planeWords + word) * sizeof(quint64);
+}
+
+bool GameSnapshot::create(const MineField& field, const QByteArray& replay)
+{
+    m_file.close();
+    if(m_file.fileName().isEmpty() || !m_file.open(QIODevice::ReadWrite | QIODevice::Truncate))
+        return false;
+
+    Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.byteOrder = BYTE_ORDER_MARK;
+    header.version = VERSION;
+    header.rows = field.rowCount();
+    header.cols = field.columnCount();
+    header.mines = field.minesCount();
+    header.seed = field.seed();
+    header.planeWords = field.planeWordCount();
+    header.replaySize = replay.size();
+    memcpy(header.level, m_level.constData(), m_level.size());
+    header.flags = m_botPlayed ? BOT_PLAYED : 0;
+    m_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    m_planeWords = field.planeWordCount();
+    for(int plane=0; plane<MineField::PLANE_COUNT; ++plane)
+        writeWords(field, plane, 0, m_planeWords);
+    m_file.write(replay);
+    m_replaySize = replay.size();
+
+    if(!m_file.flush())
+    {
+        discard();
+        return false;
+    }
+    return true;
+}
+
+void GameSnapshot::writeWords(const MineField& field, int plane, int first, int count)
+{
+    const quint64* words = field.planeData(static_cast<MineField::Plane>(plane));
+    m_file.seek(wordOffset(plane, first));
+    m_file.write(reinterpret_cast<const char*>(words + first), count * sizeof(quint64));
+}
+
+void GameSnapshot::writeReplay(const QByteArray& replay)
+{
+    if(replay.size() <= m_replaySize)
+        return;
+    // the bytes first and their size last, so that a broken
+    // write leaves the old log valid
+    m_file.seek(wordOffset(MineField::PLANE_COUNT, 0) + m_replaySize);
+    m_file.write(replay.constData() + m_replaySize, replay.size() - m_replaySize);
+    m_replaySize = replay.size();
+    const qint32 size = m_replaySize;
+    m_file.seek(offsetof(Header, replaySize));
+    m_file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+}
+
+void GameSnapshot::update(const MineField& field, const QVector<int>& changedCells, const QByteArray& replay)
+{
+    if(!isOpen())
+        return;
+    // changes of a move are close to each other, so the
+    // span of words holding them is written at once
+    int first = INT_MAX;
+    int last = -1;
+    foreach(int idx, changedCells)
+    {
+        const int word = field.planeWordOf(idx);
+        first = qMin(first, word);
+        last = qMax(last, word);
+    }
+    // the log before the planes. if writing stops between them, the
+    // restored field lacks a move the log already has, instead of
+    // showing a move the log lost
+    writeReplay(replay);
+    // mines don't change once the game has started
+    if(last != -1)
+    {
+        for(int plane=MineField::RevealedPlane; plane<MineField::PLANE_COUNT; ++plane)
+            writeWords(field, plane, first, last - first + 1);
+    }
+    m_file.flush();
+}
+
+void GameSnapshot::setSeconds(int seconds)
+{
+    if(!isOpen())
+        return;
+    const qint32 value = seconds;
+    m_file.seek(offsetof(Header, seconds));
+    m_file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    m_file.flush();
+}
+
+void GameSnapshot::setLevel(const QByteArray& level)
+{
+    m_level = level.left(LEVEL_SIZE);
+    if(!isOpen())
+        return;
+    char value[LEVEL_SIZE];
+    memset(value, 0, sizeof(value));
+    memcpy(value, m_level.constData(), m_level.size());
+    m_file.seek(offsetof(Header, level));
+    m_file.write(value, sizeof(value));
+    m_file.flush();
+}
+
+void GameSnapshot::setBotPlayed(bool played)
+{
+    m_botPlayed = played;
+    if(!isOpen())
+        return;
+    const quint32 value = played ? BOT_PLAYED : 0;
+    m_file.seek(offsetof(Header, flags));
+    m_file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    m_file.flush();
+}
+
+void GameSnapshot::discard()
+{
+    m_file.close();
+    if(!m_file.fileName().isEmpty())
+        m_file.remove();
+}
+
+bool GameSnapshot::restore(MineField* field, QByteArray* replay, int* seconds)
+{
+    m_file.close();
+    QFile file(m_file.fileName());
+    if(file.fileName().isEmpty() || !file.open(QIODevice::ReadOnly) || file.size() < HEADER_SIZE)
+        return false;
+    const qint64 size = file.size();
+    const uchar* data = file.map(0, size);
+    if(!data)
+        return false;
+
+    Header header;
+    memcpy(&header, data, sizeof(header));
+    bool valid = memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0 && header.byteOrder == BYTE_ORDER_MARK
+                 && header.version == VERSION && header.rows > 0 && header.cols > 0
+                 && header.rows <= MAX_FIELD_SIDE && header.cols <= MAX_FIELD_SIDE
+                 && header.planeWords == MineField::planeWordCountFor(header.rows, header.cols)
+                 && header.seconds >= 0 && header.replaySize >= 0;
+    const qint64 planesSize = qint64(MineField::PLANE_COUNT) * header.planeWords * sizeof(quint64);
+    valid = valid && HEADER_SIZE + planesSize + header.replaySize <= size;
+    if(valid)
+    {
+        // planes are used right from the mapped file
+        const quint64* words = reinterpret_cast<const quint64*>(data + HEADER_SIZE);
+        const quint64* planes[MineField::PLANE_COUNT];
+        for(int plane=0; plane<MineField::PLANE_COUNT; ++plane)
+            planes[plane] = words + qint64(plane) * header.planeWords;
+        valid = field->restoreGame(header.rows, header.cols, header.mines, header.seed, planes);
+    }
+    if(valid)
+    {
+        *replay = QByteArray(reinterpret_cast<const char*>(data + HEADER_SIZE + planesSize), header.replaySize);
+        *seconds = header.seconds;
+        m_level = QByteArray(header.level, qstrnlen(header.level, LEVEL_SIZE));
+        m_botPlayed = header.flags & BOT_PLAYED;
+    }
+    file.unmap(const_cast<uchar*>(data));
+    file.close();
+    if(!valid || !m_file.open(QIODevice::ReadWrite))
+        return false;
+
+    m_planeWords = header.planeWords;
+    m_replaySize = header.replaySize;
+    return true;
+}
@@ -0,0 +1,137 @@
+/*
+    Copyright 2026 The KMines Authors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#ifndef GAMESNAPSHOT_H
+#define GAMESNAPSHOT_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <QVector>
+
+class MineField;
+
+/**
+ * Keeps a game in progress in a file, so that it can be continued after
+ * kmines is closed.
+ *
+ * The file holds a fixed header (size, seed and mines of the field,
+ * seconds on the game clock, level and whether a bot played), the planes of MineField::planeData() as
+ * they are in memory, and the replay log of the game. It is written as
+ * a whole once, on the first move. Each following move only rewrites
+ * the words of the planes it changed and appends what was added to the
+ * log, so even huge fields cost a few small writes per move.
+ *
+ * restore() maps the file into memory and gives the planes to
+ * MineField::restoreGame() without parsing anything. Numbers are kept
+ * in the byte order of the machine, a snapshot written elsewhere
+ * isn't restored.
+ */
+class GameSnapshot
+{
+public:
+    GameSnapshot();
+    /**
+     * Sets file of the snapshot, closes the current one
+     */
+    void setFileName(const QString& fileName);
+    /**
+     * @return whether a game is being written
+     */
+    bool isOpen() const { return m_file.isOpen(); }
+    /**
+     * Writes the whole game
+     *
+     * @param replay log of the game so far
+     * @return false if the file couldn't be written
+     */
+    bool create(const MineField& field, const QByteArray& replay);
+    /**
+     * Writes what the last move changed
+     *
+     * @param changedCells cells changed since the last create() or update()
+     * @param replay log of the game so far, which starts
+     * with the log given last time
+     */
+    void update(const MineField& field, const QVector<int>& changedCells, const QByteArray& replay);
+    /**
+     * Stores time on the game clock
+     */
+    void setSeconds(int seconds);
+    /**
+     * Stores key of the level the game is played at, whose highscores
+     * it may enter. Empty for games of no level, longer keys are cut
+     */
+    void setLevel(const QByteArray& level);
+    /**
+     * Stores that a bot made a move in the game
+     */
+    void setBotPlayed(bool played);
+    /**
+     * @return level given to setLevel() or read by restore()
+     */
+    QByteArray level() const { return m_level; }
+    /**
+     * @return whether a bot played, as given to setBotPlayed() or read by restore()
+     */
+    bool isBotPlayed() const { return m_botPlayed; }
+    /**
+     * Closes and removes the file, the game can't be continued anymore
+     */
+    void discard();
+    /**
+     * Continues the game from the file and keeps writing it
+     *
+     * @param field field to continue the game in
+     * @param replay log of the game
+     * @param seconds time on the game clock
+     * @return false if there's no valid snapshot
+     */
+    bool restore(MineField* field, QByteArray* replay, int* seconds);
+
+    /**
+     * Size of the header, planes start after it
+     */
+    static const int HEADER_SIZE = 64;
+private:
+    /**
+     * @return offset of given word of given plane in the file
+     */
+    qint64 wordOffset(int plane, int word) const;
+    /**
+     * Writes count words of the plane starting at word first
+     */
+    void writeWords(const MineField& field, int plane, int first, int count);
+    /**
+     * Appends part of replay which isn't in the file yet
+     */
+    void writeReplay(const QByteArray& replay);
+
+    QFile m_file;
+    /**
+     * Number of words of every plane of the open snapshot
+     */
+    int m_planeWords;
+    /**
+     * Number of log bytes in the file
+     */
+    int m_replaySize;
+    QByteArray m_level;
+    bool m_botPlayed;
+};
+
+#endif
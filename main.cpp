@@ -26,6 +26,8 @@
 #include <KSharedConfig>
 #include "version.h"
 #include "mainwindow.h"
+#include "scene.h"
+#include "batchmodes.h"
 
 
 static const char *DESCRIPTION
@@ -33,6 +35,11 @@ static const char *DESCRIPTION
 
 int main(int argc, char **argv)
 {
+    KMinesView::startupClock().start();
+    // batch modes don't need a display
+    if(BatchModes::isRequested(argc, argv))
+        return BatchModes::run(argc, argv);
+
     QApplication app(argc, argv);
 
     Kdelibs4ConfigMigrator migrate(QLatin1String("kmines"));
@@ -70,15 +77,21 @@ int main(int argc, char **argv)
     parser.addVersionOption();
     parser.addHelpOption();
     aboutData.setupCommandLine(&parser);
+    // batch modes are handled above, they are only listed in --help here
+    BatchModes::addOptions(&parser);
     parser.process(app);
     aboutData.processCommandLine(&parser);
     KDBusService service; 
     
+    // the window continues the game left in progress by itself
     if ( app.isSessionRestored() )
         RESTORE(KMinesMainWindow)
     else {
         KMinesMainWindow *mw = new KMinesMainWindow;
         mw->show();
+        if(parser.isSet(QStringLiteral("bot-socket"))
+           && !mw->listenForBots(parser.value(QStringLiteral("bot-socket"))))
+            qWarning("Bots can't connect: the socket can't be created");
     }
     
     return app.exec();
@@ -17,7 +17,10 @@
     Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 */
 #include "mainwindow.h"
+#include "boardgenerator.h"
+#include "boardshape.h"
 #include "minefielditem.h"
+#include "replayrecorder.h"
 #include "scene.h"
 #include "settings.h"
 
@@ -32,7 +35,18 @@
 #include <KMessageBox>
 
 #include <QStatusBar>
+#include <QDateTime>
+#include <QDir>
+#include <QDoubleSpinBox>
+#include <QFile>
+#include <QFileDialog>
+#include <QImage>
+#include <QSlider>
+#include <QTime>
+#include <QTimer>
+#include <QStandardPaths>
 #include <QDesktopWidget>
+#include <QValidator>
 
 #include "ui_customgame.h"
 #include "ui_generalopts.h"
@@ -40,15 +54,44 @@
 /*
  * Classes for config dlg pages
  */
+
+/**
+ * Accepts unsigned 64-bit numbers, or nothing for a random seed
+ */
+class SeedValidator : public QValidator
+{
+public:
+    explicit SeedValidator(QObject* parent)
+        : QValidator(parent) {}
+
+    virtual State validate(QString& input, int& pos) const
+    {
+        Q_UNUSED(pos);
+        if(input.isEmpty())
+            return Acceptable;
+        for(int i=0; i<input.size(); ++i)
+        {
+            if(!input.at(i).isDigit())
+                return Invalid;
+        }
+        // bigger numbers would silently turn into a random seed
+        bool ok = false;
+        input.toULongLong(&ok);
+        return ok ? Acceptable : Invalid;
+    }
+};
+
 class CustomGameConfig : public QWidget
 {
     Q_OBJECT
 
 public:
-    CustomGameConfig(QWidget *parent)
+    CustomGameConfig(QWidget *parent, quint64 currentSeed)
         : QWidget(parent)
     {
         ui.setupUi(this);
+        ui.kcfg_CustomSeed->setValidator(new SeedValidator(this));
+        ui.currentSeed->setText(QString::number(currentSeed));
         connect(ui.kcfg_CustomWidth, SIGNAL(valueChanged(int)), this, SLOT(updateMaxMines()));
         connect(ui.kcfg_CustomHeight, SIGNAL(valueChanged(int)), this, SLOT(updateMaxMines()));
     }
@@ -84,12 +127,19 @@ private:
  */
 
 KMinesMainWindow::KMinesMainWindow()
+    : m_waitingForBoard(false), m_replayPosition(0),
+      m_botServer(0), m_botCommand(false), m_botPlayed(false)
 {
     m_scene = new KMinesScene(this);
+    m_generator = new BoardGenerator(this);
+    connect(m_generator, &BoardGenerator::boardReady, this, &KMinesMainWindow::onBoardReady);
+    connect(m_generator, &BoardGenerator::requestReady, this, &KMinesMainWindow::onRequestedBoardReady);
     
     connect(m_scene, &KMinesScene::minesCountChanged, this, &KMinesMainWindow::onMinesCountChanged);
     connect(m_scene, &KMinesScene::gameOver, this, &KMinesMainWindow::onGameOver);
     connect(m_scene, &KMinesScene::firstClickDone, this, &KMinesMainWindow::onFirstClick);
+    connect(m_scene, &KMinesScene::cellsChanged, this, &KMinesMainWindow::onCellsChanged);
+    connect(m_scene, &KMinesScene::boardRequested, this, &KMinesMainWindow::onBoardRequested);
 
     m_view = new KMinesView( m_scene, this );
     m_view->setCacheMode( QGraphicsView::CacheBackground );
@@ -108,22 +158,51 @@ KMinesMainWindow::KMinesMainWindow()
     mineLabel->setText(i18n("Mines: 0/0"));
     timeLabel->setText(i18n("Time: 00:00"));
     
+    // playback controls are only shown while a replay is played
+    m_replayTimer = new QTimer(this);
+    m_replayTimer->setInterval(16);
+    connect(m_replayTimer, &QTimer::timeout, this, &KMinesMainWindow::advanceReplay);
+    m_replaySlider = new QSlider(Qt::Horizontal);
+    m_replaySlider->hide();
+    connect(m_replaySlider, &QSlider::valueChanged, this, &KMinesMainWindow::seekReplay);
+    m_replaySpeed = new QDoubleSpinBox;
+    m_replaySpeed->setRange(0.1, 1000);
+    m_replaySpeed->setValue(1);
+    m_replaySpeed->setSuffix(QStringLiteral("\u00d7"));
+    m_replaySpeed->setToolTip(i18n("Playback speed"));
+    m_replaySpeed->hide();
+
+    statusBar()->addWidget( m_replaySlider, 1 );
+    statusBar()->addWidget( m_replaySpeed );
     statusBar()->insertPermanentWidget( 0, mineLabel );
     statusBar()->insertPermanentWidget( 1, timeLabel );
     setCentralWidget(m_view);
     setupActions();
 
-    newGame();
+    m_scene->setSnapshotFile(snapshotFileName());
+    if(!restoreGame())
+        newGame();
 }
 
 void KMinesMainWindow::setupActions()
 {
     KStandardGameAction::gameNew(this, SLOT(newGame()), actionCollection());
     KStandardGameAction::highscores(this, SLOT(showHighscores()), actionCollection());
+    QAction* loadAction = KStandardGameAction::load(this, SLOT(openReplay()), actionCollection());
+    loadAction->setText(i18n("&Load Replay..."));
+    QAction* shapeAction = actionCollection()->addAction(QStringLiteral("game_play_shape"));
+    shapeAction->setText(i18n("Play &Shape..."));
+    connect(shapeAction, &QAction::triggered, this, &KMinesMainWindow::openShape);
 
     KStandardGameAction::quit(this, SLOT(close()), actionCollection());
     KStandardAction::preferences( this, SLOT(configureSettings()), actionCollection() );
+    KStandardAction::zoomIn( m_view, SLOT(zoomIn()), actionCollection() );
+    KStandardAction::zoomOut( m_view, SLOT(zoomOut()), actionCollection() );
+    KStandardAction::fitToPage( m_view, SLOT(zoomToFit()), actionCollection() );
     m_actionPause = KStandardGameAction::pause( this, SLOT(pauseGame(bool)), actionCollection() );
+    QAction* hintAction = KStandardGameAction::hint( 0, 0, actionCollection() );
+    hintAction->setCheckable(true);
+    connect(hintAction, &QAction::toggled, this, &KMinesMainWindow::showHints);
 
     Kg::difficulty()->addStandardLevelRange(
         KgDifficultyLevel::Easy, KgDifficultyLevel::Hard
@@ -131,20 +210,34 @@ void KMinesMainWindow::setupActions()
     Kg::difficulty()->addLevel(new KgDifficultyLevel(1000,
         QByteArray( "Custom" ), i18n( "Custom" )
     ));
+    Kg::difficulty()->addLevel(new KgDifficultyLevel(2000,
+        QByteArray( "Endless" ), i18n( "Endless" )
+    ));
+    Kg::difficulty()->addLevel(new KgDifficultyLevel(3000,
+        QByteArray( "Flower" ), i18n( "Flower" )
+    ));
+    Kg::difficulty()->addLevel(new KgDifficultyLevel(3001,
+        QByteArray( "Star" ), i18n( "Star" )
+    ));
     KgDifficultyGUI::init(this);
-    connect(Kg::difficulty(), SIGNAL(currentLevelChanged(const KgDifficultyLevel*)), SLOT(newGame()));
+    connect(Kg::difficulty(), SIGNAL(currentLevelChanged(const KgDifficultyLevel*)), SLOT(onLevelChanged()));
 
     setupGUI(qApp->desktop()->availableGeometry().size()*0.4);
 }
 
 void KMinesMainWindow::onMinesCountChanged(int count)
 {
-    mineLabel->setText(i18n("Mines: %1/%2", count, m_scene->totalMines()));
+    // there's no total in the endless mode
+    if(m_scene->isEndless())
+        mineLabel->setText(i18n("Flags: %1", count));
+    else
+        mineLabel->setText(i18n("Mines: %1/%2", count, m_scene->totalMines()));
 }
 
-void KMinesMainWindow::newGame()
+void KMinesMainWindow::prepareNewGame()
 {
-    qDebug() << "Inside game";
+    stopReplay();
+    cancelBoardRequest();
     m_gameClock->restart();
     m_gameClock->pause(); // start only with the 1st click
 
@@ -157,27 +250,102 @@ void KMinesMainWindow::newGame()
     m_actionPause->setEnabled(false);
 
     Kg::difficulty()->setGameRunning(false);
+    timeLabel->setText(i18n("Time: 00:00"));
+    m_botPlayed = false;
+}
+
+void KMinesMainWindow::newGame()
+{
+    qDebug() << "Inside game";
+    prepareNewGame();
+    // shapes chosen by the player come first,
+    // shaped levels are installed with the game
+    const QByteArray level = Kg::difficulty()->currentLevel()->key();
+    if(!m_shapeFile.isEmpty() || level == "Flower" || level == "Star")
+    {
+        m_generator->stop();
+        m_waitingForBoard = false;
+        QString fileName = m_shapeFile;
+        // density of the Medium level, the star is as dense as Hard
+        double density = 40.0 / (16*16);
+        if(fileName.isEmpty())
+        {
+            fileName = QStandardPaths::locate(QStandardPaths::DataLocation,
+                                              QStringLiteral("shapes/%1.txt").arg(QString::fromLatin1(level.toLower())));
+            if(level == "Star")
+                density = 99.0 / (16*30);
+        }
+        if(!startShapedGame(fileName, density))
+            KMessageBox::sorry(this, i18n("The board shape %1 could not be loaded.",
+                                          fileName.isEmpty() ? QString::fromLatin1(level) : fileName));
+        sendBoardToBot();
+        return;
+    }
+
+    // endless level is reported as Custom
+    if(level == "Endless")
+    {
+        // density of the Medium level
+        m_generator->stop();
+        m_waitingForBoard = false;
+        m_scene->startEndlessGame(0, 40.0 / (16*16));
+        sendBoardToBot();
+        return;
+    }
+
+    int rows = 0, cols = 0, mines = 0;
+    quint64 seed = 0;
     switch(Kg::difficultyLevel())
     {
         case KgDifficultyLevel::Easy:
-            m_scene->startNewGame(9, 9, 10);
+            rows = 9; cols = 9; mines = 10;
             break;
         case KgDifficultyLevel::Medium:
-            m_scene->startNewGame(16,16,40);
+            rows = 16; cols = 16; mines = 40;
             break;
         case KgDifficultyLevel::Hard:
-            m_scene->startNewGame(16,30,99);
+            rows = 16; cols = 30; mines = 99;
             break;
         case KgDifficultyLevel::Custom:
-            m_scene->startNewGame(Settings::customHeight(),
-                                  Settings::customWidth(),
-                                  Settings::customMines());
+            rows = Settings::customHeight();
+            cols = Settings::customWidth();
+            mines = Settings::customMines();
+            // an empty or invalid seed gives 0, which is a random one
+            seed = Settings::customSeed().toULongLong();
+            break;
         default:
             //unsupported
-            break;
+            return;
     }
-    
-    timeLabel->setText(i18n("Time: 00:00"));
+    startRectangleGame(rows, cols, mines, seed);
+}
+
+void KMinesMainWindow::startRectangleGame(int rows, int cols, int mines, quint64 seed)
+{
+    m_scene->startNewGame(rows, cols, mines, seed);
+    // games which can't enter highscores keep no level
+    m_scene->setSnapshotLevel(m_botPlayed ? QByteArray() : Kg::difficulty()->currentLevel()->key());
+    m_scene->setSnapshotBotPlayed(m_botPlayed);
+
+    // "no guess" fields are prepared in background. if none is ready
+    // yet or the player starts elsewhere, the field of the clicked cell
+    // is generated in background too, see onBoardRequested(). a chosen
+    // seed makes the field generate itself from that seed
+    m_waitingForBoard = false;
+    if(Settings::noGuessGames() && seed == 0)
+    {
+        m_generator->setParameters(rows, cols, mines);
+        m_waitingForBoard = !applyGeneratedBoard();
+    }
+    else
+        m_generator->stop();
+    sendBoardToBot();
+}
+
+void KMinesMainWindow::onLevelChanged()
+{
+    m_shapeFile.clear();
+    newGame();
 }
 
 void KMinesMainWindow::onGameOver(bool won)
@@ -185,17 +353,29 @@ void KMinesMainWindow::onGameOver(bool won)
     m_gameClock->pause();
     m_actionPause->setEnabled(false);
     Kg::difficulty()->setGameRunning(false);
-    if(won)
+    m_scene->recordResult(won, m_gameClock->seconds());
+    saveReplay();
+    // shapes, from a file or of the Flower and Star levels,
+    // have no highscore tables of their own
+    if(won && !m_botPlayed && m_shapeFile.isEmpty() && !m_scene->isShaped())
     {
         QPointer<KScoreDialog> scoreDialog = new KScoreDialog(KScoreDialog::Name | KScoreDialog::Time, this);
         scoreDialog->initFromDifficulty(Kg::difficulty());
         scoreDialog->hideField(KScoreDialog::Score);
+        scoreDialog->addField(KScoreDialog::Custom1, i18n("3BV/s"), QStringLiteral("3bvps"));
 
         KScoreDialog::FieldInfo scoreInfo;
         // score-in-seconds will be hidden
         scoreInfo[KScoreDialog::Score].setNum(m_gameClock->seconds());
         //score-as-time will be shown
         scoreInfo[KScoreDialog::Time] = m_gameClock->timeString();
+        // clicks needed per second, comparing games on boards of different difficulty
+        const MineField* field = m_scene->field();
+        if(field)
+        {
+            const double speed = double(field->metrics().boardValue) / qMax(1, m_gameClock->seconds());
+            scoreInfo[KScoreDialog::Custom1] = QString::number(speed, 'f', 2);
+        }
 
         // we keep highscores as number of seconds
         if( scoreDialog->addScore(scoreInfo, KScoreDialog::LessIsMore) != 0 )
@@ -205,13 +385,310 @@ void KMinesMainWindow::onGameOver(bool won)
     }
 }
 
+QString KMinesMainWindow::replaysDirectory()
+{
+    const QString base = QStandardPaths::writableLocation(QStandardPaths::DataLocation);
+    if(base.isEmpty() || !QDir().mkpath(base + QLatin1String("/replays")))
+        return QString();
+    return base + QLatin1String("/replays");
+}
+
+QString KMinesMainWindow::snapshotFileName()
+{
+    const QString base = QStandardPaths::writableLocation(QStandardPaths::DataLocation);
+    if(base.isEmpty() || !QDir().mkpath(base))
+        return QString();
+    return base + QLatin1String("/current-game.kms");
+}
+
+bool KMinesMainWindow::restoreGame()
+{
+    int seconds = 0;
+    QByteArray level;
+    bool botPlayed = false;
+    if(!m_scene->restoreSnapshot(&seconds, &level, &botPlayed))
+        return false;
+    // the game only enters highscores of its own level
+    m_botPlayed = botPlayed || level.isEmpty() || level != Kg::difficulty()->currentLevel()->key();
+    cancelBoardRequest();
+    m_waitingForBoard = false;
+    m_gameClock->restart();
+    m_gameClock->pause();
+    m_gameClock->setTime(seconds);
+    timeLabel->setText(i18n("Time: %1", m_gameClock->timeString()));
+    Kg::difficulty()->setGameRunning(true);
+    // the player continues when ready
+    m_actionPause->setEnabled(true);
+    m_actionPause->setChecked(true);
+    m_scene->setGamePaused(true);
+    return true;
+}
+
+void KMinesMainWindow::saveReplay()
+{
+    // replays only know the size of the field, not its shape
+    if(m_scene->isShaped())
+        return;
+    const QString directory = replaysDirectory();
+    if(directory.isEmpty())
+        return;
+    const QString fileName = QStringLiteral("%1/%2-%3.kmr").arg(directory,
+                                 QDateTime::currentDateTime().toString(QStringLiteral("yyyyMMdd-hhmmss")),
+                                 QString::number(m_scene->seed()));
+    m_scene->replay().save(fileName);
+}
+
+void KMinesMainWindow::openReplay()
+{
+    const QString fileName = QFileDialog::getOpenFileName(this, i18n("Load Replay"), replaysDirectory(),
+                                                          i18n("KMines replays (*.kmr)"));
+    if(fileName.isEmpty())
+        return;
+    QFile file(fileName);
+    if(!file.open(QIODevice::ReadOnly) || !m_scene->loadReplay(file.readAll()))
+    {
+        KMessageBox::sorry(this, i18n("The file %1 is not a valid KMines replay.", fileName));
+        return;
+    }
+
+    // the game being played is dropped
+    cancelBoardRequest();
+    m_generator->stop();
+    m_waitingForBoard = false;
+    m_gameClock->restart();
+    m_gameClock->pause();
+    Kg::difficulty()->setGameRunning(false);
+    if(m_actionPause->isChecked())
+    {
+        m_scene->setGamePaused(false);
+        m_actionPause->setChecked(false);
+    }
+    // pause stops playback
+    m_actionPause->setEnabled(true);
+
+    m_replaySlider->blockSignals(true);
+    m_replaySlider->setRange(0, static_cast<int>(m_scene->replayDuration()));
+    m_replaySlider->setValue(0);
+    m_replaySlider->blockSignals(false);
+    m_replaySlider->show();
+    m_replaySpeed->show();
+    seekReplay(0);
+    m_replayClock.start();
+    m_replayTimer->start();
+    // nothing to play while a replay is shown
+    sendBoardToBot();
+}
+
+void KMinesMainWindow::openShape()
+{
+    const QString directory = QStandardPaths::locate(QStandardPaths::DataLocation, QStringLiteral("shapes"),
+                                                     QStandardPaths::LocateDirectory);
+    const QString fileName = QFileDialog::getOpenFileName(this, i18n("Play Shape"), directory,
+                                                          i18n("Board shapes (*.txt *.png)"));
+    if(fileName.isEmpty())
+        return;
+    BoardShape shape;
+    if(!loadShape(fileName, &shape))
+    {
+        KMessageBox::sorry(this, i18n("The file %1 is not a valid board shape.", fileName));
+        return;
+    }
+    m_shapeFile = fileName;
+    newGame();
+}
+
+bool KMinesMainWindow::loadShape(const QString& fileName, BoardShape* shape)
+{
+    BoardShape loaded;
+    if(fileName.endsWith(QLatin1String(".png"), Qt::CaseInsensitive))
+    {
+        QImage image;
+        if(!image.load(fileName) || image.width() > BoardShape::MAX_SIDE || image.height() > BoardShape::MAX_SIDE)
+            return false;
+        loaded = BoardShape(image.height(), image.width());
+        for(int row=0; row<image.height(); ++row)
+        {
+            for(int col=0; col<image.width(); ++col)
+            {
+                const QRgb pixel = image.pixel(col, row);
+                loaded.setCell(row, col, qAlpha(pixel) >= 128 && qGray(pixel) < 128);
+            }
+        }
+        loaded.trim();
+    }
+    else
+    {
+        QFile file(fileName);
+        if(!file.open(QIODevice::ReadOnly) || !loaded.loadText(file.readAll()))
+            return false;
+    }
+    // the first click needs some room
+    if(loaded.cellCount() <= MineField::MINIMAL_FREE)
+        return false;
+    *shape = loaded;
+    return true;
+}
+
+bool KMinesMainWindow::startShapedGame(const QString& fileName, double density)
+{
+    BoardShape shape;
+    if(fileName.isEmpty() || !loadShape(fileName, &shape))
+        return false;
+    m_scene->startNewGame(shape, qRound(shape.cellCount() * density), 0);
+    return true;
+}
+
+void KMinesMainWindow::stopReplay()
+{
+    m_replayTimer->stop();
+    m_replaySlider->hide();
+    m_replaySpeed->hide();
+}
+
+void KMinesMainWindow::advanceReplay()
+{
+    m_replayPosition += m_replayClock.restart() * m_replaySpeed->value();
+    const qint64 duration = m_scene->replayDuration();
+    if(m_replayPosition >= duration)
+    {
+        m_replayPosition = duration;
+        m_replayTimer->stop();
+        m_actionPause->setChecked(true);
+    }
+    m_scene->setReplayPosition(static_cast<qint64>(m_replayPosition));
+    timeLabel->setText(i18n("Time: %1", QTime(0, 0).addMSecs(static_cast<int>(m_replayPosition)).toString(QStringLiteral("mm:ss"))));
+    // fractions of milliseconds are kept in m_replayPosition
+    m_replaySlider->blockSignals(true);
+    m_replaySlider->setValue(static_cast<int>(m_replayPosition));
+    m_replaySlider->blockSignals(false);
+}
+
+void KMinesMainWindow::seekReplay(int time)
+{
+    m_replayPosition = time;
+    m_scene->setReplayPosition(time);
+    timeLabel->setText(i18n("Time: %1", QTime(0, 0).addMSecs(time).toString(QStringLiteral("mm:ss"))));
+}
+
 void KMinesMainWindow::advanceTime(const QString& timeStr)
 {
     timeLabel->setText(i18n("Time: %1", timeStr));
+    m_scene->setSnapshotSeconds(m_gameClock->seconds());
+}
+
+bool KMinesMainWindow::applyGeneratedBoard()
+{
+    BoardGenerator::Board board;
+    if(!m_generator->takeBoard(&board))
+        return false;
+    return m_scene->setPresetBoard(board.mineCells, board.startIdx, board.seed, board.noGuess);
+}
+
+bool KMinesMainWindow::listenForBots(const QString& name)
+{
+    if(!m_botServer)
+        m_botServer = new BotServer(this, this);
+    return m_botServer->listen(name);
+}
+
+const MineField* KMinesMainWindow::botField() const
+{
+    // bots address cells of a rectangle
+    return m_scene->isShaped() ? 0 : m_scene->field();
+}
+
+bool KMinesMainWindow::botMove(BotServer::Command command, int idx)
+{
+    ReplayRecorder::Action action;
+    switch(command)
+    {
+        case BotServer::Reveal:
+            action = ReplayRecorder::Reveal;
+            break;
+        case BotServer::Mark:
+            action = ReplayRecorder::Mark;
+            break;
+        case BotServer::Chord:
+            action = ReplayRecorder::Chord;
+            break;
+        default:
+            return false;
+    }
+    // set before the move, which may end the game
+    const bool wasPlayed = m_botPlayed;
+    m_botPlayed = true;
+    m_botCommand = true;
+    const bool accepted = m_scene->playMove(action, idx);
+    m_botCommand = false;
+    if(!accepted)
+        m_botPlayed = wasPlayed;
+    else
+        m_scene->setSnapshotBotPlayed(true);
+    return accepted;
+}
+
+bool KMinesMainWindow::isMovePending() const
+{
+    return m_scene->isWaitingForBoard();
+}
+
+void KMinesMainWindow::botNewGame(int rows, int cols, int mines, quint64 seed)
+{
+    m_botCommand = true;
+    prepareNewGame();
+    // the field the bot asked for isn't the level's, it has no highscores
+    m_botPlayed = true;
+    startRectangleGame(rows, cols, mines, seed);
+    m_botCommand = false;
+}
+
+void KMinesMainWindow::onCellsChanged(const QVector<int>& cells)
+{
+    if(m_botServer && !m_botCommand)
+        m_botServer->sendChanges(cells);
+}
+
+void KMinesMainWindow::sendBoardToBot()
+{
+    if(m_botServer && !m_botCommand)
+        m_botServer->sendBoard();
+}
+
+void KMinesMainWindow::onBoardReady()
+{
+    if(m_waitingForBoard)
+        m_waitingForBoard = !applyGeneratedBoard();
+}
+
+void KMinesMainWindow::onBoardRequested(int startIdx)
+{
+    const MineField* field = m_scene->field();
+    if(!field)
+        return;
+    // a prepared field for another cell is of no use anymore
+    m_waitingForBoard = false;
+    m_generator->requestBoard(*field, startIdx);
+    m_view->viewport()->setCursor(Qt::BusyCursor);
+}
+
+void KMinesMainWindow::onRequestedBoardReady()
+{
+    BoardGenerator::Board board;
+    if(!m_generator->takeRequestedBoard(&board))
+        return;
+    m_view->viewport()->unsetCursor();
+    m_scene->revealGeneratedBoard(board.mineCells, board.startIdx, board.noGuess);
+}
+
+void KMinesMainWindow::cancelBoardRequest()
+{
+    m_generator->cancelRequest();
+    m_view->viewport()->unsetCursor();
 }
 
 void KMinesMainWindow::onFirstClick()
 {
+    m_waitingForBoard = false;
     // enable pause action
     m_actionPause->setEnabled(true);
     // start clock
@@ -224,6 +701,7 @@ void KMinesMainWindow::showHighscores()
     QPointer<KScoreDialog> scoreDialog = new KScoreDialog(KScoreDialog::Name | KScoreDialog::Time, this);
     scoreDialog->initFromDifficulty(Kg::difficulty());
     scoreDialog->hideField(KScoreDialog::Score);
+    scoreDialog->addField(KScoreDialog::Custom1, i18n("3BV/s"), QStringLiteral("3bvps"));
     scoreDialog->exec();
     delete scoreDialog;
 }
@@ -233,17 +711,39 @@ void KMinesMainWindow::configureSettings()
     if ( KConfigDialog::showDialog( QLatin1String(  "settings" ) ) )
         return;
     KConfigDialog *dialog = new KConfigDialog( this, QLatin1String( "settings" ), Settings::self() );
+    // created again next time, so it shows the seed of the game played then
+    dialog->setAttribute( Qt::WA_DeleteOnClose );
     dialog->addPage( new GeneralOptsConfig( dialog ), i18n("General"), QLatin1String( "games-config-options" ));
     dialog->addPage( new KgThemeSelector( m_scene->renderer().themeProvider() ), i18n( "Theme" ), QLatin1String( "games-config-theme" ));
-    dialog->addPage( new CustomGameConfig( dialog ), i18n("Custom Game"), QLatin1String( "games-config-custom" ));
-    connect( m_scene->renderer().themeProvider(), SIGNAL(currentThemeChanged(const KgTheme*)), SLOT(loadSettings()) );
+    dialog->addPage( new CustomGameConfig( dialog, m_scene->seed() ), i18n("Custom Game"), QLatin1String( "games-config-custom" ));
+    connect( m_scene->renderer().themeProvider(), SIGNAL(currentThemeChanged(const KgTheme*)), SLOT(loadSettings()),
+             Qt::UniqueConnection );
     connect(dialog, &KConfigDialog::settingsChanged, this, &KMinesMainWindow::loadSettings);
     
     dialog->show();
 }
 
+void KMinesMainWindow::showHints(bool show)
+{
+    m_scene->setShowHints(show);
+}
+
 void KMinesMainWindow::pauseGame(bool paused)
 {
+    if(m_scene->isReplaying())
+    {
+        if(paused)
+            m_replayTimer->stop();
+        else
+        {
+            // play again from the start once the end is reached
+            if(m_replayPosition >= m_scene->replayDuration())
+                seekReplay(0);
+            m_replayClock.start();
+            m_replayTimer->start();
+        }
+        return;
+    }
     m_scene->setGamePaused( paused );
     if( paused )
         m_gameClock->pause();
@@ -255,8 +755,7 @@ void KMinesMainWindow::loadSettings()
 {
     m_view->resetCachedContent();
     // trigger complete redraw
-    m_scene->resizeScene( (int)m_scene->sceneRect().width(),
-                          (int)m_scene->sceneRect().height() );
+    m_scene->relayout();
 }
 
 #include "mainwindow.moc"
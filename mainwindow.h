@@ -22,20 +22,51 @@
 
 #include <QPointer>
 #include <QLabel>
+#include <QElapsedTimer>
+
+#include "botserver.h"
 
 class KMinesScene;
 class KMinesView;
 class KGameClock;
 class KToggleAction;
+class BoardGenerator;
+class QSlider;
+class QDoubleSpinBox;
+class QTimer;
+class BoardShape;
 
-class KMinesMainWindow : public KXmlGuiWindow
+class KMinesMainWindow : public KXmlGuiWindow, public BotServer::Game
 {
     Q_OBJECT
 public:
     KMinesMainWindow();
+    /**
+     * Lets bots play the game shown in the window over local socket
+     * of given name, see BotServer
+     *
+     * @return false if it isn't possible
+     */
+    bool listenForBots(const QString& name);
+    // reimplemented from BotServer::Game
+    const MineField* botField() const;
+    bool botMove(BotServer::Command command, int idx);
+    /**
+     * The first reveal waits while its field is generated in background
+     */
+    bool isMovePending() const;
+    /**
+     * Starts a game of the size and seed asked for by the bot,
+     * the level stays as it is
+     */
+    void botNewGame(int rows, int cols, int mines, quint64 seed);
 private slots:
     void onMinesCountChanged(int count);
     void newGame();
+    /**
+     * Starts a game of the newly chosen level
+     */
+    void onLevelChanged();
     void onGameOver(bool);
     void advanceTime(const QString&);
     void onFirstClick();
@@ -43,12 +74,137 @@ private slots:
     void configureSettings();
     void pauseGame(bool paused);
     void loadSettings();
+    void onBoardReady();
+    /**
+     * Has the field the player started on generated in background
+     */
+    void onBoardRequested(int startIdx);
+    /**
+     * Reveals the first cell once its field is generated
+     */
+    void onRequestedBoardReady();
+    void showHints(bool show);
+    /**
+     * Asks for a replay file and starts playing it
+     */
+    void openReplay();
+    /**
+     * Asks for a shape file and starts a game on a field of that shape,
+     * see loadShape(). New games keep the shape until the level changes
+     */
+    void openShape();
+    /**
+     * Moves playback on by the time since the last call
+     */
+    void advanceReplay();
+    /**
+     * Shows the replay at given time in milliseconds
+     */
+    void seekReplay(int time);
+    /**
+     * Tells the bot about moves made by the player
+     */
+    void onCellsChanged(const QVector<int>& cells);
 private:
     void setupActions();
+    /**
+     * Stops the clock, playback and pause of the game being left
+     */
+    void prepareNewGame();
+    /**
+     * Starts a rectangular game, "no guess" fields of a random seed
+     * are prepared in background
+     *
+     * @param seed seed of the field, 0 for a random one
+     */
+    void startRectangleGame(int rows, int cols, int mines, quint64 seed);
+    /**
+     * Writes log of the finished game to the replays directory
+     */
+    void saveReplay();
+    /**
+     * Reads shape of a field from a file. PNG images give a cell for every
+     * opaque dark pixel, other files are read by BoardShape::loadText()
+     *
+     * @return false if the file isn't a valid shape with enough cells
+     */
+    static bool loadShape(const QString& fileName, BoardShape* shape);
+    /**
+     * Starts a game on a field of the shape kept in given file,
+     * with mines of given density
+     *
+     * @return false if the file isn't a valid shape
+     */
+    bool startShapedGame(const QString& fileName, double density);
+    /**
+     * @return directory replays are saved to, empty if there's none
+     */
+    static QString replaysDirectory();
+    /**
+     * @return file the game in progress is kept in, empty if there's none
+     */
+    static QString snapshotFileName();
+    /**
+     * Continues the game left when kmines was closed, paused
+     * @return false if there was none
+     */
+    bool restoreGame();
+    /**
+     * Stops playback and hides its controls
+     */
+    void stopReplay();
+    /**
+     * Gives the current game a prepared field if one is ready
+     * @return false if there was none
+     */
+    bool applyGeneratedBoard();
+    /**
+     * Tells the bot that the game has changed, unless it asked for it
+     */
+    void sendBoardToBot();
+    /**
+     * Drops the field being generated for the first click
+     */
+    void cancelBoardRequest();
     KMinesScene* m_scene;
     KMinesView* m_view;
     KGameClock* m_gameClock;
     KToggleAction* m_actionPause;
+    /**
+     * Prepares fields for "no guess" games in background
+     */
+    BoardGenerator* m_generator;
+    /**
+     * True if the current game waits for a prepared field
+     */
+    bool m_waitingForBoard;
+    /**
+     * Playback of replays: position in milliseconds, advanced
+     * by the real time between timer ticks times the speed
+     */
+    QTimer* m_replayTimer;
+    QElapsedTimer m_replayClock;
+    qreal m_replayPosition;
+    QSlider* m_replaySlider;
+    QDoubleSpinBox* m_replaySpeed;
+    /**
+     * Server of bots, 0 unless listenForBots() was called
+     */
+    BotServer* m_botServer;
+    /**
+     * True while a command of the bot is carried out
+     */
+    bool m_botCommand;
+    /**
+     * True if the bot made a move in the current game or started it,
+     * or the game was continued from another level; such games
+     * don't get into highscores
+     */
+    bool m_botPlayed;
+    /**
+     * Shape chosen by openShape(), empty if the level is played
+     */
+    QString m_shapeFile;
     
     QPointer<QLabel> mineLabel = new QLabel;
     QPointer<QLabel> timeLabel = new QLabel;
@@ -0,0 +1,655 @@
+/*
+    Copyright 2007 Dmitry Suzdalev <dimsuz@gmail.com>
+    Copyright 2010 Brian Croom <brian.s.croom@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#include "minefield.h"
+
+#include "minesolver.h"
+
+MineField::MineField()
+    : m_rowWords(1), m_rowStride(64), m_explodedSlot(-1), m_numExcluded(0), m_presetStart(-1), m_presetSeed(0), m_presetNoGuess(false),
+      m_numRows(0), m_numCols(0), m_numCells(0), m_minesCount(0), m_flaggedCount(0),
+      m_numUnrevealed(0), m_fixedSeed(0), m_seed(0), m_firstAttempt(0), m_generationMode(RandomMines), m_estimateGuesses(true), m_firstClick(true), m_gameOver(false), m_won(false),
+      m_useQuestionMarks(true)
+{
+    for(int i=0; i<MAX_NEIGHBOURS; ++i)
+        m_neighbourOffsets[i] = 0;
+    m_metrics.openings = 0;
+    m_metrics.isolatedDigits = 0;
+    m_metrics.boardValue = 0;
+    m_metrics.guesses = -1;
+}
+
+void MineField::newGame( int numRows, int numCols, int numMines )
+{
+    setupGame(numRows, numCols, numRows*numCols, numMines, 0);
+}
+
+void MineField::newGame(const BoardShape& shape, int numMines)
+{
+    // a shape without holes needs no tables
+    setupGame(shape.rowCount(), shape.columnCount(), shape.cellCount(), numMines,
+              shape.isRectangle() ? 0 : &shape);
+}
+
+void MineField::setupGame(int numRows, int numCols, int numCells, int numMines, const BoardShape* shape)
+{
+    numMines = qMin(numMines, numCells - MINIMAL_FREE );
+
+    m_numRows = numRows;
+    m_numCols = numCols;
+    m_numCells = numCells;
+    // border columns of neighbouring rows share the padding
+    // at the end of a row, so there is at least one bit of it
+    m_rowWords = (numCols+2 + 63) / 64;
+    m_rowStride = m_rowWords*64;
+    m_minesCount = numMines;
+    m_flaggedCount = 0;
+    m_numUnrevealed = numCells;
+    m_explodedSlot = -1;
+    m_firstClick = true;
+    m_gameOver = false;
+    m_won = false;
+    m_presetMines.clear();
+    m_presetStart = -1;
+    m_seed = m_fixedSeed ? m_fixedSeed : CounterRandom::randomSeed();
+    m_metrics.openings = 0;
+    m_metrics.isolatedDigits = 0;
+    m_metrics.boardValue = 0;
+    m_metrics.guesses = -1;
+
+    // upper-left diagonal, upper, upper-right diagonal, on the left,
+    // on the right, bottom-left diagonal, bottom, bottom-right diagonal
+    const int offsets[MAX_NEIGHBOURS] = { -m_rowStride-1, -m_rowStride, -m_rowStride+1, -1,
+                                          1, m_rowStride-1, m_rowStride, m_rowStride+1 };
+    for(int i=0; i<MAX_NEIGHBOURS; ++i)
+        m_neighbourOffsets[i] = offsets[i];
+
+    // border rows, padding words at both ends of planes
+    // and one word on each side for countNeighbours()
+    const int planeWords = planeWordCountFor(numRows, numCols);
+    m_mines.fill(0, planeWords);
+    m_flagged.fill(0, planeWords);
+    m_questioned.fill(0, planeWords);
+    for(int k=0; k<BitPlanes::DIGIT_PLANES; ++k)
+        m_digits[k].fill(0, planeWords);
+
+    m_inside.fill(0, planeWords);
+    m_cellSlots.resize(0);
+    m_wordRanks.resize(0);
+    if(!shape)
+    {
+        // columns are at bits 1 to numCols of every row
+        for(int k=0; k<m_rowWords; ++k)
+        {
+            const int first = qMax(1, k*64) - k*64;
+            const int last = qMin(numCols, k*64 + 63) - k*64;
+            if(first > last)
+                continue;
+            const quint64 columns = (~quint64(0) >> (63 - last)) & (~quint64(0) << first);
+            for(int row=0; row<numRows; ++row)
+                m_inside[(row+1)*m_rowWords + 1 + k] = columns;
+        }
+    }
+    else
+    {
+        // cells are numbered in the order of their slots
+        m_cellSlots.reserve(numCells);
+        for(int row=0; row<numRows; ++row)
+        {
+            for(int col=0; col<numCols; ++col)
+            {
+                if(!shape->contains(row, col))
+                    continue;
+                const int slot = (row+1)*m_rowStride + col + 1;
+                setBit(m_inside, slot);
+                m_cellSlots.append(slot);
+            }
+        }
+        m_wordRanks.resize(planeWords);
+        int rank = 0;
+        for(int word=0; word<planeWords; ++word)
+        {
+            m_wordRanks[word] = rank;
+            rank += BitPlanes::bitCount(m_inside.at(word));
+        }
+    }
+
+    // everything outside of the field is revealed, so that
+    // the game never touches it
+    m_revealed.resize(planeWords);
+    for(int word=0; word<planeWords; ++word)
+        m_revealed[word] = ~m_inside.at(word);
+
+    // every cell is pushed to these at most once, so they
+    // will never have to grow during the game
+    const int reserved = qMin(numCells, int(MAX_RESERVED_CELLS));
+    m_changedCells.resize(0);
+    m_changedCells.reserve(reserved);
+    m_floodStack.resize(0);
+    m_floodStack.reserve(reserved);
+}
+
+const quint64* MineField::planeData(Plane plane) const
+{
+    switch(plane)
+    {
+        case MinePlane:
+            return m_mines.constData();
+        case RevealedPlane:
+            return m_revealed.constData();
+        case FlaggedPlane:
+            return m_flagged.constData();
+        case QuestionedPlane:
+            return m_questioned.constData();
+        default:
+            return 0;
+    }
+}
+
+bool MineField::restoreGame(int numRows, int numCols, int numMines, quint64 seed,
+                            const quint64* const planes[PLANE_COUNT])
+{
+    newGame(numRows, numCols, numMines);
+    bool valid = (m_minesCount == numMines);
+    int mines = 0, revealed = 0, flagged = 0;
+    for(int word=0; valid && word<m_mines.size(); ++word)
+    {
+        // newGame() has revealed everything outside of the field
+        const quint64 outside = m_revealed.at(word);
+        const quint64 open = planes[RevealedPlane][word] & ~outside;
+        m_mines[word] = planes[MinePlane][word] & ~outside;
+        m_flagged[word] = planes[FlaggedPlane][word] & ~outside;
+        m_questioned[word] = planes[QuestionedPlane][word] & ~outside & ~m_flagged.at(word) & ~open;
+        m_revealed[word] = outside | open;
+        // only a finished game has revealed mines or flags
+        valid = !(open & (m_mines.at(word) | m_flagged.at(word)));
+        mines += BitPlanes::bitCount(m_mines.at(word));
+        revealed += BitPlanes::bitCount(open);
+        flagged += BitPlanes::bitCount(m_flagged.at(word));
+    }
+    // a started game has something revealed and something left
+    if(!valid || mines != m_minesCount || revealed == 0 || cellCount() - revealed == m_minesCount)
+    {
+        newGame(numRows, numCols, numMines);
+        return false;
+    }
+
+    m_seed = seed;
+    m_flaggedCount = flagged;
+    m_numUnrevealed = cellCount() - revealed;
+    m_firstClick = false;
+    computeDigits();
+    computeMetrics(-1, false);
+    return true;
+}
+
+void MineField::generateField(int clickedIdx)
+{
+    // generating mines ensuring that clickedIdx won't hold mine
+    // and that it will be an empty cell so the user don't have
+    // to make random guesses at the start of the game
+    // (it will be empty if none of surrounding cells holds mine)
+    if(clickedIdx == m_presetStart)
+    {
+        foreach(int idx, m_presetMines)
+            setBit(m_mines, slotOf(idx));
+        m_seed = m_presetSeed;
+        computeDigits();
+        computeMetrics(clickedIdx, m_presetNoGuess);
+        return;
+    }
+
+    // collect cells around the click in index order,
+    // neighbours come in that order already
+    int neighbours[MAX_NEIGHBOURS];
+    const int count = adjasentCellsFor(clickedIdx, neighbours);
+    m_numExcluded = 0;
+    int i = 0;
+    while(i < count && neighbours[i] < clickedIdx)
+        m_excluded[m_numExcluded++] = neighbours[i++];
+    m_excluded[m_numExcluded++] = clickedIdx;
+    while(i < count)
+        m_excluded[m_numExcluded++] = neighbours[i++];
+
+    placeMines(m_firstAttempt);
+    bool solvable = false;
+    if(m_generationMode == NoGuess)
+    {
+        for(int attempt=m_firstAttempt+1; attempt<MAX_NO_GUESS_ATTEMPTS; ++attempt)
+        {
+            solvable = isSolvableFrom(clickedIdx);
+            if(solvable)
+                break;
+            clearMines();
+            placeMines(attempt);
+        }
+        // if there was no luck, the player will have to guess this time
+    }
+    computeMetrics(clickedIdx, solvable);
+}
+
+void MineField::placeMines(int board)
+{
+    m_random.setStream(m_seed, board);
+
+    // pick mines with Floyd's sampling: for every j from n-k to n-1 take
+    // a random rank up to j, or j itself if the rank is already taken.
+    // the mine plane serves as the set of taken ranks, so there are no
+    // retries and no memory besides the field itself
+    const int numCandidates = cellCount() - m_numExcluded;
+    const int minesToPlace = qMin(m_minesCount, numCandidates);
+    for(int j=numCandidates-minesToPlace; j<numCandidates; ++j)
+    {
+        int slot = candidateSlot(m_random.bounded(j+1));
+        if(testBit(m_mines, slot))
+            slot = candidateSlot(j);
+        // ok, let's mine this place! :-)
+        setBit(m_mines, slot);
+    }
+    computeDigits();
+}
+
+int MineField::candidateSlot(int rank) const
+{
+    // excluded cells are sorted, so skipping them in order
+    // gives index of the rank-th candidate
+    int idx = rank;
+    for(int i=0; i<m_numExcluded && m_excluded[i] <= idx; ++i)
+        idx++;
+    return slotOf(idx);
+}
+
+void MineField::computeDigits()
+{
+    // count mines around each cell of all rows at once, whole words at a time.
+    // border and padding bits never hold mines, so they need no special care
+    quint64* const digits[BitPlanes::DIGIT_PLANES] = { m_digits[0].data(), m_digits[1].data(),
+                                                       m_digits[2].data(), m_digits[3].data() };
+    BitPlanes::countNeighbours(m_mines.constData(), digits, 1 + m_rowWords,
+                               m_numRows*m_rowWords, m_rowWords);
+}
+
+void MineField::clearMines()
+{
+    m_mines.fill(0);
+}
+
+void MineField::computeMetrics(int clickedIdx, bool solvable)
+{
+    // empty cells of the field, whole words at a time. border, padding
+    // and holes are left out, so they never join or touch openings
+    QVector<quint64> empty(m_mines.size(), 0);
+    for(int row=0; row<m_numRows; ++row)
+    {
+        for(int k=0; k<m_rowWords; ++k)
+        {
+            const int word = (row+1)*m_rowWords + 1 + k;
+            empty[word] = m_inside.at(word) & ~(m_mines.at(word) | m_digits[0].at(word)
+                                                | m_digits[1].at(word) | m_digits[2].at(word)
+                                                | m_digits[3].at(word));
+        }
+    }
+
+    // openings are counted by a single union-find pass over runs of empty
+    // cells: a run joins every run of the previous row it touches
+    struct Run
+    {
+        int start;
+        int end;
+        int id;
+    };
+    QVector<Run> previous;
+    QVector<Run> current;
+    QVector<int> parent;
+    int unions = 0;
+    int isolated = 0;
+    for(int row=0; row<m_numRows; ++row)
+    {
+        current.resize(0);
+        int runStart = 0;
+        for(int k=0; k<m_rowWords; ++k)
+        {
+            const int word = (row+1)*m_rowWords + 1 + k;
+            const quint64 bits = empty.at(word);
+            const quint64 carryIn = k > 0 ? empty.at(word-1) >> 63 : 0;
+            const quint64 carryOut = k+1 < m_rowWords ? empty.at(word+1) << 63 : 0;
+            quint64 starts = bits & ~((bits << 1) | carryIn);
+            quint64 ends = bits & ~((bits >> 1) | carryOut);
+            while(starts || ends)
+            {
+                if(starts && (!ends || BitPlanes::lowestBit(starts) <= BitPlanes::lowestBit(ends)))
+                {
+                    runStart = k*64 + BitPlanes::lowestBit(starts);
+                    starts &= starts - 1;
+                    continue;
+                }
+                const Run run = { runStart, k*64 + BitPlanes::lowestBit(ends), parent.size() };
+                ends &= ends - 1;
+                parent.append(run.id);
+                current.append(run);
+            }
+
+            // digits with no empty cell around, rows above and below included
+            const quint64 around = empty.at(word - m_rowWords) | bits | empty.at(word + m_rowWords);
+            const quint64 aroundBefore = empty.at(word - m_rowWords - 1) | empty.at(word - 1)
+                                         | empty.at(word + m_rowWords - 1);
+            const quint64 aroundAfter = empty.at(word - m_rowWords + 1) | empty.at(word + 1)
+                                        | empty.at(word + m_rowWords + 1);
+            const quint64 near = around | (around << 1) | (aroundBefore >> 63)
+                                 | (around >> 1) | (aroundAfter << 63);
+            isolated += BitPlanes::bitCount(m_inside.at(word) & ~m_mines.at(word) & ~near);
+        }
+
+        // runs of both rows are sorted, touching ones overlap
+        // when the previous row is widened by one cell
+        int first = 0;
+        foreach(const Run& run, current)
+        {
+            while(first < previous.size() && previous.at(first).end < run.start - 1)
+                first++;
+            for(int i=first; i<previous.size() && previous.at(i).start <= run.end + 1; ++i)
+            {
+                int a = run.id;
+                int b = previous.at(i).id;
+                while(parent.at(a) != a)
+                    a = parent[a] = parent.at(parent.at(a));
+                while(parent.at(b) != b)
+                    b = parent[b] = parent.at(parent.at(b));
+                if(a != b)
+                {
+                    parent[a] = b;
+                    unions++;
+                }
+            }
+        }
+        previous.swap(current);
+    }
+
+    m_metrics.openings = parent.size() - unions;
+    m_metrics.isolatedDigits = isolated;
+    m_metrics.boardValue = m_metrics.openings + isolated;
+    if(solvable)
+        m_metrics.guesses = 0;
+    else if(m_estimateGuesses && clickedIdx != -1 && cellCount() <= MAX_ESTIMATED_CELLS)
+        m_metrics.guesses = estimateGuesses(clickedIdx);
+    else
+        m_metrics.guesses = -1;
+}
+
+int MineField::estimateGuesses(int clickedIdx) const
+{
+    // play a copy, so that this field stays untouched
+    MineField trial(*this);
+    trial.reveal(clickedIdx);
+    MineSolver solver(&trial);
+    int guesses = 0;
+    int neighbours[MAX_NEIGHBOURS];
+    while(!solver.solve() && !trial.isGameOver())
+    {
+        // guess right, next to the revealed area if possible
+        int guess = -1;
+        for(int idx=0; idx<trial.cellCount(); ++idx)
+        {
+            if(trial.isRevealed(idx) || trial.hasMine(idx))
+                continue;
+            if(guess == -1)
+                guess = idx;
+            const int count = trial.adjasentCellsFor(idx, neighbours);
+            int i = 0;
+            while(i < count && !trial.isRevealed(neighbours[i]))
+                i++;
+            if(i < count)
+            {
+                guess = idx;
+                break;
+            }
+        }
+        if(guess == -1)
+            break;
+        trial.reveal(guess);
+        guesses++;
+    }
+    return guesses;
+}
+
+void MineField::setPresetMines(const QVector<int>& mines, int startIdx, quint64 seed, bool noGuess)
+{
+    m_presetMines = mines;
+    m_presetStart = startIdx;
+    m_presetSeed = seed;
+    m_presetNoGuess = noGuess;
+}
+
+bool MineField::isSolvableFrom(int clickedIdx) const
+{
+    // play a copy, so that this field stays untouched
+    MineField trial(*this);
+    trial.reveal(clickedIdx);
+    MineSolver solver(&trial);
+    return solver.solve();
+}
+
+bool MineField::reveal(int idx)
+{
+    // resize() keeps reserved capacity, clear() doesn't in older Qt
+    m_changedCells.resize(0);
+    return revealAt(slotOf(idx));
+}
+
+bool MineField::revealAt(int slot)
+{
+    if(m_gameOver || !isReleasedAt(slot))
+        return false; // revealed, marked or border
+
+    if(m_firstClick)
+    {
+        m_firstClick = false;
+        generateField(indexOfSlot(slot));
+    }
+
+    // if we hold mine, let's explode
+    const bool mine = testBit(m_mines, slot);
+    if(mine)
+        m_explodedSlot = slot;
+    revealCell(slot);
+
+    if(mine)
+        revealAllMines();
+    else if(digitAt(slot) == 0) // empty cell
+        revealEmptySpace(slot);
+
+    // now let's check for possible win/loss
+    checkLost();
+    if(!m_gameOver) // checkLost might set it
+        checkWon();
+    return true;
+}
+
+bool MineField::toggleMark(int idx)
+{
+    m_changedCells.resize(0);
+    if(m_gameOver)
+        return false;
+
+    // this will provide cycling through
+    // Released -> "?"-mark -> "RedFlag"-mark -> Released
+    const int slot = slotOf(idx);
+    switch(stateAt(slot))
+    {
+        case KMinesState::Released:
+            setBit(m_flagged, slot);
+            m_flaggedCount++;
+            break;
+        case KMinesState::Flagged:
+            clearBit(m_flagged, slot);
+            if(m_useQuestionMarks)
+                setBit(m_questioned, slot);
+            m_flaggedCount--;
+            break;
+        case KMinesState::Questioned:
+            clearBit(m_questioned, slot);
+            break;
+        default:
+            // revealed cells can't be marked
+            return false;
+    }
+    m_changedCells.append(idx);
+    return true;
+}
+
+bool MineField::chord(int idx)
+{
+    m_changedCells.resize(0);
+    if(m_gameOver || !isRevealed(idx))
+        return false;
+
+    const int slot = slotOf(idx);
+    int numFlags = 0;
+    for(int i=0; i<MAX_NEIGHBOURS; ++i)
+        numFlags += (stateAt(slot + m_neighbourOffsets[i]) == KMinesState::Flagged);
+
+    if(numFlags != digitAt(slot) || numFlags == 0)
+        return false;
+
+    // revealAt() skips revealed, marked and border cells
+    for(int i=0; i<MAX_NEIGHBOURS; ++i)
+        revealAt(slot + m_neighbourOffsets[i]);
+    return true;
+}
+
+void MineField::revealCell(int slot)
+{
+    // a revealed cell keeps its flag only if the flag was wrong,
+    // which makes it an Error
+    setBit(m_revealed, slot);
+    clearBit(m_questioned, slot);
+    if(testBit(m_mines, slot))
+        clearBit(m_flagged, slot);
+    m_numUnrevealed--;
+    m_changedCells.append(indexOfSlot(slot));
+}
+
+void MineField::revealEmptySpace(int slot)
+{
+    // reveal neighbour cells until we find cells with digit.
+    // cells are revealed when pushed, so each one is pushed only once
+    m_floodStack.resize(0);
+    m_floodStack.append(slot);
+    while(!m_floodStack.isEmpty())
+    {
+        const int current = m_floodStack.last();
+        m_floodStack.removeLast();
+
+        for(int i=0; i<MAX_NEIGHBOURS; ++i)
+        {
+            const int neighbour = current + m_neighbourOffsets[i];
+            if(!isReleasedAt(neighbour))
+                continue; // revealed, marked or border
+            revealCell(neighbour);
+            if(digitAt(neighbour) == 0)
+                m_floodStack.append(neighbour);
+        }
+    }
+}
+
+void MineField::revealAllMines()
+{
+    // unrevealed mines which aren't flagged and wrong flags,
+    // border is revealed so it never gets here
+    for(int word=0; word<m_mines.size(); ++word)
+    {
+        const quint64 flagged = m_flagged.at(word);
+        quint64 pending = ~m_revealed.at(word) & (m_mines.at(word) ^ flagged);
+        while(pending)
+        {
+            const int bit = BitPlanes::lowestBit(pending);
+            pending &= pending - 1;
+            revealCell((word-1)*64 + bit);
+        }
+    }
+}
+
+void MineField::checkLost()
+{
+    // for loss...
+    if(m_explodedSlot != -1)
+    {
+        m_gameOver = true;
+        m_won = false;
+    }
+}
+
+void MineField::checkWon()
+{
+    // this also takes into account the trivial case when
+    // only some cells left unflagged and they
+    // all contain bombs. this counts as win
+    if(m_numUnrevealed == m_minesCount)
+    {
+        // mark not flagged cells (if any) with flags
+        for(int word=0; word<m_flagged.size(); ++word)
+        {
+            quint64 pending = ~(m_revealed.at(word) | m_flagged.at(word));
+            m_flagged[word] |= pending;
+            m_questioned[word] = 0;
+            while(pending)
+            {
+                const int bit = BitPlanes::lowestBit(pending);
+                pending &= pending - 1;
+                m_changedCells.append(indexOfSlot((word-1)*64 + bit));
+            }
+        }
+        // now all mines should be flagged
+        m_flaggedCount = m_minesCount;
+        m_gameOver = true;
+        m_won = true;
+    }
+}
+
+int MineField::adjasentCellsFor(int idx, int* neighbours) const
+{
+    if(isShaped())
+    {
+        // holes are left out by the mask of cells
+        const int slot = slotOf(idx);
+        int count = 0;
+        for(int i=0; i<MAX_NEIGHBOURS; ++i)
+        {
+            const int neighbour = slot + m_neighbourOffsets[i];
+            if(testBit(m_inside, neighbour))
+                neighbours[count++] = indexOfSlot(neighbour);
+        }
+        return count;
+    }
+
+    // same order as m_neighbourOffsets, but in index space
+    const FieldPos pos = rowColFromIndex(idx);
+    int count = 0;
+    for(int row=pos.first-1; row<=pos.first+1; ++row)
+    {
+        if(row < 0 || row >= m_numRows)
+            continue;
+        for(int col=pos.second-1; col<=pos.second+1; ++col)
+        {
+            if(col < 0 || col >= m_numCols || (row == pos.first && col == pos.second))
+                continue;
+            neighbours[count++] = row*m_numCols + col;
+        }
+    }
+    return count;
+}
@@ -0,0 +1,630 @@
+/*
+    Copyright 2007 Dmitry Suzdalev <dimsuz@gmail.com>
+    Copyright 2010 Brian Croom <brian.s.croom@gmail.com>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#ifndef MINEFIELD_H
+#define MINEFIELD_H
+
+#include <QVector>
+#include <QPair>
+#include "commondefs.h"
+#include "bitplanes.h"
+#include "boardshape.h"
+#include "counterrandom.h"
+
+typedef QPair<int,int> FieldPos;
+
+/**
+ * Game engine of KMines.
+ * Holds the whole field in bit-planes and implements the rules of the
+ * game: mine generation, revealing, marking, chording and win/loss
+ * detection.
+ *
+ * It doesn't depend on any GUI class, so it can be used to simulate
+ * games without QApplication or KGameRenderer. MineFieldItem only
+ * renders its state.
+ *
+ * Cells are addressed by index, which is row*columnCount()+col.
+ * A field can also have the shape of a BoardShape, then only its cells
+ * are numbered, in the same order, and holes are treated like the
+ * border. Internally every property of cells (mine, revealed, flagged,
+ * questioned and the four bits of the digit) has its own plane with one
+ * bit per cell, so a field takes one byte per cell. Planes have a one
+ * cell wide border around the field (see slotOf()), which is marked as
+ * revealed, so that neighbours of any cell can be visited with a fixed
+ * table of offsets and no boundary checks.
+ */
+class MineField
+{
+public:
+    /**
+     * How mines are placed on the first reveal
+     */
+    enum GenerationMode
+    {
+        /// mines are placed randomly, player may have to guess
+        RandomMines,
+        /// field can be solved from the first click by pure logic (see MineSolver)
+        NoGuess
+    };
+
+    /**
+     * Constructor. Creates empty field, call newGame() to set it up
+     */
+    MineField();
+    /**
+     * Starts new game: resizes the field and resets all cells.
+     * Mines are placed later, on the first reveal(), so that
+     * the first clicked cell is always empty.
+     *
+     * @param numRows number of rows
+     * @param numCols number of columns
+     * @param numMines number of mines
+     */
+    void newGame( int numRows, int numCols, int numMines );
+    /**
+     * Starts new game on a field of given shape. Holes of the shape
+     * are never revealed and have no mines, otherwise this is
+     * the same as newGame() of a rectangle
+     *
+     * @param shape shape of the field, must have some cells
+     * @param numMines number of mines
+     */
+    void newGame(const BoardShape& shape, int numMines);
+    /**
+     * Reveals cell at idx. Generates the field if this is the first reveal.
+     * Revealing an empty cell opens all the empty space around it,
+     * revealing a mine loses the game.
+     *
+     * @return true if cell was revealed
+     */
+    bool reveal(int idx);
+    /**
+     * Cycles marks of unrevealed cell at idx:
+     * Released -> Flagged -> Questioned (if enabled) -> Released
+     *
+     * @return true if mark was changed
+     */
+    bool toggleMark(int idx);
+    /**
+     * Reveals all unmarked neighbours of revealed cell at idx
+     * if the number of flags around it equals its digit
+     *
+     * @return true if neighbours were revealed
+     */
+    bool chord(int idx);
+    /**
+     * Returns indexes of cells whose state was changed by the last call
+     * of reveal(), toggleMark() or chord(), in the order they were changed.
+     * This includes the whole opened empty space, mines revealed on loss
+     * and cells flagged automatically on win
+     */
+    const QVector<int>& changedCells() const { return m_changedCells; }
+    /**
+     * Sets how mines will be placed in next games.
+     * If no solvable field is found in MAX_NO_GUESS_ATTEMPTS
+     * with NoGuess mode, the last random one is used
+     */
+    void setGenerationMode(GenerationMode mode) { m_generationMode = mode; }
+    /**
+     * @return how mines are placed
+     */
+    GenerationMode generationMode() const { return m_generationMode; }
+    /**
+     * Sets whether Metrics::guesses of the next games is estimated,
+     * which plays the field once more with MineSolver. Enabled by default
+     */
+    void setEstimateGuesses(bool estimate) { m_estimateGuesses = estimate; }
+    /**
+     * Sets seed of mines of the next games, so that the same seed,
+     * field size, generation mode and first click always produce
+     * the same field. 0 means a random seed for every game
+     */
+    void setSeed(quint64 seed) { m_fixedSeed = seed; }
+    /**
+     * Sets which board of the seed is placed first. RandomMines mode
+     * uses just this one, NoGuess mode goes on with the following ones.
+     * 0 by default, BoardGenerator uses it to try boards in parallel
+     */
+    void setFirstAttempt(int attempt) { m_firstAttempt = attempt; }
+    /**
+     * @return seed of the current game. If preset mines are used,
+     * this is their seed once they are placed
+     */
+    quint64 seed() const { return m_seed; }
+    /**
+     * Uses given mines instead of generating them if the first revealed
+     * cell is startIdx. Revealing any other cell first generates the field
+     * as usual. Must be called after newGame()
+     *
+     * @param mines indexes of cells holding mines
+     * @param startIdx cell the field was prepared for
+     * @param seed seed the mines were generated from
+     * @param noGuess whether the field is known to need no guessing
+     * from startIdx, then its guesses aren't estimated
+     */
+    void setPresetMines(const QVector<int>& mines, int startIdx, quint64 seed, bool noGuess);
+    /**
+     * @return cell preset mines were prepared for, -1 if there are none
+     */
+    int presetStartCell() const { return m_presetStart; }
+    /**
+     * Sets whether toggleMark() should cycle through question mark
+     */
+    void setUseQuestionMarks(bool use) { m_useQuestionMarks = use; }
+
+    /**
+     * @return num rows in field
+     */
+    int rowCount() const { return m_numRows; }
+    /**
+     * @return num columns in field
+     */
+    int columnCount() const { return m_numCols; }
+    /**
+     * @return total number of cells
+     */
+    int cellCount() const { return m_numCells; }
+    /**
+     * @return whether the field has holes, see newGame()
+     */
+    bool isShaped() const { return !m_cellSlots.isEmpty(); }
+    /**
+     * @return num mines in field
+     */
+    int minesCount() const { return m_minesCount; }
+    /**
+     * @return number of flagged cells
+     */
+    int flaggedCount() const { return m_flaggedCount; }
+    /**
+     * @return number of cells which are not revealed yet
+     */
+    int unrevealedCount() const { return m_numUnrevealed; }
+    /**
+     * @return true if mines are not placed yet
+     */
+    bool isFirstClick() const { return m_firstClick; }
+    /**
+     * @return true if game is over (either won or lost)
+     */
+    bool isGameOver() const { return m_gameOver; }
+    /**
+     * @return true if game is over and player won it
+     */
+    bool isWon() const { return m_won; }
+
+    /**
+     * @return index of cell at (row,col), -1 if there's a hole
+     */
+    int indexOf(int row, int col) const
+        {
+            if(!isShaped())
+                return row*m_numCols + col;
+            const int slot = (row+1)*m_rowStride + col + 1;
+            return testBit(m_inside, slot) ? indexOfSlot(slot) : -1;
+        }
+    /**
+     * Calculates (row,col) from given index and returns them in QPair
+     */
+    FieldPos rowColFromIndex(int idx) const
+        {
+            if(isShaped())
+            {
+                const int slot = m_cellSlots.at(idx);
+                const int row = slot/m_rowStride - 1;
+                return qMakePair(row, slot - (row+1)*m_rowStride - 1);
+            }
+            int row = idx/m_numCols;
+            return qMakePair(row, idx - row*m_numCols);
+        }
+    /**
+     * Maximal number of neighbours a cell can have
+     */
+    static const int MAX_NEIGHBOURS = 8;
+    /**
+     * Fills neighbours with indexes of all adjasent cells for cell at idx.
+     * Doesn't allocate anything
+     *
+     * @param neighbours array of at least MAX_NEIGHBOURS elements
+     * @return number of adjasent cells
+     */
+    int adjasentCellsFor(int idx, int* neighbours) const;
+
+    /**
+     * @return current state of cell at idx.
+     * Note that engine never sets Pressed state - pressing is purely visual
+     */
+    KMinesState::CellState cellState(int idx) const { return stateAt(slotOf(idx)); }
+    /**
+     * @return whether cell at idx holds mine
+     */
+    bool hasMine(int idx) const { return testBit(m_mines, slotOf(idx)); }
+    /**
+     * @return whether mine in cell at idx is exploded
+     */
+    bool isExploded(int idx) const { return m_explodedSlot != -1 && slotOf(idx) == m_explodedSlot; }
+    /**
+     * @return digit cell at idx holds or 0 if none
+     */
+    int digit(int idx) const { return digitAt(slotOf(idx)); }
+    /**
+     * @return whether cell at idx is revealed
+     */
+    bool isRevealed(int idx) const { return testBit(m_revealed, slotOf(idx)); }
+    /**
+     * @return whether cell at idx is marked with flag
+     */
+    bool isFlagged(int idx) const { return cellState(idx) == KMinesState::Flagged; }
+    /**
+     * @return whether cell at idx is marked with question
+     */
+    bool isQuestioned(int idx) const { return cellState(idx) == KMinesState::Questioned; }
+
+    /**
+     * Planes describing a game in progress, see planeData()
+     */
+    enum Plane
+    {
+        MinePlane,
+        RevealedPlane,
+        FlaggedPlane,
+        QuestionedPlane,
+        PLANE_COUNT
+    };
+    /**
+     * @return words of given plane, planeWordCount() of them. Together
+     * with size and seed of the field they describe a started game,
+     * see restoreGame()
+     */
+    const quint64* planeData(Plane plane) const;
+    /**
+     * @return number of words in every plane
+     */
+    int planeWordCount() const { return m_mines.size(); }
+    /**
+     * @return word of the planes holding cell at idx
+     */
+    int planeWordOf(int idx) const { return wordOf(slotOf(idx)); }
+    /**
+     * @return number of words in every plane of a field of given size
+     */
+    static int planeWordCountFor(int numRows, int numCols)
+        { return (numRows+2)*((numCols+2 + 63) / 64) + 2; }
+    /**
+     * Continues a started game from its planes, as given by
+     * planeData(). Bits outside of the field are ignored
+     *
+     * @param planes PLANE_COUNT arrays of planeWordCountFor() words
+     * @return false if planes don't hold a game in progress with
+     * numMines mines, then the field is left as after newGame()
+     */
+    bool restoreGame(int numRows, int numCols, int numMines, quint64 seed,
+                     const quint64* const planes[PLANE_COUNT]);
+
+    /**
+     * How hard a generated field is, see metrics()
+     */
+    struct Metrics
+    {
+        /**
+         * Number of connected areas of empty cells,
+         * each of them is opened by a single click
+         */
+        int openings;
+        /**
+         * Number of cells with digit which aren't next to any opening,
+         * so each of them takes a click of its own
+         */
+        int isolatedDigits;
+        /**
+         * 3BV: the minimal number of clicks clearing the field,
+         * openings plus isolated digits
+         */
+        int boardValue;
+        /**
+         * Number of guesses MineSolver needs to clear the field from
+         * the first click if all of them are right. -1 if it isn't
+         * known, i.e. the field is bigger than MAX_ESTIMATED_CELLS,
+         * the game was restored or estimation is disabled
+         */
+        int guesses;
+    };
+    /**
+     * @return how hard the field is, computed when mines are placed
+     */
+    const Metrics& metrics() const { return m_metrics; }
+
+    /**
+     * Minimal number of free positions on a field
+     */
+    static const int MINIMAL_FREE = 10;
+    /**
+     * Guesses of bigger fields aren't estimated, see Metrics
+     */
+    static const int MAX_ESTIMATED_CELLS = 1000;
+    /**
+     * Maximal number of fields tried in NoGuess mode
+     */
+    static const int MAX_NO_GUESS_ATTEMPTS = 1000;
+    /**
+     * Fields with more cells don't reserve memory for changing
+     * all of them at once
+     */
+    static const int MAX_RESERVED_CELLS = 1 << 20;
+private:
+    /**
+     * @return position of cell at idx in the planes, in bits
+     */
+    inline int slotOf(int idx) const
+        {
+            if(!m_cellSlots.isEmpty())
+                return m_cellSlots.at(idx);
+            const int row = idx/m_numCols;
+            return (row+1)*m_rowStride + idx - row*m_numCols + 1;
+        }
+    /**
+     * @return index of cell at given position in the planes
+     */
+    inline int indexOfSlot(int slot) const
+        {
+            if(!m_wordRanks.isEmpty())
+            {
+                // cells in the words before plus cells before it in its word
+                const int word = wordOf(slot);
+                return m_wordRanks.at(word) + BitPlanes::bitCount(m_inside.at(word) & (bitOf(slot) - 1));
+            }
+            const int row = slot/m_rowStride - 1;
+            return row*m_numCols + slot - (row+1)*m_rowStride - 1;
+        }
+    /**
+     * @return word of a plane holding given slot.
+     * Planes start with a padding word, see countNeighbours()
+     */
+    static inline int wordOf(int slot) { return (slot >> 6) + 1; }
+    /**
+     * @return mask of given slot in its word
+     */
+    static inline quint64 bitOf(int slot) { return quint64(1) << (slot & 63); }
+    static inline bool testBit(const QVector<quint64>& plane, int slot)
+        { return plane.at(wordOf(slot)) & bitOf(slot); }
+    static inline void setBit(QVector<quint64>& plane, int slot)
+        { plane[wordOf(slot)] |= bitOf(slot); }
+    static inline void clearBit(QVector<quint64>& plane, int slot)
+        { plane[wordOf(slot)] &= ~bitOf(slot); }
+    /**
+     * @return state of cell at slot
+     */
+    inline KMinesState::CellState stateAt(int slot) const
+        {
+            const bool flagged = testBit(m_flagged, slot);
+            if(testBit(m_revealed, slot))
+                return flagged ? KMinesState::Error : KMinesState::Revealed;
+            if(flagged)
+                return KMinesState::Flagged;
+            return testBit(m_questioned, slot) ? KMinesState::Questioned : KMinesState::Released;
+        }
+    /**
+     * @return whether cell at slot is neither revealed nor marked.
+     * Border is revealed, so it's never released
+     */
+    inline bool isReleasedAt(int slot) const
+        {
+            const int word = wordOf(slot);
+            return !((m_revealed.at(word) | m_flagged.at(word) | m_questioned.at(word)) & bitOf(slot));
+        }
+    /**
+     * @return digit of cell at slot
+     */
+    inline int digitAt(int slot) const
+        {
+            int digit = 0;
+            for(int k=0; k<BitPlanes::DIGIT_PLANES; ++k)
+                digit |= testBit(m_digits[k], slot) << k;
+            return digit;
+        }
+
+    /**
+     * Does the work of both newGame(), shape is 0 for a rectangle
+     */
+    void setupGame(int numRows, int numCols, int numCells, int numMines, const BoardShape* shape);
+    /**
+     * Generates game field ensuring that cell at clickedIdx
+     * will be empty to allow the player quickly jump into the game.
+     *
+     * @param clickedIdx specifies index which should NOT have mine and be empty
+     */
+    void generateField(int clickedIdx);
+    /**
+     * Places mines in random cells except m_excluded and computes digits
+     *
+     * @param board number of the board of the current seed, every
+     * attempt of NoGuess mode takes the next one
+     */
+    void placeMines(int board);
+    /**
+     * @return slot of the rank-th cell which isn't in m_excluded
+     */
+    int candidateSlot(int rank) const;
+    /**
+     * Computes digits of all cells from mines
+     */
+    void computeDigits();
+    /**
+     * Removes all mines
+     */
+    void clearMines();
+    /**
+     * Computes m_metrics of placed mines
+     *
+     * @param clickedIdx first revealed cell, -1 if it isn't known
+     * @param solvable whether the field is known to need no guessing
+     */
+    void computeMetrics(int clickedIdx, bool solvable);
+    /**
+     * @return number of guesses MineSolver needs starting by revealing
+     * clickedIdx, if every guess reveals a cell without mine
+     */
+    int estimateGuesses(int clickedIdx) const;
+    /**
+     * @return whether MineSolver wins this field without guessing,
+     * starting by revealing clickedIdx
+     */
+    bool isSolvableFrom(int clickedIdx) const;
+    /**
+     * Does the actual work of reveal() without resetting m_changedCells,
+     * so it can be called several times during a single chord
+     */
+    bool revealAt(int slot);
+    /**
+     * Reveals a single cell and records it in m_changedCells,
+     * doesn't check for game end
+     */
+    void revealCell(int slot);
+    /**
+     * Reveals all empty cells around cell at slot,
+     * until it found cells with digits (which are also revealed).
+     * Doesn't recurse: uses m_floodStack which is allocated once per game
+     */
+    void revealEmptySpace(int slot);
+    /**
+     * Reveals all unmarked cells containing mines
+     * and wrongly flagged ones
+     */
+    void revealAllMines();
+    /**
+     * Checks if player lost the game
+     */
+    void checkLost();
+    /**
+     * Checks if player won the game
+     */
+    void checkWon();
+
+    /**
+     * Planes of cells surrounded by the border.
+     * Use slotOf() to find a cell by its index
+     */
+    QVector<quint64> m_mines;
+    QVector<quint64> m_revealed;
+    QVector<quint64> m_flagged;
+    QVector<quint64> m_questioned;
+    /**
+     * Digits of cells, bit k of a digit is in m_digits[k]
+     */
+    QVector<quint64> m_digits[BitPlanes::DIGIT_PLANES];
+    /**
+     * Cells of the field, i.e. slots which are neither border,
+     * padding nor holes of the shape
+     */
+    QVector<quint64> m_inside;
+    /**
+     * Slot of every cell of a shaped field, empty for rectangles,
+     * whose slots are computed from indexes
+     */
+    QVector<int> m_cellSlots;
+    /**
+     * Number of cells before every word of the planes of a shaped
+     * field, so that index of a slot is a popcount away
+     */
+    QVector<int> m_wordRanks;
+    /**
+     * Offsets in slots from a cell to its neighbours,
+     * computed in newGame()
+     */
+    int m_neighbourOffsets[MAX_NEIGHBOURS];
+    /**
+     * Number of words in a row of a plane
+     */
+    int m_rowWords;
+    /**
+     * Number of slots in a row of a plane, i.e. m_rowWords*64
+     */
+    int m_rowStride;
+    /**
+     * Slot of exploded mine, -1 if there is none
+     */
+    int m_explodedSlot;
+    /**
+     * Cells changed by the last action. Capacity for the whole field
+     * is reserved in newGame() unless the field is huge
+     */
+    QVector<int> m_changedCells;
+    /**
+     * Slots of cells whose neighbours still have to be revealed
+     * by revealEmptySpace()
+     */
+    QVector<int> m_floodStack;
+    Metrics m_metrics;
+    /**
+     * Sorted indexes of cells around the first click, which can't hold mine
+     */
+    int m_excluded[MAX_NEIGHBOURS+1];
+    int m_numExcluded;
+    /**
+     * Mines set by setPresetMines()
+     */
+    QVector<int> m_presetMines;
+    int m_presetStart;
+    quint64 m_presetSeed;
+    bool m_presetNoGuess;
+    /**
+     * Number of field rows
+     */
+    int m_numRows;
+    /**
+     * Number of field columns
+     */
+    int m_numCols;
+    /**
+     * Number of cells
+     */
+    int m_numCells;
+    /**
+     * Number of mines in field
+     */
+    int m_minesCount;
+    /**
+     * Number of flagged cells
+     */
+    int m_flaggedCount;
+    /**
+     * Number of cells which are not revealed
+     */
+    int m_numUnrevealed;
+    /**
+     * Seed given to setSeed() and seed of the current game
+     */
+    quint64 m_fixedSeed;
+    quint64 m_seed;
+    /**
+     * Board of the seed placed first, see setFirstAttempt()
+     */
+    int m_firstAttempt;
+    /**
+     * Random numbers used to generate mine positions
+     */
+    CounterRandom m_random;
+    GenerationMode m_generationMode;
+    bool m_estimateGuesses;
+    bool m_firstClick;
+    bool m_gameOver;
+    bool m_won;
+    bool m_useQuestionMarks;
+};
+
+#endif
@@ -18,57 +18,228 @@
 */
 #include "minefielditem.h"
 
-#include <QDebug>
 #include <QGraphicsScene>
 #include <QGraphicsSceneMouseEvent>
 
 #include "cellitem.h"
 #include "borderitem.h"
+#include "batchedfielditem.h"
+#include "settings.h"
 
 MineFieldItem::MineFieldItem(KGameRenderer* renderer)
-    : m_leftButtonPos(-1,-1), m_midButtonPos(-1,-1), m_gameOver(false),
+    : m_tileAtlas(renderer), m_batchedItem(new BatchedFieldItem(&m_tileAtlas, this)), m_batched(false),
+      m_cellSize(0), m_endless(false), m_player(&m_field, &m_chunkedField), m_replaying(false),
+      m_probabilities(&m_field), m_showHints(false),
+      m_flaggedMinesCount(0), m_startHintIdx(-1), m_requestedStartIdx(-1),
+      m_leftButtonPos(-1,-1), m_midButtonPos(-1,-1), m_gameOver(false),
       m_emulatingMidButton(false), m_renderer(renderer)
 {
 	setFlag(QGraphicsItem::ItemHasNoContents);
+	m_batchedItem->hide();
+	connect(&m_tileAtlas, &TileAtlas::tilesChanged, this, &MineFieldItem::updateTiles);
 }
 
-void MineFieldItem::initField( int numRows, int numCols, int numMines )
+void MineFieldItem::initField( int numRows, int numCols, int numMines, quint64 seed )
 {
-    numMines = qMin(numMines, numRows*numCols - MINIMAL_FREE );
+    initField(BoardShape::rectangle(numRows, numCols), numMines, seed);
+}
+
+void MineFieldItem::initField(const BoardShape& shape, int numMines, quint64 seed)
+{
+    m_field.setGenerationMode(Settings::noGuessGames() ? MineField::NoGuess : MineField::RandomMines);
+    m_field.setSeed(seed);
+    m_field.newGame(shape, numMines);
+    m_endless = false;
+    m_replaying = false;
+    // the game kept before is given up
+    m_snapshot.discard();
 
-    m_firstClick = true;
     m_gameOver = false;
+    m_startHintIdx = -1;
+    m_requestedStartIdx = -1;
+    m_probabilities.reset();
+    m_hintCells.clear();
+
+    resizeItems(shape);
+    m_recorder.start(m_field.generationMode() == MineField::NoGuess ? ReplayRecorder::NoGuess : ReplayRecorder::RandomMines,
+                     m_field.seed(), shape.rowCount(), shape.columnCount(), m_field.minesCount());
+    m_flaggedMinesCount = 0;
+    emit flaggedMinesCountChanged(m_flaggedMinesCount);
+}
+
+void MineFieldItem::initEndlessField(quint64 seed, double density)
+{
+    m_chunkedField.newGame(seed, density);
+    m_endless = true;
+    m_replaying = false;
+    m_snapshot.discard();
+
+    m_gameOver = false;
+    m_startHintIdx = -1;
+    m_requestedStartIdx = -1;
+    m_hintCells.clear();
+
+    // window is set up by setWindowSize()
+    m_chunkedField.setWindow(0, 0, 0, 0);
+    resizeItems(BoardShape());
+    m_recorder.start(ReplayRecorder::Endless, m_chunkedField.seed(), 0, 0,
+                     qRound(density * ReplayRecorder::DENSITY_SCALE));
+    m_flaggedMinesCount = 0;
+    emit flaggedMinesCountChanged(m_flaggedMinesCount);
+}
+
+void MineFieldItem::setWindowSize(int numRows, int numCols)
+{
+    // a replay shows the window it recorded
+    if(!m_endless || m_replaying || (numRows == rowCount() && numCols == columnCount()))
+        return;
+    prepareGeometryChange();
+    m_chunkedField.setWindow(m_chunkedField.originRow() + (rowCount() - numRows)/2,
+                             m_chunkedField.originCol() + (columnCount() - numCols)/2,
+                             numRows, numCols);
+    m_recorder.recordWindow(m_chunkedField.originRow(), m_chunkedField.originCol(), numRows, numCols);
+    m_midButtonPos = qMakePair(-1, -1);
+    m_leftButtonPos = qMakePair(-1, -1);
+    resizeItems(BoardShape::rectangle(numRows, numCols));
+    updateAllItems();
+}
+
+void MineFieldItem::scrollWindow(int rows, int cols)
+{
+    if(!m_endless || m_replaying || (rows == 0 && cols == 0))
+        return;
+    m_chunkedField.setWindow(m_chunkedField.originRow() + rows, m_chunkedField.originCol() + cols,
+                             rowCount(), columnCount());
+    m_recorder.recordWindow(m_chunkedField.originRow(), m_chunkedField.originCol(), rowCount(), columnCount());
+    // pressed cells would be somewhere else now
+    m_midButtonPos = qMakePair(-1, -1);
+    m_leftButtonPos = qMakePair(-1, -1);
+    updateAllItems();
+}
+
+bool MineFieldItem::restoreSnapshot(int* seconds, QByteArray* level, bool* botPlayed)
+{
+    QByteArray replay;
+    if(!m_snapshot.restore(&m_field, &replay, seconds) || !m_recorder.resume(replay, *seconds))
+        return false;
+    *level = m_snapshot.level();
+    *botPlayed = m_snapshot.isBotPlayed();
+    m_endless = false;
+    m_replaying = false;
+    m_gameOver = false;
+    m_startHintIdx = -1;
+    m_requestedStartIdx = -1;
+    m_probabilities.reset();
+    m_hintCells.clear();
+    m_midButtonPos = qMakePair(-1, -1);
+    m_leftButtonPos = qMakePair(-1, -1);
+
+    prepareGeometryChange();
+    resizeItems(BoardShape::rectangle(m_field.rowCount(), m_field.columnCount()));
+    updateAllItems();
+    if(m_showHints)
+        updateHints();
+    m_flaggedMinesCount = m_field.flaggedCount();
+    emit flaggedMinesCountChanged(m_flaggedMinesCount);
+    return true;
+}
+
+void MineFieldItem::updateSnapshot()
+{
+    // snapshots only know the size of a field, not its shape
+    if(m_endless || m_field.isShaped() || m_field.isFirstClick())
+        return;
+    if(m_field.isGameOver())
+        m_snapshot.discard();
+    else if(m_snapshot.isOpen())
+        m_snapshot.update(m_field, m_field.changedCells(), m_recorder.data());
+    else
+        m_snapshot.create(m_field, m_recorder.data());
+}
+
+bool MineFieldItem::loadReplay(const QByteArray& data)
+{
+    if(!m_player.load(data))
+        return false;
+    m_snapshot.discard();
+    m_replaying = true;
+    m_endless = m_player.isEndless();
+    m_gameOver = false;
+    m_startHintIdx = -1;
+    m_requestedStartIdx = -1;
+    m_probabilities.reset();
+    m_hintCells.clear();
+    m_midButtonPos = qMakePair(-1, -1);
+    m_leftButtonPos = qMakePair(-1, -1);
+
+    prepareGeometryChange();
+    resizeItems(BoardShape::rectangle(rowCount(), columnCount()));
+    updateAllItems();
+    m_flaggedMinesCount = 0;
+    emit flaggedMinesCountChanged(m_flaggedMinesCount);
+    return true;
+}
+
+bool MineFieldItem::seekReplay(qint64 time)
+{
+    if(!m_replaying)
+        return false;
+    const int oldRows = rowCount();
+    const int oldCols = columnCount();
+    m_player.seek(time);
+    const bool resized = (rowCount() != oldRows || columnCount() != oldCols);
+    if(resized)
+    {
+        prepareGeometryChange();
+        resizeItems(BoardShape::rectangle(rowCount(), columnCount()));
+    }
+    updateAllItems();
+
+    // game over isn't reported, the game has been scored already
+    const int flaggedCount = m_endless ? m_chunkedField.flaggedCount() : m_field.flaggedCount();
+    if(flaggedCount != m_flaggedMinesCount)
+    {
+        m_flaggedMinesCount = flaggedCount;
+        emit flaggedMinesCountChanged(m_flaggedMinesCount);
+    }
+    return resized;
+}
+
+void MineFieldItem::resizeItems(const BoardShape& shape)
+{
+    m_isHint.fill(false, shape.cellCount());
+
+    // big fields don't need cell and border items at all
+    m_batched = (shape.cellCount() > MAX_CELL_ITEMS);
+    m_batchedItem->setVisible(m_batched);
+    if(m_batched)
+        m_batchedItem->setFieldShape(shape);
+    const QVector<BoardShape::BorderTile> outline = m_batched ? QVector<BoardShape::BorderTile>() : shape.outline();
 
     int oldSize = m_cells.size();
-    int newSize = numRows*numCols;
+    int newSize = m_batched ? 0 : shape.cellCount();
     int oldBorderSize = m_borders.size();
-    int newBorderSize = (numCols+2)*2 + (numRows+2)*2-4;
+    int newBorderSize = outline.size();
 
     // if field is being shrinked, delete elements at the end before resizing vector
-    if(oldSize > newSize)
+    for( int i=newSize; i<oldSize; ++i )
     {
-        for( int i=newSize; i<oldSize; ++i )
-        {
-            // is this the best way to remove an item?
-            scene()->removeItem(m_cells[i]);
-            delete m_cells[i];
-        }
+        // is this the best way to remove an item?
+        scene()->removeItem(m_cells[i]);
+        delete m_cells[i];
+    }
 
-        // adjust border item array too
-        for( int i=newBorderSize; i<oldBorderSize; ++i)
-        {
-            scene()->removeItem(m_borders[i]);
-            delete m_borders[i];
-        }
+    // adjust border item array too. a field with less
+    // cells can still have a longer border
+    for( int i=newBorderSize; i<oldBorderSize; ++i)
+    {
+        scene()->removeItem(m_borders[i]);
+        delete m_borders[i];
     }
 
     m_cells.resize(newSize);
     m_borders.resize(newBorderSize);
 
-    m_numRows = numRows;
-    m_numCols = numCols;
-    m_minesCount = numMines;
-    m_numUnrevealed = m_numRows*m_numCols;
     m_midButtonPos = qMakePair(-1, -1);
     m_leftButtonPos = qMakePair(-1, -1);
 
@@ -78,129 +249,72 @@ void MineFieldItem::initField( int numRows, int numCols, int numMines )
         if(i<oldSize)
             m_cells[i]->reset();
         else
-            m_cells[i] = new CellItem(m_renderer, this);
-        // let it be empty by default
-        // generateField() will adjust needed cells
-        // to hold digits or mines
-        m_cells[i]->setDigit(0);
+        {
+            m_cells[i] = new CellItem(&m_tileAtlas, this);
+            m_cells[i]->setCellSize(m_cellSize);
+        }
     }
 
     for(int i=oldBorderSize; i<newBorderSize; ++i)
             m_borders[i] = new BorderItem(m_renderer, this);
 
-    setupBorderItems();
+    setupBorderItems(outline);
 
     adjustItemPositions();
-    m_flaggedMinesCount = 0;
-    emit flaggedMinesCountChanged(m_flaggedMinesCount);
 }
 
-void MineFieldItem::generateField(int clickedIdx)
+bool MineFieldItem::setPresetBoard(const QVector<int>& mines, int startIdx, quint64 seed, bool noGuess)
 {
-    // generating mines ensuring that clickedIdx won't hold mine
-    // and that it will be an empty cell so the user don't have
-    // to make random guesses at the start of the game
-    QList<int> cellsWithMines;
-    int minesToPlace = m_minesCount;
-    int randomIdx = 0;
-    CellItem* item = 0;
-    FieldPos fp = rowColFromIndex(clickedIdx);
-
-    // this is the list of items we don't want to put the mine in
-    // to ensure that clickedIdx will stay an empty cell
-    // (it will be empty if none of surrounding items holds mine)
-    QList<CellItem*> neighbForClicked = adjasentItemsFor(fp.first, fp.second);
+    if(m_endless || m_replaying || !m_field.isFirstClick() || isWaitingForBoard()
+       || startIdx < 0 || startIdx >= m_field.cellCount())
+        return false;
+
+    m_field.setPresetMines(mines, startIdx, seed, noGuess);
+
+    const int oldHintIdx = m_startHintIdx;
+    m_startHintIdx = startIdx;
+    if(oldHintIdx != -1)
+        updateItem(oldHintIdx);
+    updateItem(m_startHintIdx);
+    return true;
+}
 
-    while(minesToPlace != 0)
-    {
-        randomIdx = m_randomSeq.getLong( m_numRows*m_numCols );
-        item = m_cells.at(randomIdx);
-        if(!item->hasMine()
-           && neighbForClicked.indexOf(item) == -1
-           && randomIdx != clickedIdx)
-        {
-            // ok, let's mine this place! :-)
-            item->setHasMine(true);
-            cellsWithMines.append(randomIdx);
-            minesToPlace--;
-        }
-        else
-            continue;
-    }
+bool MineFieldItem::revealGeneratedBoard(const QVector<int>& mines, int startIdx, bool noGuess)
+{
+    if(startIdx == -1 || startIdx != m_requestedStartIdx)
+        return false;
+
+    // generated mines are the field the seed of the game gives,
+    // so the game keeps its seed
+    m_field.setPresetMines(mines, startIdx, m_field.seed(), noGuess);
+    undoPressCell(startIdx);
+    applyMove(ReplayRecorder::Reveal, startIdx);
+    m_requestedStartIdx = -1;
+    updateSnapshot();
+    checkFieldChanges();
+    return true;
+}
 
-    foreach(int idx, cellsWithMines)
-    {
-        FieldPos rc = rowColFromIndex(idx);
-        QList<CellItem*> neighbours = adjasentItemsFor(rc.first, rc.second);
-        foreach( CellItem *item, neighbours )
-        {
-            if(!item->hasMine())
-                item->setDigit( item->digit()+1 );
-        }
-    }
+void MineFieldItem::setShowHints(bool show)
+{
+    m_showHints = show;
+    updateHints();
 }
 
-void MineFieldItem::setupBorderItems()
+void MineFieldItem::setupBorderItems(const QVector<BoardShape::BorderTile>& outline)
 {
-    int i = 0;
-    for(int row=0; row<m_numRows+2; ++row)
-        for(int col=0; col<m_numCols+2; ++col)
-        {
-            if( row == 0 && col == 0)
-            {
-                m_borders.at(i)->setRowCol(0,0);
-                m_borders.at(i)->setBorderType(KMinesState::BorderCornerNW);
-                i++;
-            }
-            else if( row == 0 && col == m_numCols+1)
-            {
-                m_borders.at(i)->setRowCol(row,col);
-                m_borders.at(i)->setBorderType(KMinesState::BorderCornerNE);
-                i++;
-            }
-            else if( row == m_numRows+1 && col == 0 )
-            {
-                m_borders.at(i)->setRowCol(row,col);
-                m_borders.at(i)->setBorderType(KMinesState::BorderCornerSW);
-                i++;
-            }
-            else if( row == m_numRows+1 && col == m_numCols+1 )
-            {
-                m_borders.at(i)->setRowCol(row,col);
-                m_borders.at(i)->setBorderType(KMinesState::BorderCornerSE);
-                i++;
-            }
-            else if( row == 0 )
-            {
-                m_borders.at(i)->setRowCol(row,col);
-                m_borders.at(i)->setBorderType(KMinesState::BorderNorth);
-                i++;
-            }
-            else if( row == m_numRows+1 )
-            {
-                m_borders.at(i)->setRowCol(row,col);
-                m_borders.at(i)->setBorderType(KMinesState::BorderSouth);
-                i++;
-            }
-            else if( col == 0 )
-            {
-                m_borders.at(i)->setRowCol(row,col);
-                m_borders.at(i)->setBorderType(KMinesState::BorderWest);
-                i++;
-            }
-            else if( col == m_numCols+1 )
-            {
-                m_borders.at(i)->setRowCol(row,col);
-                m_borders.at(i)->setBorderType(KMinesState::BorderEast);
-                i++;
-            }
-        }
+    for(int i=0; i<outline.size(); ++i)
+    {
+        const BoardShape::BorderTile& tile = outline.at(i);
+        m_borders.at(i)->setRowCol(tile.row, tile.col);
+        m_borders.at(i)->setBorderType(tile.element);
+    }
 }
 
 QRectF MineFieldItem::boundingRect() const
 {
     // +2 - because of border on each side
-    return QRectF(0, 0, m_cellSize*(m_numCols+2), m_cellSize*(m_numRows+2));
+    return QRectF(0, 0, m_cellSize*(columnCount()+2), m_cellSize*(rowCount()+2));
 }
 
 void MineFieldItem::paint( QPainter * painter, const QStyleOptionGraphicsItem* opt, QWidget* w)
@@ -210,9 +324,10 @@ void MineFieldItem::paint( QPainter * painter, const QStyleOptionGraphicsItem* o
     Q_UNUSED(w);
 }
 
-void MineFieldItem::resizeToFitInRect(const QRectF& rect)
+int MineFieldItem::fittingCellSize(const QRectF& rect) const
 {
-    prepareGeometryChange();
+    const int numRows = rowCount();
+    const int numCols = columnCount();
 
     // +2 in some places - because of border on each side
 
@@ -223,18 +338,32 @@ void MineFieldItem::resizeToFitInRect(const QRectF& rect)
     // to understand that criteria for choosing one side or another (for
     // determining cell size from it) is comparing
     // cols/r.width() and rows/r.height():
-    bool chooseHorizontalSide = (m_numCols+2) / rect.width() > (m_numRows+2) / rect.height();
+    bool chooseHorizontalSide = (numCols+2) / rect.width() > (numRows+2) / rect.height();
 
     qreal size = 0;
     if( chooseHorizontalSide )
-        size = rect.width() / (m_numCols+2);
+        size = rect.width() / (numCols+2);
     else
-        size = rect.height() / (m_numRows+2);
+        size = rect.height() / (numRows+2);
+
+    // cells can't vanish completely, mouse handling divides by their size
+    return qMax(1, static_cast<int>(size));
+}
+
+void MineFieldItem::setCellSize(int size)
+{
+    prepareGeometryChange();
+    m_cellSize = qMax(1, size);
 
-    m_cellSize = static_cast<int>(size);
+    // this is also called when the theme changes, the atlas knows
+    // whether tiles have to be rendered again. that happens in
+    // background, old ones are scaled meanwhile
+    m_tileAtlas.setTileSize(m_cellSize);
+    if(m_batched)
+        m_batchedItem->setCellSize(m_cellSize);
 
     foreach( CellItem* item, m_cells )
-        item->setRenderSize(QSize(m_cellSize, m_cellSize));
+        item->setCellSize(m_cellSize);
 
     foreach( BorderItem *item, m_borders)
         item->setRenderSize(QSize(m_cellSize, m_cellSize));
@@ -242,15 +371,27 @@ void MineFieldItem::resizeToFitInRect(const QRectF& rect)
     adjustItemPositions();
 }
 
+void MineFieldItem::updateTiles()
+{
+    // new tiles replace all old ones in a single frame
+    if(m_batched)
+        m_batchedItem->update();
+    foreach( CellItem* item, m_cells )
+        item->updatePixmap();
+}
+
 void MineFieldItem::adjustItemPositions()
 {
-    Q_ASSERT( m_cells.size() == m_numRows*m_numCols );
+    // batched item covers the whole field from its origin
+    if(m_batched)
+        return;
+    Q_ASSERT( m_cells.size() == cellCount() );
 
-    for(int row=0; row<m_numRows; ++row)
-        for(int col=0; col<m_numCols; ++col)
-        {
-            itemAt(row,col)->setPos((col+1)*m_cellSize, (row+1)*m_cellSize);
-        }
+    for(int idx=0; idx<m_cells.size(); ++idx)
+    {
+        const FieldPos pos = rowColOf(idx);
+        m_cells.at(idx)->setPos((pos.second+1)*m_cellSize, (pos.first+1)*m_cellSize);
+    }
 
     foreach( BorderItem* item, m_borders )
     {
@@ -258,66 +399,137 @@ void MineFieldItem::adjustItemPositions()
     }
 }
 
-void MineFieldItem::onItemRevealed(int row, int col)
+void MineFieldItem::updateItems()
 {
-    m_numUnrevealed--;
-    if(itemAt(row,col)->hasMine())
+    if(m_showHints)
+        updateHints();
+    // only cells touched by the last action need to be updated
+    foreach(int idx, m_endless ? m_chunkedField.changedCells() : m_field.changedCells())
+        updateItem(idx);
+}
+
+void MineFieldItem::updateAllItems()
+{
+    for(int idx=0; idx<cellCount(); ++idx)
+        updateItem(idx);
+}
+
+void MineFieldItem::updateHints()
+{
+    const QVector<int> oldHints = m_hintCells;
+    foreach(int idx, oldHints)
+        m_isHint[idx] = false;
+    m_hintCells.clear();
+
+    // first click is always safe, so there's nothing to hint.
+    // probabilities are only computed for bounded fields
+    if(m_showHints && !m_endless && !m_replaying && !m_field.isFirstClick() && !m_field.isGameOver())
     {
-        revealAllMines();
+        m_probabilities.update();
+        int safest = -1;
+        for(int idx=0; idx<m_field.cellCount(); ++idx)
+        {
+            if(m_field.cellState(idx) != KMinesState::Released)
+                continue;
+            const double probability = m_probabilities.probability(idx);
+            if(probability < 1e-9)
+                m_hintCells.append(idx);
+            else if(safest == -1 || probability < m_probabilities.probability(safest))
+                safest = idx;
+        }
+        if(m_hintCells.isEmpty() && safest != -1)
+            m_hintCells.append(safest);
     }
-    else if(itemAt(row,col)->digit() == 0) // empty cell
+
+    foreach(int idx, m_hintCells)
+        m_isHint[idx] = true;
+    foreach(int idx, oldHints)
+        updateItem(idx);
+    foreach(int idx, m_hintCells)
+        updateItem(idx);
+}
+
+void MineFieldItem::updateItem(int idx)
+{
+    KMinesState::CellState state;
+    int digit;
+    bool hasMine, exploded;
+    if(m_endless)
+    {
+        state = m_chunkedField.cellState(idx);
+        digit = m_chunkedField.digit(idx);
+        hasMine = m_chunkedField.hasMine(idx);
+        exploded = m_chunkedField.isExploded(idx);
+    }
+    else
     {
-        revealEmptySpace(row,col);
+        state = m_field.cellState(idx);
+        digit = m_field.digit(idx);
+        hasMine = m_field.hasMine(idx);
+        exploded = m_field.isExploded(idx);
     }
-    // now let's check for possible win/loss
-    checkLost();
-    if(!m_gameOver) // checkLost might set it
-        checkWon();
+    // start hint stays visible until the game starts
+    const bool startHint = (idx == m_startHintIdx && m_field.isFirstClick());
+    if(state == KMinesState::Released && (startHint || m_isHint.at(idx)))
+        state = KMinesState::Hint;
+    if(m_batched)
+        m_batchedItem->setCellState(idx, state, digit, hasMine, exploded);
+    else
+        m_cells[idx]->setCellState(state, digit, hasMine, exploded);
+}
+
+void MineFieldItem::pressCell(int idx)
+{
+    if(m_batched)
+        m_batchedItem->press(idx);
+    else
+        m_cells.at(idx)->press();
+}
+
+void MineFieldItem::undoPressCell(int idx)
+{
+    if(m_batched)
+        m_batchedItem->undoPress(idx);
+    else
+        m_cells.at(idx)->undoPress();
+}
+
+bool MineFieldItem::isCellPressed(int idx) const
+{
+    if(m_batched)
+        return m_batchedItem->isPressed(idx);
+    return m_cells.at(idx)->cellState() == KMinesState::Pressed;
 }
 
-void MineFieldItem::revealEmptySpace(int row, int col)
+void MineFieldItem::checkFieldChanges()
 {
-    // recursively reveal neighbour cells until we find cells with digit
-    QList<FieldPos> list = adjasentRowColsFor(row,col);
-    CellItem *item = 0;
+    const int flaggedCount = m_endless ? m_chunkedField.flaggedCount() : m_field.flaggedCount();
+    if(flaggedCount != m_flaggedMinesCount)
+    {
+        m_flaggedMinesCount = flaggedCount;
+        emit flaggedMinesCountChanged(m_flaggedMinesCount);
+    }
 
-    foreach( const FieldPos& pos, list )
+    // endless game can only be lost
+    const bool gameOver = m_endless ? m_chunkedField.isGameOver() : m_field.isGameOver();
+    if(gameOver && !m_gameOver)
     {
-        // first is row, second is col
-        item = itemAt(pos);
-        if(item->isRevealed() || item->isFlagged() || item->isQuestioned())
-            continue;
-        if(item->digit() == 0)
-        {
-            item->reveal();
-            m_numUnrevealed--;
-            revealEmptySpace(pos.first,pos.second);
-        }
-        else
-        {
-            item->reveal();
-            m_numUnrevealed--;
-        }
+        m_gameOver = true;
+        emit gameOver(!m_endless && m_field.isWon());
     }
 }
 
 void MineFieldItem::mousePressEvent( QGraphicsSceneMouseEvent *ev )
 {
-    if(m_gameOver)
+    if(m_gameOver || m_replaying || isWaitingForBoard())
         return;
 
     int row = static_cast<int>(ev->pos().y()/m_cellSize)-1;
     int col = static_cast<int>(ev->pos().x()/m_cellSize)-1;
-    if( row <0 || row >= m_numRows || col < 0 || col >= m_numCols )
+    if(!hasCellAt(row, col))
         return;
 
-    CellItem* itemUnderMouse = itemAt(row,col);
-    if(!itemUnderMouse)
-    {
-        qDebug() << "unexpected - no item under mouse";
-        return;
-    }
-
+    const int idx = indexOf(row,col);
     m_emulatingMidButton = ( (ev->buttons() & Qt::LeftButton) && (ev->buttons() & Qt::RightButton) );
     bool midButtonPressed = (ev->button() == Qt::MidButton || m_emulatingMidButton );
 
@@ -325,34 +537,32 @@ void MineFieldItem::mousePressEvent( QGraphicsSceneMouseEvent *ev )
     {
         // in case we just started mid-button emulation (first LeftClick then added a RightClick)
         // undo press that was made by LeftClick. in other cases it won't hurt :)
-        itemUnderMouse->undoPress();
+        undoPressCell(idx);
 
-        QList<CellItem*> neighbours = adjasentItemsFor(row,col);
-        foreach(CellItem* item, neighbours)
-        {
-            if(!item->isFlagged() && !item->isQuestioned() && !item->isRevealed())
-                item->press();
-            m_midButtonPos = qMakePair(row,col);
+        // only released items can be pressed, so marked
+        // and revealed ones stay as they are
+        pressAdjasentItems(row,col);
+        m_midButtonPos = qMakePair(row,col);
 
-            m_leftButtonPos = qMakePair(-1,-1); // reset it
-        }
+        m_leftButtonPos = qMakePair(-1,-1); // reset it
     }
     else if(ev->button() == Qt::LeftButton)
     {
-        itemUnderMouse->press();
+        pressCell(idx);
+        m_recorder.record(ReplayRecorder::Press, idx);
         m_leftButtonPos = qMakePair(row,col);
     }
 }
 
 void MineFieldItem::mouseReleaseEvent( QGraphicsSceneMouseEvent * ev)
 {
-    if(m_gameOver)
+    if(m_gameOver || m_replaying || isWaitingForBoard())
         return;
 
     int row = static_cast<int>(ev->pos().y()/m_cellSize)-1;
     int col = static_cast<int>(ev->pos().x()/m_cellSize)-1;
 
-    if( row <0 || row >= m_numRows || col < 0 || col >= m_numCols )
+    if(!hasCellAt(row, col))
     {
         // there might be the case when player moved mouse outside game field
         // while holding mid button and released it outside the field
@@ -360,22 +570,20 @@ void MineFieldItem::mouseReleaseEvent( QGraphicsSceneMouseEvent * ev)
         // and return
         if(m_midButtonPos.first != -1)
         {
-            QList<CellItem*> neighbours = adjasentItemsFor(m_midButtonPos.first,m_midButtonPos.second);
-            foreach(CellItem *item, neighbours)
-                item->undoPress();
+            undoPressAdjasentItems(m_midButtonPos.first,m_midButtonPos.second);
             m_midButtonPos = qMakePair(-1,-1);
             m_emulatingMidButton = false;
         }
         // same with left button
         if(m_leftButtonPos.first != -1)
         {
-            itemAt(m_leftButtonPos)->undoPress();
+            undoPressCell(indexOf(m_leftButtonPos.first, m_leftButtonPos.second));
             m_leftButtonPos = qMakePair(-1,-1);
         }
         return;
     }
 
-    CellItem* itemUnderMouse = itemAt(row,col);
+    const int idx = indexOf(row,col);
 
     bool midButtonReleased = (ev->button() == Qt::MidButton || m_emulatingMidButton);
 
@@ -383,47 +591,14 @@ void MineFieldItem::mouseReleaseEvent( QGraphicsSceneMouseEvent * ev)
     {
         m_midButtonPos = qMakePair(-1,-1);
 
-        QList<CellItem*> neighbours = adjasentItemsFor(row,col);
-        if(!itemUnderMouse->isRevealed())
-        {
-            foreach(CellItem *item, neighbours)
-                item->undoPress();
-            return;
-        }
-
-        int numFlags = 0;
-        int numMines = 0;
-        foreach(CellItem *item, neighbours)
-        {
-            if(item->isFlagged())
-                numFlags++;
-            if(item->hasMine())
-                numMines++;
-        }
-        if(numFlags == numMines && numFlags != 0)
-        {
-            foreach(CellItem *item, neighbours)
-            {
-                if(!item->isRevealed()) // revealing only unrevealed ones
-                {
-                    // force=true to omit Pressed check
-                    item->release(true);
-                    if(item->isRevealed())
-                        onItemRevealed(item);
-                }
-            }
-        }
-        else
-        {
-            foreach(CellItem *item, neighbours)
-                item->undoPress();
-        }
+        undoPressAdjasentItems(row,col);
+        applyMove(ReplayRecorder::Chord, idx);
     }
     else if(ev->button() == Qt::LeftButton && (ev->buttons() & Qt::RightButton) == false)
     {
         if(m_midButtonPos.first != -1) // mid-button is already pressed
         {
-            itemUnderMouse->undoPress();
+            undoPressCell(idx);
             return;
         }
 
@@ -433,48 +608,100 @@ void MineFieldItem::mouseReleaseEvent( QGraphicsSceneMouseEvent * ev)
         if(m_leftButtonPos.first == -1)
             return;
 
-        if(!itemUnderMouse->isRevealed()) // revealing only unrevealed ones
+        // only pressed (i.e. released and unmarked) items can be revealed
+        if(isCellPressed(idx))
         {
-            if(m_firstClick)
-            {
-                m_firstClick = false;
-                generateField( row*m_numCols + col );
-                emit firstClickDone();
-            }
-
-            itemUnderMouse->release();
-            if(itemUnderMouse->isRevealed())
-                onItemRevealed(row,col);
+            undoPressCell(idx);
+            applyMove(ReplayRecorder::Reveal, idx);
         }
         m_leftButtonPos = qMakePair(-1,-1);//reset
     }
     else if(ev->button() == Qt::RightButton && (ev->buttons() & Qt::LeftButton) == false)
     {
-        bool wasFlagged = itemUnderMouse->isFlagged();
+        applyMove(ReplayRecorder::Mark, idx);
+    }
 
-        itemUnderMouse->mark();
+    updateSnapshot();
+    checkFieldChanges();
+}
 
-        bool flagStateChanged = (itemUnderMouse->isFlagged() != wasFlagged);
-        if(flagStateChanged)
+bool MineFieldItem::playMove(ReplayRecorder::Action action, int idx)
+{
+    // the field is hidden while the game is paused
+    if(m_gameOver || m_replaying || m_endless || !isVisible() || isWaitingForBoard()
+       || idx < 0 || idx >= m_field.cellCount())
+        return false;
+    applyMove(action, idx);
+    updateSnapshot();
+    checkFieldChanges();
+    return true;
+}
+
+void MineFieldItem::applyMove(ReplayRecorder::Action action, int idx)
+{
+    bool changed = false;
+    switch(action)
+    {
+        case ReplayRecorder::Reveal:
         {
-            if(itemUnderMouse->isFlagged())
-                m_flaggedMinesCount++;
-            else
-                m_flaggedMinesCount--;
-            emit flaggedMinesCountChanged(m_flaggedMinesCount);
+            const bool firstClick = m_endless ? m_chunkedField.isFirstClick() : m_field.isFirstClick();
+            // searching for a "no guess" field takes too long for the
+            // GUI thread, unless one was prepared for this very cell
+            if(firstClick && !m_endless && m_field.generationMode() == MineField::NoGuess
+               && idx != m_field.presetStartCell() && m_field.cellState(idx) == KMinesState::Released)
+            {
+                // the cell stays pressed until the field is there
+                m_requestedStartIdx = idx;
+                pressCell(idx);
+                emit boardRequested(idx);
+                return;
+            }
+            m_recorder.record(ReplayRecorder::Reveal, idx);
+            changed = m_endless ? m_chunkedField.reveal(idx) : m_field.reveal(idx);
+            if(changed && firstClick)
+            {
+                // preset mines are a random field of their own seed,
+                // generated ones are the field of the game's seed
+                if(!m_endless && idx == m_field.presetStartCell() && !isWaitingForBoard())
+                    m_recorder.setBoard(ReplayRecorder::RandomMines, m_field.seed());
+                emit firstClickDone();
+                // hint isn't needed anymore, unless it's revealed already
+                if(m_startHintIdx != -1 && m_startHintIdx != idx)
+                    updateItem(m_startHintIdx);
+                m_startHintIdx = -1;
+            }
+            break;
         }
+        case ReplayRecorder::Mark:
+            m_field.setUseQuestionMarks(Settings::useQuestionMarks());
+            m_chunkedField.setUseQuestionMarks(Settings::useQuestionMarks());
+            m_recorder.setUseQuestionMarks(Settings::useQuestionMarks());
+            m_recorder.record(ReplayRecorder::Mark, idx);
+            changed = m_endless ? m_chunkedField.toggleMark(idx) : m_field.toggleMark(idx);
+            break;
+        case ReplayRecorder::Chord:
+            m_recorder.record(ReplayRecorder::Chord, idx);
+            changed = m_endless ? m_chunkedField.chord(idx) : m_field.chord(idx);
+            break;
+        default:
+            return;
     }
+    if(!changed)
+        return;
+    updateItems();
+    if(!m_endless)
+        emit cellsChanged(m_field.changedCells());
 }
 
 void MineFieldItem::mouseMoveEvent( QGraphicsSceneMouseEvent *ev )
 {
-    if(m_gameOver)
+    if(m_gameOver || m_replaying || isWaitingForBoard())
         return;
 
     int row = static_cast<int>(ev->pos().y()/m_cellSize)-1;
     int col = static_cast<int>(ev->pos().x()/m_cellSize)-1;
 
-    if( row < 0 || row >= m_numRows || col < 0 || col >= m_numCols )
+    if(!hasCellAt(row, col))
         return;
 
     bool midButtonPressed = ((ev->buttons() & Qt::MidButton) ||
@@ -486,15 +713,10 @@ void MineFieldItem::mouseMoveEvent( QGraphicsSceneMouseEvent *ev )
            (m_midButtonPos.first != row || m_midButtonPos.second != col))
         {
             // un-press previously pressed cells
-            QList<CellItem*> prevNeighbours = adjasentItemsFor(m_midButtonPos.first,
-                                                              m_midButtonPos.second);
-            foreach(CellItem *item, prevNeighbours)
-                   item->undoPress();
+            undoPressAdjasentItems(m_midButtonPos.first, m_midButtonPos.second);
 
             // and press current neighbours
-            QList<CellItem*> neighbours = adjasentItemsFor(row,col);
-            foreach(CellItem *item, neighbours)
-                item->press();
+            pressAdjasentItems(row,col);
 
             m_midButtonPos = qMakePair(row,col);
         }
@@ -504,104 +726,28 @@ void MineFieldItem::mouseMoveEvent( QGraphicsSceneMouseEvent *ev )
         if((m_leftButtonPos.first != -1 && m_leftButtonPos.second != -1) &&
            (m_leftButtonPos.first != row || m_leftButtonPos.second != col))
         {
-            itemAt(m_leftButtonPos)->undoPress();
-            itemAt(row,col)->press();
+            undoPressCell(indexOf(m_leftButtonPos.first, m_leftButtonPos.second));
+            pressCell(indexOf(row,col));
+            m_recorder.record(ReplayRecorder::Press, indexOf(row,col));
             m_leftButtonPos = qMakePair(row,col);
         }
     }
 }
 
-void MineFieldItem::revealAllMines()
-{
-    foreach( CellItem* item, m_cells )
-    {
-        if( (item->isFlagged() && !item->hasMine()) || (!item->isFlagged() && item->hasMine()) )
-        {
-            item->reveal();
-            m_numUnrevealed--;
-        }
-    }
-}
-
-void MineFieldItem::onItemRevealed(CellItem* item)
+void MineFieldItem::pressAdjasentItems(int row, int col)
 {
-    int idx = m_cells.indexOf(item);
-    if(idx == -1)
-    {
-        qDebug() << "really strange - item not found";
-        return;
-    }
-
-    int row = idx / m_numCols;
-    int col = idx - row*m_numCols;
-    onItemRevealed(row,col);
+    int neighbours[MineField::MAX_NEIGHBOURS];
+    const int count = m_endless ? m_chunkedField.adjasentCellsFor(indexOf(row,col), neighbours)
+                                : m_field.adjasentCellsFor(indexOf(row,col), neighbours);
+    for(int i=0; i<count; ++i)
+        pressCell(neighbours[i]);
 }
 
-void MineFieldItem::checkLost()
+void MineFieldItem::undoPressAdjasentItems(int row, int col)
 {
-    // for loss...
-    foreach( CellItem* item, m_cells )
-    {
-        if(item->isExploded())
-        {
-            m_gameOver = true;
-            emit gameOver(false);
-            break;
-        }
-    }
+    int neighbours[MineField::MAX_NEIGHBOURS];
+    const int count = m_endless ? m_chunkedField.adjasentCellsFor(indexOf(row,col), neighbours)
+                                : m_field.adjasentCellsFor(indexOf(row,col), neighbours);
+    for(int i=0; i<count; ++i)
+        undoPressCell(neighbours[i]);
 }
-
-void MineFieldItem::checkWon()
-{
-    // this also takes into account the trivial case when
-    // only some cells left unflagged and they
-    // all contain bombs. this counts as win
-    if(m_numUnrevealed == m_minesCount)
-    {
-        // mark not flagged cells (if any) with flags
-        foreach( CellItem* item, m_cells )
-        {
-            if( !item->isRevealed() && !item->isFlagged() )
-                item->mark();
-        }
-        m_gameOver = true;
-        // now all mines should be flagged, notify about this
-        emit flaggedMinesCountChanged(m_minesCount);
-        emit gameOver(true);
-    }
-}
-
-QList<FieldPos> MineFieldItem::adjasentRowColsFor(int row, int col)
-{
-    QList<FieldPos> resultingList;
-    if(row != 0 && col != 0) // upper-left diagonal
-        resultingList.append( qMakePair(row-1,col-1) );
-    if(row != 0) // upper
-        resultingList.append(qMakePair(row-1, col));
-    if(row != 0 && col != m_numCols-1) // upper-right diagonal
-        resultingList.append(qMakePair(row-1, col+1));
-    if(col != 0) // on the left
-        resultingList.append(qMakePair(row,col-1));
-    if(col != m_numCols-1) // on the right
-        resultingList.append(qMakePair(row, col+1));
-    if(row != m_numRows-1 && col != 0) // bottom-left diagonal
-        resultingList.append(qMakePair(row+1, col-1));
-    if(row != m_numRows-1) // bottom
-        resultingList.append(qMakePair(row+1, col));
-    if(row != m_numRows-1 && col != m_numCols-1) // bottom-right diagonal
-        resultingList.append(qMakePair(row+1, col+1));
-    return resultingList;
-}
-
-QList<CellItem*> MineFieldItem::adjasentItemsFor(int row, int col)
-{
-    QList<FieldPos > rowcolList = adjasentRowColsFor(row,col);
-    QList<CellItem*> resultingList;
-    foreach( const FieldPos& pos, rowcolList )
-        resultingList.append( itemAt(pos) );
-    return resultingList;
-}
-
-
-
-
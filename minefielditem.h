@@ -21,21 +21,36 @@
 
 #include <QVector>
 #include <QGraphicsObject>
-#include <QPair>
-#include <KRandomSequence>
+
+#include "minefield.h"
+#include "chunkedminefield.h"
+#include "replayrecorder.h"
+#include "replayplayer.h"
+#include "gamesnapshot.h"
+#include "mineprobability.h"
+#include "tileatlas.h"
 
 class KGameRenderer;
 class CellItem;
 class BorderItem;
-
-typedef QPair<int,int> FieldPos;
+class BatchedFieldItem;
 
 /**
  * Graphics item that represents MineField.
- * It is composed of many (or little) of CellItems.
- * This class is responsible of generation game field
- * with given properties (num rows, num cols, num mines) and
- * handling resizes
+ * It is composed of many (or little) of CellItems, or of a single
+ * BatchedFieldItem if the field is too big for an item per cell.
+ * This class translates mouse actions to MineField calls,
+ * renders the resulting state and handles resizes.
+ * Game rules live in MineField
+ *
+ * A bounded field may have any shape, then items are only created
+ * for its cells and the border follows its outline.
+ *
+ * In the endless mode items show a window of a ChunkedMineField
+ * instead, which can be scrolled with scrollWindow()
+ *
+ * A recorded game can be shown with loadReplay(), then the field
+ * ignores the mouse and follows the log instead
  */
 class MineFieldItem : public QGraphicsObject
 {
@@ -52,12 +67,81 @@ public:
      * @param numRows number of rows
      * @param numCols number of columns
      * @param numMines number of mines
+     * @param seed seed of mine positions, 0 means a random one
+     */
+    void initField( int numRows, int numCols, int numMines, quint64 seed );
+    /**
+     * Initializes game field of given shape, see initField()
+     *
+     * @param shape shape of the field, must have some cells
+     * @param numMines number of mines
+     * @param seed seed of mine positions, 0 means a random one
+     */
+    void initField(const BoardShape& shape, int numMines, quint64 seed);
+    /**
+     * Starts endless game. Call setWindowSize() to choose how much
+     * of the field is shown
+     *
+     * @param seed seed of mine positions, 0 means a random one
+     * @param density probability that a cell holds mine
+     */
+    void initEndlessField(quint64 seed, double density);
+    /**
+     * @return whether an endless game is played
+     */
+    bool isEndless() const { return m_endless; }
+    /**
+     * @return whether the bounded field of the current game has holes
+     */
+    bool isShaped() const { return !m_endless && !m_replaying && m_field.isShaped(); }
+    /**
+     * Sets number of rows and columns shown in the endless mode,
+     * keeping the center of the window in place
+     */
+    void setWindowSize(int numRows, int numCols);
+    /**
+     * Moves the window of the endless mode by given number of cells
+     */
+    void scrollWindow(int rows, int cols);
+    /**
+     * Makes the field use prepared mines if the player starts
+     * by revealing startIdx. Start cell is shown with a hint.
+     * Only possible before the first click
+     *
+     * @param seed seed the mines were generated from
+     * @param noGuess whether the field needs no guessing from startIdx
+     * @return false if the game has already started
+     */
+    bool setPresetBoard(const QVector<int>& mines, int startIdx, quint64 seed, bool noGuess);
+    /**
+     * Reveals the first cell with mines generated in background after
+     * boardRequested() was emitted for it
+     *
+     * @param mines indexes of cells holding mines
+     * @param startIdx cell given to boardRequested()
+     * @param noGuess whether the field needs no guessing from startIdx
+     * @return false if the field doesn't wait for them anymore
+     */
+    bool revealGeneratedBoard(const QVector<int>& mines, int startIdx, bool noGuess);
+    /**
+     * @return whether the first revealed cell waits for generated mines
+     */
+    bool isWaitingForBoard() const { return m_requestedStartIdx != -1; }
+    /**
+     * Sets whether the safest unrevealed cells should be shown with
+     * a hint. These are all cells which can't hold mine or, if there
+     * are none, the one least likely to hold mine
      */
-    void initField( int numRows, int numCols, int numMines );
+    void setShowHints(bool show);
     /**
-     * Resizes this graphics item so it fits in given rect
+     * @return the biggest cell size which lets the whole field fit in given rect
      */
-    void resizeToFitInRect(const QRectF& rect);
+    int fittingCellSize(const QRectF& rect) const;
+    /**
+     * Resizes this graphics item to given size of cells.
+     * Also needed after the theme changes
+     */
+    void setCellSize(int size);
     /**
      * Reimplemented from QGraphicsItem
      */
@@ -65,25 +149,120 @@ public:
     /**
      * @return num rows in field
      */
-    int rowCount() const { return m_numRows; }
+    int rowCount() const { return m_endless ? m_chunkedField.rowCount() : m_field.rowCount(); }
     /**
      * @return num columns in field
      */
-    int columnCount() const { return m_numCols; }
+    int columnCount() const { return m_endless ? m_chunkedField.columnCount() : m_field.columnCount(); }
+    /**
+     * @return num mines in field, 0 in the endless mode
+     */
+    int minesCount() const { return m_endless ? 0 : m_field.minesCount(); }
+    /**
+     * @return seed of mine positions of the current game
+     */
+    quint64 seed() const { return m_endless ? m_chunkedField.seed() : m_field.seed(); }
+    /**
+     * @return log of the current game
+     */
+    const ReplayRecorder& replay() const { return m_recorder; }
+    /**
+     * Appends a Pause event to the log
+     */
+    void recordPause(bool paused) { m_recorder.recordPause(paused); }
+    /**
+     * Appends the result of the game to the log
+     *
+     * @param seconds time shown by the game clock
+     */
+    void recordResult(bool won, int seconds) { m_recorder.recordFinish(won, seconds); }
+    /**
+     * Sets file games in progress are kept in, see GameSnapshot.
+     * Only games on bounded fields without holes are kept
+     */
+    void setSnapshotFile(const QString& fileName) { m_snapshot.setFileName(fileName); }
+    /**
+     * Continues the game kept in the snapshot file
+     *
+     * @param seconds time on the game clock when it was left
+     * @param level key of the level the game was played at
+     * @param botPlayed whether a bot made a move in the game
+     * @return false if there's no game to continue
+     */
+    bool restoreSnapshot(int* seconds, QByteArray* level, bool* botPlayed);
+    /**
+     * Stores time on the game clock in the snapshot
+     */
+    void setSnapshotSeconds(int seconds) { m_snapshot.setSeconds(seconds); }
+    /**
+     * Stores level of the game and whether a bot played it in the snapshot
+     */
+    void setSnapshotLevel(const QByteArray& level) { m_snapshot.setLevel(level); }
+    void setSnapshotBotPlayed(bool played) { m_snapshot.setBotPlayed(played); }
+    /**
+     * Shows a recorded game from its start. The next initField()
+     * or initEndlessField() ends showing it
+     *
+     * @return false if data isn't a valid log
+     */
+    bool loadReplay(const QByteArray& data);
+    /**
+     * Shows the recorded game as it was at given time
+     *
+     * @return true if number of rows or columns changed, so the
+     * item has to be laid out again
+     */
+    bool seekReplay(qint64 time);
+    /**
+     * @return whether a recorded game is shown
+     */
+    bool isReplaying() const { return m_replaying; }
+    /**
+     * @return length of the shown recorded game in milliseconds
+     */
+    qint64 replayDuration() const { return m_player.duration(); }
+    /**
+     * @return field of the current game, 0 in the endless mode
+     * and while a recorded game is shown
+     */
+    const MineField* field() const { return m_endless || m_replaying ? 0 : &m_field; }
     /**
-     * @return num mines in field
+     * Makes a move on a bounded field as if the player made it
+     * with the mouse. Only Reveal, Mark and Chord are moves
+     *
+     * @return false if no move is possible now, e.g. the game
+     * is over, paused or a recorded game is shown
      */
-    int minesCount() const { return m_minesCount; }
+    bool playMove(ReplayRecorder::Action action, int idx);
 
     /**
      * Minimal number of free positions on a field
      */
-    static const int MINIMAL_FREE = 10;
+    static const int MINIMAL_FREE = MineField::MINIMAL_FREE;
+    /**
+     * Bigger fields are painted by BatchedFieldItem
+     */
+    static const int MAX_CELL_ITEMS = 2500;
 
 signals:
     void flaggedMinesCountChanged(int);
     void firstClickDone();
     void gameOver(bool won);
+    /**
+     * Emitted after every move which changed cells of a bounded field
+     */
+    void cellsChanged(const QVector<int>& cells);
+    /**
+     * Emitted when the player starts a "no guess" game on a cell which
+     * has no prepared mines. They are generated in background, the cell
+     * is revealed by revealGeneratedBoard() and no moves are made until then
+     */
+    void boardRequested(int startIdx);
+private slots:
+    /**
+     * Shows tiles which were rendered in background
+     */
+    void updateTiles();
 private:
     // reimplemented
     virtual void mousePressEvent( QGraphicsSceneMouseEvent * );
@@ -93,49 +272,87 @@ private:
     virtual void mouseMoveEvent( QGraphicsSceneMouseEvent * );
 
     /**
-     * Returns cell item at (row,col).
-     * Always use this function instead hand-computing index in m_cells
-     */
-    inline CellItem* itemAt(int row, int col) { return m_cells.at( row*m_numCols + col ); }
-    /**
-     * Overloaded one, which takes QPair
+     * @return index of cell at (row,col), same in MineField
+     * and in the window of ChunkedMineField. -1 for holes
      */
-    inline CellItem* itemAt( const FieldPos& pos ) { return itemAt(pos.first,pos.second); }
+    inline int indexOf(int row, int col) const
+        { return m_endless ? row*columnCount() + col : m_field.indexOf(row,col); }
     /**
-     * Calculates (row,col) from given index in m_cells and returns them in QPair
+     * @return (row,col) of cell at idx
      */
-    inline FieldPos rowColFromIndex(int idx)
+    inline FieldPos rowColOf(int idx) const
         {
-            int row = idx/m_numCols;
-            return qMakePair(row, idx - row*m_numCols);
+            if(!m_endless)
+                return m_field.rowColFromIndex(idx);
+            const int row = idx/columnCount();
+            return qMakePair(row, idx - row*columnCount());
         }
     /**
-     * Generates game field ensuring that cell at clickedIdx
-     * will be empty to allow the player quickly jump into the game.
-     *
-     * @param clickedIdx specifies index which should NOT have mine and be empty
+     * @return number of cells shown
+     */
+    inline int cellCount() const { return m_endless ? rowCount()*columnCount() : m_field.cellCount(); }
+    /**
+     * @return whether there's a cell at (row,col), i.e. it's
+     * in the field and not in a hole
+     */
+    inline bool hasCellAt(int row, int col) const
+        { return row >= 0 && row < rowCount() && col >= 0 && col < columnCount() && indexOf(row,col) != -1; }
+    /**
+     * Creates, deletes or resets cell and border items for a field of given shape
+     */
+    void resizeItems(const BoardShape& shape);
+    /**
+     * Shows cell at idx as pressed if it is released or shows a hint
+     */
+    void pressCell(int idx);
+    /**
+     * Shows pressed cell at idx as it was before press
      */
-    void generateField(int clickedIdx);
+    void undoPressCell(int idx);
     /**
-     * Returns all adjasent items for item at row, col
+     * @return whether cell at idx is shown as pressed
      */
-    QList<CellItem*> adjasentItemsFor(int row, int col);
+    bool isCellPressed(int idx) const;
     /**
-     * Returns all valid adjasent row,col pairs for row, col
+     * Shows all released adjasent items for item at row, col as pressed
      */
-    QList<FieldPos> adjasentRowColsFor(int row, int col);
+    void pressAdjasentItems(int row, int col);
     /**
-     * Checks if player lost the game
+     * Shows pressed adjasent items for item at row, col as released again
      */
-    void checkLost();
+    void undoPressAdjasentItems(int row, int col);
     /**
-     * Checks if player won the game
+     * Makes cell items changed by the last action show
+     * their current state in m_field
      */
-    void checkWon();
+    void updateItems();
     /**
-     * Reveals all unmarked items containing mines
+     * Makes cell item at idx show its current state in m_field
      */
-    void revealAllMines();
+    void updateItem(int idx);
+    /**
+     * Makes all cell items show their current state,
+     * needed when the window of the endless mode changes
+     */
+    void updateAllItems();
+    /**
+     * Recomputes mine probabilities and moves hints to the safest cells
+     */
+    void updateHints();
+    /**
+     * Makes a move, records it and shows what it changed
+     */
+    void applyMove(ReplayRecorder::Action action, int idx);
+    /**
+     * Emits signals about flag count and game end if
+     * last action changed them
+     */
+    void checkFieldChanges();
+    /**
+     * Writes changes of the last action to the snapshot, creates it
+     * once the game starts and removes it when the game ends
+     */
+    void updateSnapshot();
     /**
      * Reimplemented from QGraphicsItem
      */
@@ -144,65 +361,87 @@ private:
      * Repositions all child cell items upon resizes
      */
     void adjustItemPositions();
-    /**
-     * Reveals all empty cells around cell at (row,col),
-     * until it found cells with digits (which are also revealed)
-     */
-    void revealEmptySpace(int row, int col);
     /**
      * Sets up border items (positions and properties)
      */
-    void setupBorderItems();
-
-    void onItemRevealed(int row, int col);
-    // overload
-    void onItemRevealed(CellItem* item);
+    void setupBorderItems(const QVector<BoardShape::BorderTile>& outline);
 
-    // note: in member functions use itemAt (see above )
-    // instead of hand-computing index from row & col!
-    // => not depend on how m_cells is represented
     /**
-     * Array which holds all child cell items
+     * Array which holds child cell items, by index of their cells
      */
     QVector<CellItem*> m_cells;
     /**
      * Array which holds border items
      */
     QVector<BorderItem*> m_borders;
+    /**
+     * Composited pixmaps of cells at current size,
+     * shared by cell items and the batched item
+     */
+    TileAtlas m_tileAtlas;
+    /**
+     * Item painting the whole field, used instead of cell
+     * and border items if m_batched is set
+     */
+    BatchedFieldItem* m_batchedItem;
+    bool m_batched;
     /**
      * The width and height of minefield cells in scene coordinates
      */
     int m_cellSize;
     /**
-     * Number of field rows
+     * Game engine holding the field state
+     */
+    MineField m_field;
+    /**
+     * Game engine of the endless mode, used instead of m_field
+     * if m_endless is set
+     */
+    ChunkedMineField m_chunkedField;
+    bool m_endless;
+    /**
+     * Log of player's actions, filled by mouse handlers
      */
-    int m_numRows;
+    ReplayRecorder m_recorder;
     /**
-     * Number of field columns
+     * Plays logs on m_field or m_chunkedField if m_replaying is set
      */
-    int m_numCols;
+    ReplayPlayer m_player;
+    bool m_replaying;
     /**
-     * Number of mines in field
+     * Game in progress kept in a file
      */
-    int m_minesCount;
+    GameSnapshot m_snapshot;
     /**
-     * Number of flagged mines
+     * Mine probabilities for hints
+     */
+    MineProbability m_probabilities;
+    /**
+     * Cells currently shown with a hint
+     */
+    QVector<int> m_hintCells;
+    QVector<bool> m_isHint;
+    bool m_showHints;
+    /**
+     * Number of flagged mines reported last time
      */
     int m_flaggedMinesCount;
     /**
-     * Random sequence used to generate mine positions
+     * Cell suggested for the first click, -1 if none
+     */
+    int m_startHintIdx;
+    /**
+     * First revealed cell waiting for generated mines, -1 if none
      */
-    KRandomSequence m_randomSeq;
+    int m_requestedStartIdx;
     /**
      * row and column where mouse was pressed.
      * (-1,-1) if it is already released
      */
     FieldPos m_leftButtonPos;
     FieldPos m_midButtonPos;
-    bool m_firstClick;
     bool m_gameOver;
     bool m_emulatingMidButton;
-    int m_numUnrevealed;
 
     KGameRenderer* m_renderer;
 };
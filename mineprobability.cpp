@@ -0,0 +1,718 @@
+/*
+    Copyright 2026 The KMines Authors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#include "mineprobability.h"
+
+#include <cmath>
+#include <limits>
+
+#include "minefield.h"
+
+MineProbability::MineProbability(const MineField* field)
+    : m_field(field), m_maxEnumerationSize(DEFAULT_MAX_ENUMERATION_SIZE),
+      m_sampleCount(DEFAULT_SAMPLE_COUNT), m_recomputedCount(0), m_exact(true),
+      m_current(0), m_width(0), m_nodes(0), m_nodeLimit(0),
+      m_random(1) // fixed seed, so that results can be repeated
+{
+    m_logFactorial.append(0);
+}
+
+void MineProbability::reset()
+{
+    m_components.clear();
+    m_componentByFirstCell.clear();
+}
+
+void MineProbability::update()
+{
+    const int numCells = m_field->cellCount();
+    if(m_probability.size() != numCells)
+    {
+        reset();
+        m_probability.fill(0, numCells);
+        m_localOf.fill(-1, numCells);
+    }
+    recompute();
+}
+
+bool MineProbability::isUnknown(int idx) const
+{
+    return !m_field->isRevealed(idx) && !m_field->isFlagged(idx);
+}
+
+bool MineProbability::isFree(int idx) const
+{
+    return m_forced.at(idx) == -1 && isUnknown(idx);
+}
+
+int MineProbability::propagate()
+{
+    const int numCells = m_field->cellCount();
+    m_forced.fill(-1, numCells);
+    m_queued.fill(0, numCells);
+    m_worklist.resize(0);
+    for(int idx=0; idx<numCells; ++idx)
+    {
+        if(m_field->isRevealed(idx))
+        {
+            m_worklist.append(idx);
+            m_queued[idx] = 1;
+        }
+    }
+
+    int forcedMines = 0;
+    int neighbours[MineField::MAX_NEIGHBOURS];
+    while(!m_worklist.isEmpty())
+    {
+        const int idx = m_worklist.last();
+        m_worklist.removeLast();
+        m_queued[idx] = 0;
+
+        const int count = m_field->adjasentCellsFor(idx, neighbours);
+        int need = m_field->digit(idx);
+        int free = 0;
+        for(int i=0; i<count; ++i)
+        {
+            if(m_field->isFlagged(neighbours[i]) || m_forced.at(neighbours[i]) == 1)
+                need--;
+            else
+                free += isFree(neighbours[i]);
+        }
+        // contradictions are left for counting, which will find no configuration
+        if(free == 0 || (need != 0 && need != free))
+            continue;
+
+        const bool mine = (need != 0);
+        for(int i=0; i<count; ++i)
+        {
+            if(isFree(neighbours[i]))
+            {
+                force(neighbours[i], mine);
+                forcedMines += mine;
+            }
+        }
+    }
+    return forcedMines;
+}
+
+void MineProbability::force(int idx, bool mine)
+{
+    m_forced[idx] = mine;
+    int neighbours[MineField::MAX_NEIGHBOURS];
+    const int count = m_field->adjasentCellsFor(idx, neighbours);
+    for(int i=0; i<count; ++i)
+    {
+        const int other = neighbours[i];
+        if(m_field->isRevealed(other) && !m_queued.at(other))
+        {
+            m_worklist.append(other);
+            m_queued[other] = 1;
+        }
+    }
+}
+
+void MineProbability::recompute()
+{
+    const int numCells = m_field->cellCount();
+    const int forcedMines = propagate();
+    m_componentOf.fill(-1, numCells);
+    m_constraintOf.fill(-1, numCells);
+    m_recomputedCount = 0;
+    m_exact = true;
+
+    QVector<Component> components;
+    QHash<int, int> componentByFirstCell;
+    int interiorCount = 0;
+    int neighbours[MineField::MAX_NEIGHBOURS];
+    int neighbours2[MineField::MAX_NEIGHBOURS];
+    Component component;
+
+    for(int idx=0; idx<numCells; ++idx)
+    {
+        if(!isFree(idx) || m_componentOf.at(idx) != -1)
+            continue;
+
+        bool onFrontier = false;
+        const int count = m_field->adjasentCellsFor(idx, neighbours);
+        for(int i=0; i<count && !onFrontier; ++i)
+            onFrontier = m_field->isRevealed(neighbours[i]);
+        if(!onFrontier)
+        {
+            interiorCount++;
+            continue;
+        }
+
+        // collect the component going from cells to the digits
+        // constraining them and from digits to their other cells.
+        // cells are visited in increasing order, so idx is the first one
+        const int id = components.size();
+        component.cells.resize(0);
+        component.constraints.resize(0);
+        component.needs.resize(0);
+        component.cells.append(idx);
+        m_componentOf[idx] = id;
+        for(int head=0; head<component.cells.size(); ++head)
+        {
+            const int numNeighbours = m_field->adjasentCellsFor(component.cells.at(head), neighbours);
+            for(int i=0; i<numNeighbours; ++i)
+            {
+                const int digitIdx = neighbours[i];
+                if(!m_field->isRevealed(digitIdx) || m_constraintOf.at(digitIdx) == id)
+                    continue;
+                m_constraintOf[digitIdx] = id;
+
+                int need = m_field->digit(digitIdx);
+                const int numCells2 = m_field->adjasentCellsFor(digitIdx, neighbours2);
+                for(int j=0; j<numCells2; ++j)
+                {
+                    const int other = neighbours2[j];
+                    if(m_field->isFlagged(other) || m_forced.at(other) == 1)
+                        need--;
+                    else if(isFree(other) && m_componentOf.at(other) == -1)
+                    {
+                        m_componentOf[other] = id;
+                        component.cells.append(other);
+                    }
+                }
+                component.constraints.append(digitIdx);
+                component.needs.append(need);
+            }
+        }
+
+        // same cells constrained by the same digits give the same results
+        const int cached = m_componentByFirstCell.value(idx, -1);
+        if(cached != -1 && m_components.at(cached).cells == component.cells &&
+           m_components.at(cached).constraints == component.constraints &&
+           m_components.at(cached).needs == component.needs)
+            components.append(m_components.at(cached));
+        else
+        {
+            computeComponent(&component);
+            components.append(component);
+            m_recomputedCount++;
+        }
+        m_exact = m_exact && components.last().exact;
+        componentByFirstCell.insert(idx, id);
+    }
+
+    m_components.swap(components);
+    m_componentByFirstCell.swap(componentByFirstCell);
+
+    combine(m_field->minesCount() - m_field->flaggedCount() - forcedMines, interiorCount);
+}
+
+void MineProbability::computeComponent(Component* component)
+{
+    const QVector<int>& cells = component->cells;
+    const int numCells = cells.size();
+    const int numConstraints = component->constraints.size();
+    int neighbours[MineField::MAX_NEIGHBOURS];
+
+    for(int i=0; i<numCells; ++i)
+        m_localOf[cells.at(i)] = i;
+
+    // build lists of constraints of every cell
+    m_need = component->needs;
+    m_unassigned.fill(0, numConstraints);
+    m_cellConstraintsStart.fill(0, numCells+1);
+    int sumNeed = 0;
+    for(int c=0; c<numConstraints; ++c)
+    {
+        const int count = m_field->adjasentCellsFor(component->constraints.at(c), neighbours);
+        for(int i=0; i<count; ++i)
+        {
+            if(isFree(neighbours[i]))
+            {
+                m_unassigned[c]++;
+                m_cellConstraintsStart[m_localOf.at(neighbours[i])+1]++;
+            }
+        }
+        sumNeed += qMax(0, m_need.at(c));
+    }
+    for(int i=0; i<numCells; ++i)
+        m_cellConstraintsStart[i+1] += m_cellConstraintsStart.at(i);
+    m_cellConstraints.resize(m_cellConstraintsStart.at(numCells));
+    QVector<int> fill = m_cellConstraintsStart;
+    for(int c=0; c<numConstraints; ++c)
+    {
+        const int count = m_field->adjasentCellsFor(component->constraints.at(c), neighbours);
+        for(int i=0; i<count; ++i)
+        {
+            if(isFree(neighbours[i]))
+                m_cellConstraints[fill[m_localOf.at(neighbours[i])]++] = c;
+        }
+    }
+
+    // every mine is counted by some digit, so they can't hold more
+    m_width = qMin(numCells, sumNeed) + 1;
+    component->weights.fill(0, m_width);
+    component->hits.fill(0, numCells*m_width);
+    m_assignment.fill(0, numCells);
+    m_current = component;
+
+    component->exact = (numCells <= m_maxEnumerationSize) && countConfigurations();
+    if(!component->exact)
+    {
+        component->weights.fill(0);
+        component->hits.fill(0);
+        for(int i=0; i<m_sampleCount; ++i)
+        {
+            m_nodes = 0;
+            m_nodeLimit = qMax(1000, 10*numCells);
+            sample(0, 0);
+        }
+    }
+
+    for(int i=0; i<numCells; ++i)
+        m_localOf[cells.at(i)] = -1;
+
+    // keep only mine counts which actually happen
+    int minMines = 0;
+    while(minMines < m_width && component->weights.at(minMines) == 0)
+        minMines++;
+    int maxMines = m_width-1;
+    while(maxMines > minMines && component->weights.at(maxMines) == 0)
+        maxMines--;
+    if(minMines == m_width)
+    {
+        // no configuration at all, flags must be wrong
+        component->minMines = 0;
+        component->weights.fill(0, 1);
+        component->hits.fill(0, numCells);
+        return;
+    }
+    const int width = maxMines - minMines + 1;
+    QVector<double> hits(numCells*width);
+    for(int i=0; i<numCells; ++i)
+        for(int k=0; k<width; ++k)
+            hits[i*width + k] = component->hits.at(i*m_width + minMines + k);
+    component->minMines = minMines;
+    component->weights = component->weights.mid(minMines, width);
+    component->hits = hits;
+}
+
+bool MineProbability::assign(int pos, bool mine)
+{
+    // all constraints are updated even if one fails, unassign() reverts them all
+    bool valid = true;
+    m_assignment[pos] = mine;
+    const int end = m_cellConstraintsStart.at(pos+1);
+    for(int i=m_cellConstraintsStart.at(pos); i<end; ++i)
+    {
+        const int c = m_cellConstraints.at(i);
+        m_unassigned[c]--;
+        if(mine)
+            m_need[c]--;
+        if(m_need.at(c) < 0 || m_need.at(c) > m_unassigned.at(c))
+            valid = false;
+    }
+    return valid;
+}
+
+void MineProbability::unassign(int pos, bool mine)
+{
+    m_assignment[pos] = 0;
+    const int end = m_cellConstraintsStart.at(pos+1);
+    for(int i=m_cellConstraintsStart.at(pos); i<end; ++i)
+    {
+        const int c = m_cellConstraints.at(i);
+        m_unassigned[c]++;
+        if(mine)
+            m_need[c]++;
+    }
+}
+
+bool MineProbability::countConfigurations()
+{
+    const int numCells = m_current->cells.size();
+    const int numConstraints = m_need.size();
+
+    // find where every constraint starts and ends
+    m_firstCell.fill(-1, numConstraints);
+    m_lastCell.fill(-1, numConstraints);
+    m_unassignedAfter.resize(m_cellConstraints.size());
+    QVector<int> assigned(numConstraints, 0);
+    for(int pos=0; pos<numCells; ++pos)
+    {
+        for(int i=m_cellConstraintsStart.at(pos); i<m_cellConstraintsStart.at(pos+1); ++i)
+        {
+            const int c = m_cellConstraints.at(i);
+            if(m_firstCell.at(c) == -1)
+                m_firstCell[c] = pos;
+            m_lastCell[c] = pos;
+            m_unassignedAfter[i] = m_unassigned.at(c) - ++assigned[c];
+        }
+    }
+    m_activeSlot.fill(-1, numConstraints);
+    m_scratchNeed.resize(numConstraints);
+    m_touchedBy.fill(-1, numConstraints);
+
+    // forward: count partial configurations of cells [0,pos) by mines
+    m_layers.resize(numCells+1);
+    for(int pos=0; pos<=numCells; ++pos)
+    {
+        Layer& layer = m_layers[pos];
+        layer.active.resize(0);
+        layer.states.resize(0);
+        layer.stateIndex.clear();
+        layer.counts.resize(0);
+    }
+    m_layers[0].states.append(QByteArray());
+    m_layers[0].stateIndex.insert(QByteArray(), 0);
+    m_layers[0].counts.fill(0, m_width);
+    m_layers[0].counts[0] = 1;
+
+    QByteArray nextState;
+    for(int pos=0; pos<numCells; ++pos)
+    {
+        const Layer& layer = m_layers.at(pos);
+        Layer& next = m_layers[pos+1];
+
+        // constraints ending here are done, the ones starting here join
+        foreach(int c, layer.active)
+        {
+            if(m_lastCell.at(c) != pos)
+                next.active.append(c);
+        }
+        for(int i=m_cellConstraintsStart.at(pos); i<m_cellConstraintsStart.at(pos+1); ++i)
+        {
+            const int c = m_cellConstraints.at(i);
+            if(m_firstCell.at(c) == pos && m_lastCell.at(c) != pos)
+                next.active.append(c);
+        }
+        setActive(layer.active);
+
+        for(int s=0; s<layer.states.size(); ++s)
+        {
+            const double* counts = layer.counts.constData() + s*m_width;
+            for(int mine=0; mine<2; ++mine)
+            {
+                if(!transition(pos, mine, layer.states.at(s), next.active, &nextState))
+                    continue;
+                int target = next.stateIndex.value(nextState, -1);
+                if(target == -1)
+                {
+                    target = next.states.size();
+                    next.states.append(nextState);
+                    next.stateIndex.insert(nextState, target);
+                    next.counts.resize(next.counts.size() + m_width);
+                    for(int k=0; k<m_width; ++k)
+                        next.counts[target*m_width + k] = 0;
+                }
+                double* nextCounts = next.counts.data() + target*m_width;
+                for(int k=0; k+mine<m_width; ++k)
+                    nextCounts[k+mine] += counts[k];
+            }
+        }
+        if(next.states.size() > MAX_LAYER_STATES)
+            return false;
+    }
+
+    // all constraints are done after the last cell, so there's at most one state
+    const Layer& last = m_layers.at(numCells);
+    if(last.states.isEmpty())
+        return true; // no configuration
+    for(int k=0; k<m_width; ++k)
+        m_current->weights[k] = last.counts.at(k);
+
+    // backward: count configurations of cells [pos,numCells) leading
+    // from each state to the end. a cell holds mine in configurations
+    // made of a forward part, mine and a backward part
+    QVector<double> after(m_width, 0);
+    after[0] = 1;
+    QVector<double> before;
+    double* hits = m_current->hits.data();
+    for(int pos=numCells-1; pos>=0; --pos)
+    {
+        const Layer& layer = m_layers.at(pos);
+        const Layer& next = m_layers.at(pos+1);
+        setActive(layer.active);
+        before.fill(0, layer.states.size()*m_width);
+
+        for(int s=0; s<layer.states.size(); ++s)
+        {
+            const double* counts = layer.counts.constData() + s*m_width;
+            for(int mine=0; mine<2; ++mine)
+            {
+                if(!transition(pos, mine, layer.states.at(s), next.active, &nextState))
+                    continue;
+                const double* rest = after.constData() + next.stateIndex.value(nextState)*m_width;
+                for(int k=0; k+mine<m_width; ++k)
+                    before[s*m_width + k + mine] += rest[k];
+                if(!mine)
+                    continue;
+                for(int a=0; a<m_width; ++a)
+                {
+                    if(counts[a] == 0)
+                        continue;
+                    for(int b=0; a+1+b<m_width; ++b)
+                        hits[pos*m_width + a+1+b] += counts[a] * rest[b];
+                }
+            }
+        }
+        after.swap(before);
+    }
+    return true;
+}
+
+bool MineProbability::transition(int pos, bool mine, const QByteArray& state,
+                                 const QVector<int>& nextActive, QByteArray* nextState)
+{
+    for(int i=m_cellConstraintsStart.at(pos); i<m_cellConstraintsStart.at(pos+1); ++i)
+    {
+        const int c = m_cellConstraints.at(i);
+        const int slot = m_activeSlot.at(c);
+        const int need = (slot == -1 ? m_need.at(c) : state.at(slot)) - mine;
+        if(need < 0 || need > m_unassignedAfter.at(i))
+            return false;
+        m_scratchNeed[c] = need;
+        m_touchedBy[c] = pos;
+    }
+
+    nextState->resize(nextActive.size());
+    char* data = nextState->data();
+    for(int i=0; i<nextActive.size(); ++i)
+    {
+        const int c = nextActive.at(i);
+        data[i] = (m_touchedBy.at(c) == pos) ? m_scratchNeed.at(c) : state.at(m_activeSlot.at(c));
+    }
+    return true;
+}
+
+void MineProbability::setActive(const QVector<int>& active)
+{
+    m_activeSlot.fill(-1);
+    for(int i=0; i<active.size(); ++i)
+        m_activeSlot[active.at(i)] = i;
+}
+
+bool MineProbability::sample(int pos, int mines)
+{
+    if(++m_nodes > m_nodeLimit)
+        return false;
+    if(pos == m_current->cells.size())
+    {
+        record(mines);
+        return true;
+    }
+
+    // random order of values gives a random configuration
+    const bool first = m_random.getLong(2);
+    for(int i=0; i<2; ++i)
+    {
+        const bool mine = (i == 0) ? first : !first;
+        const bool found = assign(pos, mine) && sample(pos+1, mines+mine);
+        unassign(pos, mine);
+        if(found)
+            return true;
+    }
+    return false;
+}
+
+void MineProbability::record(int mines)
+{
+    m_current->weights[mines] += 1;
+    double* hits = m_current->hits.data();
+    const int numCells = m_current->cells.size();
+    for(int i=0; i<numCells; ++i)
+    {
+        if(m_assignment.at(i))
+            hits[i*m_width + mines] += 1;
+    }
+}
+
+void MineProbability::combine(int remainingMines, int interiorCount)
+{
+    const int numCells = m_field->cellCount();
+    for(int idx=0; idx<numCells; ++idx)
+    {
+        if(m_field->isFlagged(idx))
+            m_probability[idx] = 1;
+        else if(m_field->isRevealed(idx))
+            m_probability[idx] = 0;
+        else if(m_forced.at(idx) != -1)
+            m_probability[idx] = m_forced.at(idx);
+    }
+
+    m_tree.resize(0);
+    const int root = m_components.isEmpty() ? -1 : buildTree(0, m_components.size());
+    Distribution total;
+    total.offset = 0;
+    total.values.fill(1, 1);
+    if(root != -1)
+        total = m_tree.at(root).up;
+
+    // weight of the interior for each number of mines on the frontier.
+    // binomials get huge, so they are scaled by the biggest one
+    const int length = total.values.size();
+    QVector<double> outside(length);
+    double maxLog = -std::numeric_limits<double>::infinity();
+    for(int j=0; j<length; ++j)
+    {
+        outside[j] = logBinomial(interiorCount, remainingMines - (total.offset + j));
+        maxLog = qMax(maxLog, outside.at(j));
+    }
+    if(std::isinf(maxLog))
+    {
+        setUniformProbabilities(remainingMines);
+        return;
+    }
+
+    double weight = 0;
+    double interiorMines = 0;
+    for(int j=0; j<length; ++j)
+    {
+        outside[j] = std::exp(outside.at(j) - maxLog);
+        const double w = total.values.at(j) * outside.at(j);
+        weight += w;
+        interiorMines += w * (remainingMines - (total.offset + j));
+    }
+    if(!(weight > 0))
+    {
+        setUniformProbabilities(remainingMines);
+        return;
+    }
+
+    const double interiorProbability = interiorCount ? interiorMines / weight / interiorCount : 0;
+    for(int idx=0; idx<numCells; ++idx)
+    {
+        if(isFree(idx) && m_componentOf.at(idx) == -1)
+            m_probability[idx] = interiorProbability;
+    }
+
+    if(root != -1)
+        passDown(root, outside);
+}
+
+int MineProbability::buildTree(int first, int last)
+{
+    const int node = m_tree.size();
+    m_tree.append(TreeNode());
+    if(last - first == 1)
+    {
+        Distribution up;
+        up.offset = m_components.at(first).minMines;
+        up.values = m_components.at(first).weights;
+        normalize(&up.values);
+        m_tree[node].up = up;
+        m_tree[node].left = -1;
+        m_tree[node].right = -1;
+        m_tree[node].component = first;
+        return node;
+    }
+
+    const int middle = (first + last) / 2;
+    const int left = buildTree(first, middle);
+    const int right = buildTree(middle, last);
+    const Distribution& a = m_tree.at(left).up;
+    const Distribution& b = m_tree.at(right).up;
+
+    Distribution up;
+    up.offset = a.offset + b.offset;
+    up.values.fill(0, a.values.size() + b.values.size() - 1);
+    for(int i=0; i<a.values.size(); ++i)
+        for(int j=0; j<b.values.size(); ++j)
+            up.values[i+j] += a.values.at(i) * b.values.at(j);
+    normalize(&up.values);
+
+    m_tree[node].up = up;
+    m_tree[node].left = left;
+    m_tree[node].right = right;
+    m_tree[node].component = -1;
+    return node;
+}
+
+void MineProbability::passDown(int node, const QVector<double>& outside)
+{
+    const TreeNode current = m_tree.at(node);
+    if(current.component != -1)
+    {
+        setComponentProbabilities(current.component, outside);
+        return;
+    }
+
+    // the rest of the field as seen by one child is its sibling
+    // combined with the rest of the field as seen by the parent
+    for(int side=0; side<2; ++side)
+    {
+        const int child = side ? current.right : current.left;
+        const QVector<double>& sibling = m_tree.at(side ? current.left : current.right).up.values;
+        QVector<double> childOutside(m_tree.at(child).up.values.size(), 0);
+        for(int j=0; j<childOutside.size(); ++j)
+        {
+            double sum = 0;
+            for(int m=0; m<sibling.size(); ++m)
+                sum += sibling.at(m) * outside.at(j+m);
+            childOutside[j] = sum;
+        }
+        normalize(&childOutside);
+        passDown(child, childOutside);
+    }
+}
+
+void MineProbability::setComponentProbabilities(int component, const QVector<double>& outside)
+{
+    const Component& c = m_components.at(component);
+    const int width = c.weights.size();
+    double weight = 0;
+    for(int k=0; k<width; ++k)
+        weight += c.weights.at(k) * outside.at(k);
+
+    for(int i=0; i<c.cells.size(); ++i)
+    {
+        double hits = 0;
+        for(int k=0; k<width; ++k)
+            hits += c.hits.at(i*width + k) * outside.at(k);
+        m_probability[c.cells.at(i)] = weight > 0 ? hits / weight : 0;
+    }
+}
+
+void MineProbability::setUniformProbabilities(int remainingMines)
+{
+    const int numCells = m_field->cellCount();
+    int unknownCount = 0;
+    for(int idx=0; idx<numCells; ++idx)
+        unknownCount += isFree(idx);
+    const double probability = unknownCount ? qBound(0.0, double(remainingMines) / unknownCount, 1.0) : 0;
+    for(int idx=0; idx<numCells; ++idx)
+    {
+        if(isFree(idx))
+            m_probability[idx] = probability;
+    }
+    m_exact = false;
+}
+
+double MineProbability::logBinomial(int n, int k)
+{
+    if(n < 0 || k < 0 || k > n)
+        return -std::numeric_limits<double>::infinity();
+    while(m_logFactorial.size() <= n)
+        m_logFactorial.append(m_logFactorial.last() + std::log(double(m_logFactorial.size())));
+    return m_logFactorial.at(n) - m_logFactorial.at(k) - m_logFactorial.at(n-k);
+}
+
+void MineProbability::normalize(QVector<double>* values)
+{
+    double maxValue = 0;
+    for(int i=0; i<values->size(); ++i)
+        maxValue = qMax(maxValue, values->at(i));
+    if(maxValue > 0)
+    {
+        for(int i=0; i<values->size(); ++i)
+            (*values)[i] /= maxValue;
+    }
+}
@@ -0,0 +1,328 @@
+/*
+    Copyright 2026 The KMines Authors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#ifndef MINEPROBABILITY_H
+#define MINEPROBABILITY_H
+
+#include <QVector>
+#include <QHash>
+#include <QByteArray>
+
+#include <KRandomSequence>
+
+class MineField;
+
+/**
+ * Computes probability that each unrevealed cell of a MineField holds
+ * mine. Like MineSolver it only looks at what a player can see: revealed
+ * digits, flags (which are assumed to be right) and the total number
+ * of mines.
+ *
+ * First, cells forced by a single digit (a digit which needs no more
+ * mines or needs all its unknown neighbours) are settled, repeating until
+ * nothing changes. Remaining unknown cells next to revealed digits (the
+ * frontier) are split into independent components. Mine configurations
+ * of every component are counted by number of mines they use. Cells are
+ * assigned one by one and partial configurations leaving the same mines
+ * to be placed around the digits are merged, so long chains of cells
+ * don't blow up. Components and the remaining cells (the interior) are
+ * then combined, weighting each combination by the number of ways to
+ * place the rest of the mines in the interior. Components which are too
+ * big to count are sampled instead, which makes their probabilities
+ * approximate.
+ *
+ * Results of a component are kept as long as its cells and the mines
+ * its digits need stay the same, so after a single reveal only the
+ * components around it are counted again.
+ */
+class MineProbability
+{
+public:
+    /**
+     * Constructor
+     *
+     * @param field field to look at. Must outlive this object
+     */
+    explicit MineProbability(const MineField* field);
+    /**
+     * Forgets all cached results
+     */
+    void reset();
+    /**
+     * Recomputes probabilities after the field has changed.
+     * Components which haven't changed are taken from the cache
+     */
+    void update();
+    /**
+     * @return probability that cell at idx holds mine.
+     * 0 for revealed cells, 1 for flagged ones
+     */
+    double probability(int idx) const { return m_probability.at(idx); }
+    /**
+     * @return false if some probabilities come from sampling
+     */
+    bool isExact() const { return m_exact; }
+    /**
+     * @return number of frontier components after the last update
+     */
+    int componentCount() const { return m_components.size(); }
+    /**
+     * @return number of components counted by the last update,
+     * the others were taken from the cache
+     */
+    int recomputedCount() const { return m_recomputedCount; }
+    /**
+     * Sets maximal number of cells in a component which will be
+     * counted exactly. Bigger components are sampled
+     */
+    void setMaxEnumerationSize(int size) { m_maxEnumerationSize = size; }
+    /**
+     * Sets number of configurations sampled for a big component
+     */
+    void setSampleCount(int count) { m_sampleCount = count; }
+
+    /**
+     * Default value for setMaxEnumerationSize()
+     */
+    static const int DEFAULT_MAX_ENUMERATION_SIZE = 400;
+    /**
+     * Default value for setSampleCount()
+     */
+    static const int DEFAULT_SAMPLE_COUNT = 2000;
+    /**
+     * Components which need more partial configurations
+     * after some cell are sampled
+     */
+    static const int MAX_LAYER_STATES = 4096;
+private:
+    /**
+     * Cached results of a single frontier component
+     */
+    struct Component
+    {
+        /**
+         * Cells of the component, the first one has the lowest index
+         */
+        QVector<int> cells;
+        /**
+         * Digits constraining the cells and how many mines they still need
+         */
+        QVector<int> constraints;
+        QVector<int> needs;
+        /**
+         * Number of mines used by weights[0]
+         */
+        int minMines;
+        /**
+         * Number of configurations using minMines+k mines, at index k
+         */
+        QVector<double> weights;
+        /**
+         * Number of configurations using minMines+k mines which put mine
+         * to cells[i], at index i*weights.size()+k
+         */
+        QVector<double> hits;
+        bool exact;
+    };
+    /**
+     * Numbers of configurations by number of mines they use, scaled by
+     * an arbitrary factor
+     */
+    struct Distribution
+    {
+        int offset;
+        QVector<double> values;
+    };
+    /**
+     * Partial configurations after the first few cells of a component.
+     * A state holds needed mines of digits which have cells on both
+     * sides, all configurations leading to it share one distribution
+     */
+    struct Layer
+    {
+        /**
+         * Digits with cells on both sides, by index of constraint
+         */
+        QVector<int> active;
+        QVector<QByteArray> states;
+        QHash<QByteArray, int> stateIndex;
+        /**
+         * Number of configurations by mines, m_width values per state
+         */
+        QVector<double> counts;
+    };
+    /**
+     * Node of the tree combining components
+     */
+    struct TreeNode
+    {
+        /**
+         * Combined distribution of all components below this node
+         */
+        Distribution up;
+        int left;
+        int right;
+        int component;
+    };
+
+    /**
+     * @return whether cell at idx is neither revealed nor flagged
+     */
+    bool isUnknown(int idx) const;
+    /**
+     * @return whether cell at idx is unknown and not forced by propagate()
+     */
+    bool isFree(int idx) const;
+    /**
+     * Settles cells forced by a single digit
+     * @return number of forced mines
+     */
+    int propagate();
+    /**
+     * Forces value of cell at idx and queues digits around it
+     */
+    void force(int idx, bool mine);
+    /**
+     * Splits the frontier into components, reusing cached ones where
+     * possible, and combines them with the interior
+     */
+    void recompute();
+    /**
+     * Counts or samples configurations of given component
+     */
+    void computeComponent(Component* component);
+    /**
+     * Counts configurations of the component in m_current exactly
+     * @return false if there were too many states
+     */
+    bool countConfigurations();
+    /**
+     * Puts value to local cell pos, going from state of layer pos
+     * to a state of layer pos+1
+     * @return false if some constraint can't be satisfied anymore
+     */
+    bool transition(int pos, bool mine, const QByteArray& state, const QVector<int>& nextActive,
+                    QByteArray* nextState);
+    /**
+     * Makes m_activeSlot describe given layer
+     */
+    void setActive(const QVector<int>& active);
+    /**
+     * Looks for a single random configuration
+     * @return false if none was found
+     */
+    bool sample(int pos, int mines);
+    /**
+     * Tries to put value to local cell pos
+     * @return false if some constraint can't be satisfied anymore
+     */
+    bool assign(int pos, bool mine);
+    /**
+     * Reverts assign()
+     */
+    void unassign(int pos, bool mine);
+    /**
+     * Counts configuration in m_assignment found by sample()
+     */
+    void record(int mines);
+    /**
+     * Combines components, sets probabilities of all cells
+     */
+    void combine(int remainingMines, int interiorCount);
+    /**
+     * Builds combining tree over components [first,last)
+     * @return index of the root node in m_tree
+     */
+    int buildTree(int first, int last);
+    /**
+     * Passes information about the rest of the field down the tree.
+     * outside[j] is weight of the rest of the field if the subtree
+     * uses node.up.offset+j mines
+     */
+    void passDown(int node, const QVector<double>& outside);
+    /**
+     * Sets probabilities of cells of the component
+     */
+    void setComponentProbabilities(int component, const QVector<double>& outside);
+    /**
+     * Gives up and spreads remaining mines evenly, used when flags
+     * contradict digits
+     */
+    void setUniformProbabilities(int remainingMines);
+    /**
+     * @return log of binomial coefficient, -infinity if k is out of range
+     */
+    double logBinomial(int n, int k);
+    /**
+     * Divides values by their maximum
+     */
+    static void normalize(QVector<double>* values);
+
+    const MineField* m_field;
+    int m_maxEnumerationSize;
+    int m_sampleCount;
+    int m_recomputedCount;
+    bool m_exact;
+    QVector<double> m_probability;
+    /**
+     * Value forced by propagate(): 0 - safe, 1 - mine, -1 - not forced
+     */
+    QVector<qint8> m_forced;
+    QVector<Component> m_components;
+    /**
+     * Index in m_components by first cell of the component
+     */
+    QHash<int, int> m_componentByFirstCell;
+    /**
+     * Memoized log(n!), grows as needed
+     */
+    QVector<double> m_logFactorial;
+    QVector<TreeNode> m_tree;
+
+    // component splitting state, kept here to avoid allocations
+    QVector<int> m_componentOf;
+    QVector<int> m_constraintOf;
+    QVector<int> m_queue;
+    QVector<int> m_worklist;
+    QVector<quint8> m_queued;
+
+    // counting state
+    QVector<int> m_localOf;
+    QVector<int> m_need;
+    QVector<int> m_unassigned;
+    QVector<int> m_cellConstraintsStart;
+    QVector<int> m_cellConstraints;
+    /**
+     * Unassigned cells of constraint m_cellConstraints[i]
+     * once its cell is assigned
+     */
+    QVector<int> m_unassignedAfter;
+    QVector<int> m_firstCell;
+    QVector<int> m_lastCell;
+    QVector<int> m_activeSlot;
+    QVector<int> m_scratchNeed;
+    QVector<int> m_touchedBy;
+    QVector<Layer> m_layers;
+    QVector<quint8> m_assignment;
+    Component* m_current;
+    int m_width;
+    int m_nodes;
+    int m_nodeLimit;
+    KRandomSequence m_random;
+};
+
+#endif
@@ -0,0 +1,492 @@
+/*
+    Copyright 2026 The KMines Authors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#include "minesolver.h"
+
+#include "minefield.h"
+
+/**
+ * Enumeration of a single component gives up after visiting that many nodes
+ */
+static const qint64 MAX_ENUMERATION_NODES = 200000;
+
+MineSolver::MineSolver(MineField* field)
+    : m_field(field), m_maxComponentSize(DEFAULT_MAX_COMPONENT_SIZE), m_knownMinesCount(0),
+      m_revealCount(0), m_enumCells(0), m_enumCount(0), m_solutions(0), m_nodes(0),
+      m_remainingMines(0), m_mustUseAllMines(false)
+{
+}
+
+void MineSolver::reset()
+{
+    const int numCells = m_field->cellCount();
+    m_knownMine.fill(0, numCells);
+    m_queued.fill(0, numCells);
+    m_deduced.fill(0, numCells);
+    m_constraintOf.fill(-1, numCells);
+    m_componentOf.fill(-1, numCells);
+    m_worklist.resize(0);
+    m_worklist.reserve(numCells);
+    m_deducedCells.resize(0);
+    m_knownMinesCount = 0;
+    m_revealCount = 0;
+}
+
+bool MineSolver::solve()
+{
+    if(m_knownMine.size() != m_field->cellCount())
+        reset();
+
+    // the field might have been changed from outside,
+    // so everything revealed has to be looked at
+    m_worklist.resize(0);
+    m_queued.fill(0);
+    for(int idx=0; idx<m_field->cellCount(); ++idx)
+        enqueue(idx);
+
+    while(!m_field->isGameOver())
+    {
+        while(!m_worklist.isEmpty() && !m_field->isGameOver())
+        {
+            const int idx = m_worklist.last();
+            m_worklist.removeLast();
+            m_queued[idx] = 0;
+            applySingleRules(idx);
+        }
+        if(m_field->isGameOver())
+            break;
+
+        // simple rules are stuck, try the more expensive ones
+        if(!applyPairRules() && !applyEnumeration() && !applyGlobalRule())
+            break;
+    }
+    return m_field->isWon();
+}
+
+bool MineSolver::isUnknown(int idx) const
+{
+    return !m_field->isRevealed(idx) && !m_knownMine.at(idx);
+}
+
+void MineSolver::enqueue(int idx)
+{
+    if(m_queued.at(idx) || !m_field->isRevealed(idx) || m_field->digit(idx) == 0)
+        return;
+    m_queued[idx] = 1;
+    m_worklist.append(idx);
+}
+
+void MineSolver::enqueueNeighbours(int idx)
+{
+    int neighbours[MineField::MAX_NEIGHBOURS];
+    const int count = m_field->adjasentCellsFor(idx, neighbours);
+    for(int i=0; i<count; ++i)
+        enqueue(neighbours[i]);
+}
+
+bool MineSolver::revealSafe(int idx)
+{
+    if(!m_field->reveal(idx))
+        return false;
+    m_revealCount++;
+
+    // revealed cells are new constraints, and digits around
+    // them have one unknown neighbour less
+    foreach(int changed, m_field->changedCells())
+    {
+        enqueue(changed);
+        enqueueNeighbours(changed);
+    }
+    return true;
+}
+
+bool MineSolver::markMine(int idx)
+{
+    if(m_knownMine.at(idx))
+        return false;
+    m_knownMine[idx] = 1;
+    m_knownMinesCount++;
+    enqueueNeighbours(idx);
+    return true;
+}
+
+bool MineSolver::buildConstraint(int idx, Constraint* constraint) const
+{
+    if(!m_field->isRevealed(idx) || m_field->digit(idx) == 0)
+        return false;
+
+    int neighbours[MineField::MAX_NEIGHBOURS];
+    const int count = m_field->adjasentCellsFor(idx, neighbours);
+
+    constraint->idx = idx;
+    constraint->numCells = 0;
+    constraint->mines = m_field->digit(idx);
+    for(int i=0; i<count; ++i)
+    {
+        const int neighbour = neighbours[i];
+        if(m_knownMine.at(neighbour))
+            constraint->mines--;
+        else if(!m_field->isRevealed(neighbour))
+            constraint->cells[constraint->numCells++] = neighbour;
+    }
+    // inconsistent constraints can't come from a real field,
+    // but let's not trust that
+    return constraint->numCells != 0 && constraint->mines >= 0
+        && constraint->mines <= constraint->numCells;
+}
+
+void MineSolver::applySingleRules(int idx)
+{
+    Constraint constraint;
+    if(!buildConstraint(idx, &constraint))
+        return;
+
+    if(constraint.mines == 0)
+    {
+        // all mines around are known, the rest is safe
+        for(int i=0; i<constraint.numCells; ++i)
+            revealSafe(constraint.cells[i]);
+    }
+    else if(constraint.mines == constraint.numCells)
+    {
+        // every unknown neighbour must be a mine
+        for(int i=0; i<constraint.numCells; ++i)
+            markMine(constraint.cells[i]);
+    }
+}
+
+void MineSolver::collectConstraints()
+{
+    m_constraints.resize(0);
+    Constraint constraint;
+    for(int idx=0; idx<m_field->cellCount(); ++idx)
+    {
+        if(buildConstraint(idx, &constraint))
+        {
+            m_constraintOf[idx] = m_constraints.size();
+            m_constraints.append(constraint);
+        }
+        else
+            m_constraintOf[idx] = -1;
+    }
+}
+
+void MineSolver::deduce(int idx, bool mine)
+{
+    if(m_deduced.at(idx))
+        return;
+    m_deduced[idx] = mine ? 2 : 1;
+    m_deducedCells.append(idx);
+}
+
+bool MineSolver::applyDeductions()
+{
+    bool changed = false;
+    foreach(int idx, m_deducedCells)
+    {
+        if(m_deduced.at(idx) == 2)
+            changed |= markMine(idx);
+        else
+            changed |= revealSafe(idx);
+        m_deduced[idx] = 0;
+    }
+    m_deducedCells.resize(0);
+    return changed;
+}
+
+bool MineSolver::applyPairRules()
+{
+    collectConstraints();
+
+    const int numRows = m_field->rowCount();
+    const int numCols = m_field->columnCount();
+    for(int i=0; i<m_constraints.size(); ++i)
+    {
+        const Constraint& a = m_constraints.at(i);
+        const FieldPos pos = m_field->rowColFromIndex(a.idx);
+
+        // digits sharing unknown cells are at most two cells apart
+        for(int row=qMax(pos.first-2, 0); row<=qMin(pos.first+2, numRows-1); ++row)
+            for(int col=qMax(pos.second-2, 0); col<=qMin(pos.second+2, numCols-1); ++col)
+            {
+                const int idx = m_field->indexOf(row,col);
+                if(idx == -1)
+                    continue; // hole of a shaped field
+                const int j = m_constraintOf.at(idx);
+                if(j <= i)
+                    continue; // each pair once
+                const Constraint& b = m_constraints.at(j);
+
+                int common[8], onlyA[8], onlyB[8];
+                int numCommon = 0, numOnlyA = 0, numOnlyB = 0;
+                for(int k=0; k<a.numCells; ++k)
+                {
+                    bool shared = false;
+                    for(int l=0; l<b.numCells; ++l)
+                        shared |= (a.cells[k] == b.cells[l]);
+                    if(shared)
+                        common[numCommon++] = a.cells[k];
+                    else
+                        onlyA[numOnlyA++] = a.cells[k];
+                }
+                if(numCommon == 0)
+                    continue;
+                for(int l=0; l<b.numCells; ++l)
+                {
+                    bool shared = false;
+                    for(int k=0; k<numCommon; ++k)
+                        shared |= (b.cells[l] == common[k]);
+                    if(!shared)
+                        onlyB[numOnlyB++] = b.cells[l];
+                }
+
+                // bounds of number of mines in common cells
+                const int minCommon = qMax(qMax(0, a.mines - numOnlyA), b.mines - numOnlyB);
+                const int maxCommon = qMin(qMin(numCommon, a.mines), b.mines);
+                if(minCommon > maxCommon)
+                    continue;
+
+                if(a.mines - minCommon == 0)
+                    for(int k=0; k<numOnlyA; ++k)
+                        deduce(onlyA[k], false);
+                else if(a.mines - maxCommon == numOnlyA)
+                    for(int k=0; k<numOnlyA; ++k)
+                        deduce(onlyA[k], true);
+
+                if(b.mines - minCommon == 0)
+                    for(int k=0; k<numOnlyB; ++k)
+                        deduce(onlyB[k], false);
+                else if(b.mines - maxCommon == numOnlyB)
+                    for(int k=0; k<numOnlyB; ++k)
+                        deduce(onlyB[k], true);
+
+                if(maxCommon == 0)
+                    for(int k=0; k<numCommon; ++k)
+                        deduce(common[k], false);
+                else if(minCommon == numCommon)
+                    for(int k=0; k<numCommon; ++k)
+                        deduce(common[k], true);
+            }
+    }
+    return applyDeductions();
+}
+
+int MineSolver::collectComponents()
+{
+    collectConstraints();
+
+    m_componentOf.fill(-1);
+    m_constraintComponent.fill(-1, m_constraints.size());
+    m_componentCells.resize(0);
+    m_componentCellStarts.resize(0);
+    m_componentConstraints.resize(0);
+    m_componentConstraintStarts.resize(0);
+
+    int neighbours[MineField::MAX_NEIGHBOURS];
+    int numComponents = 0;
+    for(int seed=0; seed<m_constraints.size(); ++seed)
+    {
+        if(m_constraintComponent.at(seed) != -1)
+            continue;
+
+        // breadth-first walk over constraints sharing cells
+        const int component = numComponents++;
+        m_componentCellStarts.append(m_componentCells.size());
+        m_componentConstraintStarts.append(m_componentConstraints.size());
+        m_constraintComponent[seed] = component;
+        m_componentConstraints.append(seed);
+        for(int head=m_componentConstraintStarts.last(); head<m_componentConstraints.size(); ++head)
+        {
+            const Constraint& constraint = m_constraints.at(m_componentConstraints.at(head));
+            for(int k=0; k<constraint.numCells; ++k)
+            {
+                const int cell = constraint.cells[k];
+                if(m_componentOf.at(cell) != -1)
+                    continue;
+                m_componentOf[cell] = component;
+                m_componentCells.append(cell);
+
+                const int count = m_field->adjasentCellsFor(cell, neighbours);
+                for(int i=0; i<count; ++i)
+                {
+                    const int other = m_constraintOf.at(neighbours[i]);
+                    if(other != -1 && m_constraintComponent.at(other) == -1)
+                    {
+                        m_constraintComponent[other] = component;
+                        m_componentConstraints.append(other);
+                    }
+                }
+            }
+        }
+    }
+    m_componentCellStarts.append(m_componentCells.size());
+    m_componentConstraintStarts.append(m_componentConstraints.size());
+    return numComponents;
+}
+
+bool MineSolver::applyEnumeration()
+{
+    const int numComponents = collectComponents();
+    if(numComponents == 0)
+        return false;
+
+    // unknown cells which are not next to any digit
+    const int numUnknown = m_field->unrevealedCount() - m_knownMinesCount;
+    const int numInterior = numUnknown - m_componentCells.size();
+    const int remainingMines = m_field->minesCount() - m_knownMinesCount;
+
+    // if the only component is all that is left, it holds all remaining mines
+    const bool mustUseAllMines = (numComponents == 1 && numInterior == 0);
+    for(int component=0; component<numComponents; ++component)
+        enumerateComponent(component, remainingMines, mustUseAllMines);
+
+    return applyDeductions();
+}
+
+void MineSolver::enumerateComponent(int component, int remainingMines, bool mustUseAllMines)
+{
+    const int first = m_componentCellStarts.at(component);
+    const int count = m_componentCellStarts.at(component+1) - first;
+    if(count > m_maxComponentSize)
+        return;
+
+    m_enumCells = m_componentCells.constData() + first;
+    m_enumCount = count;
+    m_remainingMines = remainingMines;
+    m_mustUseAllMines = mustUseAllMines;
+
+    // constraints of every cell, as indexes in m_constraints
+    int neighbours[MineField::MAX_NEIGHBOURS];
+    m_cellConstraintsStart.resize(0);
+    m_cellConstraints.resize(0);
+    for(int pos=0; pos<count; ++pos)
+    {
+        m_cellConstraintsStart.append(m_cellConstraints.size());
+        const int numNeighbours = m_field->adjasentCellsFor(m_enumCells[pos], neighbours);
+        for(int i=0; i<numNeighbours; ++i)
+        {
+            const int constraint = m_constraintOf.at(neighbours[i]);
+            if(constraint != -1)
+                m_cellConstraints.append(constraint);
+        }
+    }
+    m_cellConstraintsStart.append(m_cellConstraints.size());
+
+    if(m_need.size() < m_constraints.size())
+    {
+        m_need.resize(m_constraints.size());
+        m_unassigned.resize(m_constraints.size());
+    }
+    for(int i=m_componentConstraintStarts.at(component); i<m_componentConstraintStarts.at(component+1); ++i)
+    {
+        const int constraint = m_componentConstraints.at(i);
+        m_need[constraint] = m_constraints.at(constraint).mines;
+        m_unassigned[constraint] = m_constraints.at(constraint).numCells;
+    }
+
+    m_assignment.fill(0, count);
+    m_mineHits.fill(0, count);
+    m_solutions = 0;
+    m_nodes = 0;
+    enumerate(0, 0);
+
+    if(m_nodes > MAX_ENUMERATION_NODES || m_solutions == 0)
+        return; // gave up, or field is inconsistent
+
+    for(int pos=0; pos<count; ++pos)
+    {
+        if(m_mineHits.at(pos) == 0)
+            deduce(m_enumCells[pos], false);
+        else if(m_mineHits.at(pos) == m_solutions)
+            deduce(m_enumCells[pos], true);
+    }
+}
+
+void MineSolver::enumerate(int pos, int mines)
+{
+    if(++m_nodes > MAX_ENUMERATION_NODES)
+        return;
+
+    if(m_mustUseAllMines && mines + (m_enumCount - pos) < m_remainingMines)
+        return; // not enough cells left for the remaining mines
+
+    if(pos == m_enumCount)
+    {
+        if(m_mustUseAllMines && mines != m_remainingMines)
+            return;
+        m_solutions++;
+        for(int i=0; i<m_enumCount; ++i)
+            m_mineHits[i] += m_assignment.at(i);
+        return;
+    }
+
+    const int* first = m_cellConstraints.constData() + m_cellConstraintsStart.at(pos);
+    const int* last = m_cellConstraints.constData() + m_cellConstraintsStart.at(pos+1);
+
+    // every constraint keeps 0 <= need <= unassigned,
+    // so all of them are satisfied when all cells are assigned
+
+    // try cell without mine
+    bool possible = true;
+    for(const int* c=first; c!=last; ++c)
+        possible &= (m_need.at(*c) < m_unassigned.at(*c));
+    if(possible)
+    {
+        for(const int* c=first; c!=last; ++c)
+            m_unassigned[*c]--;
+        m_assignment[pos] = 0;
+        enumerate(pos+1, mines);
+        for(const int* c=first; c!=last; ++c)
+            m_unassigned[*c]++;
+    }
+
+    // try cell with mine
+    possible = (mines < m_remainingMines);
+    for(const int* c=first; c!=last; ++c)
+        possible &= (m_need.at(*c) > 0);
+    if(possible)
+    {
+        for(const int* c=first; c!=last; ++c)
+        {
+            m_need[*c]--;
+            m_unassigned[*c]--;
+        }
+        m_assignment[pos] = 1;
+        enumerate(pos+1, mines+1);
+        for(const int* c=first; c!=last; ++c)
+        {
+            m_need[*c]++;
+            m_unassigned[*c]++;
+        }
+        m_assignment[pos] = 0;
+    }
+}
+
+bool MineSolver::applyGlobalRule()
+{
+    if(m_knownMinesCount != m_field->minesCount())
+        return false;
+
+    // all mines are known, everything else is safe
+    bool changed = false;
+    for(int idx=0; idx<m_field->cellCount(); ++idx)
+    {
+        if(isUnknown(idx))
+            changed |= revealSafe(idx);
+    }
+    return changed;
+}
@@ -0,0 +1,239 @@
+/*
+    Copyright 2026 The KMines Authors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#ifndef MINESOLVER_H
+#define MINESOLVER_H
+
+#include <QVector>
+
+class MineField;
+
+/**
+ * Plays a MineField by pure logic.
+ * Looks only at what a player can see (revealed digits and the total
+ * number of mines) and reveals cells which are proven to be safe.
+ *
+ * Deductions are made in order of increasing cost:
+ * @li single cell rules: a digit whose mines are all known makes its other
+ *     neighbours safe, a digit with as many unknown neighbours as missing
+ *     mines makes them all mines
+ * @li pair rules: two overlapping digits bound the number of mines
+ *     in their common and exclusive cells (includes the subset rule)
+ * @li enumeration of all mine configurations of small independent
+ *     components of the frontier
+ *
+ * Mines found by the solver are remembered in the solver only,
+ * the field is never flagged.
+ */
+class MineSolver
+{
+public:
+    /**
+     * Constructor
+     *
+     * @param field field to play. Must outlive the solver
+     */
+    explicit MineSolver(MineField* field);
+    /**
+     * Forgets everything solver knows about the field.
+     * Must be called after the field starts new game
+     */
+    void reset();
+    /**
+     * Reveals all cells which can be proven safe, repeating
+     * until the game is over or nothing more can be proven
+     *
+     * @return true if the game was won
+     */
+    bool solve();
+    /**
+     * @return whether solver has proven that cell at idx holds mine
+     */
+    bool isKnownMine(int idx) const { return m_knownMine.at(idx); }
+    /**
+     * @return number of mines proven by solver
+     */
+    int knownMinesCount() const { return m_knownMinesCount; }
+    /**
+     * @return number of cells revealed by solve() since reset(),
+     * i.e. how many clicks a player following the solver makes
+     */
+    int revealCount() const { return m_revealCount; }
+    /**
+     * Sets maximal number of cells in a frontier component which will be
+     * enumerated. Bigger components are skipped
+     */
+    void setMaxComponentSize(int size) { m_maxComponentSize = size; }
+
+    /**
+     * Default value for setMaxComponentSize()
+     */
+    static const int DEFAULT_MAX_COMPONENT_SIZE = 24;
+private:
+    /**
+     * Unknown neighbours of a revealed digit and
+     * how many mines are still missing among them
+     */
+    struct Constraint
+    {
+        int idx;
+        int cells[8];
+        int numCells;
+        int mines;
+    };
+
+    /**
+     * Adds revealed digit at idx to m_worklist unless it's there already
+     */
+    void enqueue(int idx);
+    /**
+     * Adds revealed neighbours of idx to m_worklist
+     */
+    void enqueueNeighbours(int idx);
+    /**
+     * Reveals cell proven to be safe
+     * @return false if cell couldn't be revealed
+     */
+    bool revealSafe(int idx);
+    /**
+     * Remembers cell proven to hold mine
+     * @return false if it was known already
+     */
+    bool markMine(int idx);
+    /**
+     * @return whether cell at idx is neither revealed nor known mine
+     */
+    bool isUnknown(int idx) const;
+    /**
+     * Builds constraint of revealed digit at idx
+     * @return false if it has no unknown neighbours
+     */
+    bool buildConstraint(int idx, Constraint* constraint) const;
+    /**
+     * Applies single cell rules to digit at idx
+     */
+    void applySingleRules(int idx);
+    /**
+     * Rebuilds m_constraints for the whole frontier
+     */
+    void collectConstraints();
+    /**
+     * Records a deduction, to be applied by applyDeductions()
+     */
+    void deduce(int idx, bool mine);
+    /**
+     * Applies everything recorded with deduce()
+     * @return true if field or known mines changed
+     */
+    bool applyDeductions();
+    /**
+     * Applies pair rules to all overlapping digits of the frontier
+     */
+    bool applyPairRules();
+    /**
+     * Enumerates configurations of small frontier components
+     */
+    bool applyEnumeration();
+    /**
+     * Reveals everything if all mines are known
+     */
+    bool applyGlobalRule();
+    /**
+     * Splits the frontier into independent components, i.e. groups of
+     * unknown cells sharing constraints, and fills m_componentCells and
+     * m_componentConstraints
+     * @return number of components
+     */
+    int collectComponents();
+    /**
+     * Enumerates configurations of given component and deduces cells
+     * which are the same in all of them
+     */
+    void enumerateComponent(int component, int remainingMines, bool mustUseAllMines);
+    /**
+     * Recursive part of enumerateComponent()
+     */
+    void enumerate(int pos, int mines);
+
+    MineField* m_field;
+    int m_maxComponentSize;
+    int m_knownMinesCount;
+    int m_revealCount;
+    /**
+     * 1 for cells proven to hold mine
+     */
+    QVector<quint8> m_knownMine;
+    /**
+     * Revealed digits which have to be looked at by applySingleRules()
+     */
+    QVector<int> m_worklist;
+    /**
+     * 1 for cells which are in m_worklist
+     */
+    QVector<quint8> m_queued;
+    /**
+     * Constraints of the whole frontier, built by collectConstraints()
+     */
+    QVector<Constraint> m_constraints;
+    /**
+     * Index in m_constraints for revealed digits, -1 for other cells
+     */
+    QVector<int> m_constraintOf;
+    /**
+     * Deductions recorded by deduce(): 0 - none, 1 - safe, 2 - mine
+     */
+    QVector<quint8> m_deduced;
+    QVector<int> m_deducedCells;
+
+    // enumeration state, kept here to avoid allocations
+    /**
+     * Component of each cell, -1 if it's not on the frontier
+     */
+    QVector<int> m_componentOf;
+    /**
+     * Component of each constraint, -1 if not assigned yet
+     */
+    QVector<int> m_constraintComponent;
+    /**
+     * Cells of all components, grouped by component.
+     * Component i starts at m_componentCellStarts[i]
+     */
+    QVector<int> m_componentCells;
+    QVector<int> m_componentCellStarts;
+    /**
+     * Constraints of all components, grouped by component
+     */
+    QVector<int> m_componentConstraints;
+    QVector<int> m_componentConstraintStarts;
+    /**
+     * Constraints of each cell of the enumerated component
+     */
+    QVector<int> m_cellConstraintsStart;
+    QVector<int> m_cellConstraints;
+    QVector<int> m_need;
+    QVector<int> m_unassigned;
+    QVector<quint8> m_assignment;
+    QVector<qint64> m_mineHits;
+    const int* m_enumCells;
+    int m_enumCount;
+    qint64 m_solutions;
+    qint64 m_nodes;
+    int m_remainingMines;
+    bool m_mustUseAllMines;
+};
+
+#endif
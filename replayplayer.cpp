@@ -0,0 +1,245 @@
+/*
+    Copyright 2026 The KMines Authors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#include "replayplayer.h"
+#include "minefield.h"
+#include "chunkedminefield.h"
+
+namespace
+{
+/**
+ * Windows further from the first click than this are taken for broken logs
+ */
+const qint64 MAX_WINDOW_ORIGIN = 1 << 30;
+}
+
+ReplayPlayer::ReplayPlayer(MineField* field, ChunkedMineField* chunkedField)
+    : m_field(field), m_chunkedField(chunkedField), m_time(0), m_duration(0), m_atEnd(true),
+      m_error(false), m_paused(false), m_useQuestionMarks(false), m_startTime(-1), m_endTime(-1),
+      m_pausedTime(0), m_pauseStart(0), m_hasClaim(false), m_claimedWon(false), m_claimedSeconds(0)
+{
+}
+
+bool ReplayPlayer::load(const QByteArray& data)
+{
+    if(!m_reader.open(data) || m_reader.seed() == 0)
+        return false;
+    if(isEndless())
+    {
+        if(m_reader.density() <= 0 || m_reader.density() >= 1)
+            return false;
+    }
+    else
+    {
+        const int rows = m_reader.rowCount();
+        const int cols = m_reader.columnCount();
+        if(rows < 1 || cols < 1 || rows > MAX_FIELD_SIDE || cols > MAX_FIELD_SIDE
+           || m_reader.minesCount() < 1 || m_reader.minesCount() > rows*cols - MineField::MINIMAL_FREE)
+            return false;
+    }
+
+    // broken tail of the log is found when it's played
+    ReplayReader::Event event;
+    m_duration = 0;
+    while(m_reader.next(&event))
+        m_duration = event.time;
+    restart();
+    return true;
+}
+
+void ReplayPlayer::restart()
+{
+    m_reader.rewind();
+    if(isEndless())
+    {
+        m_chunkedField->newGame(m_reader.seed(), m_reader.density());
+        m_chunkedField->setWindow(0, 0, 0, 0);
+    }
+    else
+    {
+        m_field->setGenerationMode(m_reader.mode() == ReplayRecorder::NoGuess ? MineField::NoGuess
+                                                                             : MineField::RandomMines);
+        m_field->setSeed(m_reader.seed());
+        m_field->newGame(m_reader.rowCount(), m_reader.columnCount(), m_reader.minesCount());
+    }
+
+    m_time = 0;
+    m_error = false;
+    m_paused = false;
+    m_useQuestionMarks = false;
+    m_startTime = -1;
+    m_endTime = -1;
+    m_pausedTime = 0;
+    m_pauseStart = 0;
+    m_hasClaim = false;
+    m_claimedWon = false;
+    m_claimedSeconds = 0;
+    m_atEnd = !m_reader.next(&m_next);
+    if(m_reader.hasError())
+        fail();
+}
+
+bool ReplayPlayer::step()
+{
+    if(m_atEnd)
+        return false;
+    playEvent();
+    return !m_error;
+}
+
+void ReplayPlayer::seek(qint64 time)
+{
+    if(time < m_time)
+        restart();
+    while(!m_atEnd && m_next.time <= time)
+        playEvent();
+    m_time = qMax(m_time, qMin(time, m_duration));
+}
+
+void ReplayPlayer::playToEnd()
+{
+    while(step())
+        ;
+}
+
+void ReplayPlayer::fail()
+{
+    m_error = true;
+    m_atEnd = true;
+}
+
+bool ReplayPlayer::isValidCell(int idx) const
+{
+    return idx >= 0 && idx < (isEndless() ? m_chunkedField->cellCount() : m_field->cellCount());
+}
+
+bool ReplayPlayer::isGameOver() const
+{
+    return isEndless() ? m_chunkedField->isGameOver() : m_field->isGameOver();
+}
+
+bool ReplayPlayer::isWon() const
+{
+    return !isEndless() && m_field->isWon();
+}
+
+qint64 ReplayPlayer::playTime() const
+{
+    if(m_startTime == -1)
+        return 0;
+    const qint64 end = m_endTime != -1 ? m_endTime : m_time;
+    const qint64 paused = m_pausedTime + (m_paused ? end - m_pauseStart : 0);
+    return end - m_startTime - paused;
+}
+
+void ReplayPlayer::playEvent()
+{
+    const ReplayReader::Event& event = m_next;
+    m_time = event.time;
+    // nothing is written after the result
+    if(m_hasClaim)
+    {
+        fail();
+        return;
+    }
+
+    const bool gameOver = isGameOver();
+    switch(event.action)
+    {
+        case ReplayRecorder::Press:
+        case ReplayRecorder::Reveal:
+        case ReplayRecorder::Mark:
+        case ReplayRecorder::Chord:
+        {
+            // field can't be clicked once the game ends or while it is hidden
+            if(gameOver || m_paused || !isValidCell(event.idx))
+            {
+                fail();
+                return;
+            }
+            const bool firstClick = isEndless() ? m_chunkedField->isFirstClick() : m_field->isFirstClick();
+            if(event.action == ReplayRecorder::Reveal)
+            {
+                if(isEndless())
+                    m_chunkedField->reveal(event.idx);
+                else
+                    m_field->reveal(event.idx);
+            }
+            else if(event.action == ReplayRecorder::Mark)
+            {
+                if(isEndless())
+                {
+                    m_chunkedField->setUseQuestionMarks(m_useQuestionMarks);
+                    m_chunkedField->toggleMark(event.idx);
+                }
+                else
+                {
+                    m_field->setUseQuestionMarks(m_useQuestionMarks);
+                    m_field->toggleMark(event.idx);
+                }
+            }
+            else if(event.action == ReplayRecorder::Chord)
+            {
+                if(isEndless())
+                    m_chunkedField->chord(event.idx);
+                else
+                    m_field->chord(event.idx);
+            }
+            // the game clock starts with the first reveal
+            if(firstClick && !(isEndless() ? m_chunkedField->isFirstClick() : m_field->isFirstClick()))
+                m_startTime = m_time;
+            break;
+        }
+        case ReplayRecorder::Window:
+            if(!isEndless() || event.args[2] < 0 || event.args[3] < 0
+               || event.args[2] > MAX_FIELD_SIDE || event.args[3] > MAX_FIELD_SIDE
+               || qAbs(event.args[0]) > MAX_WINDOW_ORIGIN || qAbs(event.args[1]) > MAX_WINDOW_ORIGIN)
+            {
+                fail();
+                return;
+            }
+            m_chunkedField->setWindow(event.args[0], event.args[1], event.args[2], event.args[3]);
+            break;
+        case ReplayRecorder::Pause:
+            // game can only be paused while the clock runs
+            if(bool(event.args[0]) == m_paused || m_startTime == -1 || gameOver)
+            {
+                fail();
+                return;
+            }
+            m_paused = event.args[0];
+            if(m_paused)
+                m_pauseStart = m_time;
+            else
+                m_pausedTime += m_time - m_pauseStart;
+            break;
+        case ReplayRecorder::QuestionMarks:
+            m_useQuestionMarks = event.args[0];
+            break;
+        case ReplayRecorder::Finish:
+            m_hasClaim = true;
+            m_claimedWon = event.args[0];
+            m_claimedSeconds = event.args[1];
+            break;
+    }
+    if(!gameOver && isGameOver())
+        m_endTime = m_time;
+
+    m_atEnd = !m_reader.next(&m_next);
+    if(m_reader.hasError())
+        fail();
+}
@@ -0,0 +1,167 @@
+/*
+    Copyright 2026 The KMines Authors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#ifndef REPLAYPLAYER_H
+#define REPLAYPLAYER_H
+
+#include "replayreader.h"
+
+class MineField;
+class ChunkedMineField;
+
+/**
+ * Plays a log written by ReplayRecorder on a MineField or, for endless
+ * games, on a ChunkedMineField. Events go to the same engine calls the
+ * mouse handlers of MineFieldItem make, so the game follows the same
+ * rules as when it was played.
+ *
+ * Playing can go to any time of the log. Going back starts the game
+ * again and plays it up to that time, which takes well under
+ * a millisecond for usual fields.
+ *
+ * Events the game couldn't produce (cells outside the field, actions
+ * after the game has ended) stop playing, like a broken log does.
+ */
+class ReplayPlayer
+{
+public:
+    /**
+     * Constructor. Fields must outlive this object
+     */
+    ReplayPlayer(MineField* field, ChunkedMineField* chunkedField);
+    /**
+     * Loads a log and starts its game
+     *
+     * @return false if data isn't a valid log
+     */
+    bool load(const QByteArray& data);
+    /**
+     * Starts the game of the loaded log again
+     */
+    void restart();
+    /**
+     * Plays the next event
+     *
+     * @return false at the end of the log or if it is broken
+     */
+    bool step();
+    /**
+     * Plays all events up to given time, going back if needed
+     */
+    void seek(qint64 time);
+    /**
+     * Plays all remaining events
+     */
+    void playToEnd();
+    /**
+     * @return current time in the log, in milliseconds
+     */
+    qint64 time() const { return m_time; }
+    /**
+     * @return time of the last event
+     */
+    qint64 duration() const { return m_duration; }
+    /**
+     * @return whether all events were played
+     */
+    bool isAtEnd() const { return m_atEnd; }
+    /**
+     * @return whether the log is broken or has an event the game
+     * couldn't produce, checked up to the current time
+     */
+    bool hasError() const { return m_error; }
+    /**
+     * @return whether the game is played on the ChunkedMineField
+     */
+    bool isEndless() const { return m_reader.mode() == ReplayRecorder::Endless; }
+    const ReplayReader& reader() const { return m_reader; }
+
+    /**
+     * @return whether the game has ended by now
+     */
+    bool isGameOver() const;
+    /**
+     * @return whether the game has been won by now
+     */
+    bool isWon() const;
+    /**
+     * @return time the game clock has been running: from the first
+     * reveal to the end of the game or the current time, pauses excluded
+     */
+    qint64 playTime() const;
+    /**
+     * @return whether a Finish event has been played
+     */
+    bool hasClaim() const { return m_hasClaim; }
+    /**
+     * @return result claimed by the Finish event
+     */
+    bool claimedWon() const { return m_claimedWon; }
+    /**
+     * @return time in seconds claimed by the Finish event
+     */
+    qint64 claimedSeconds() const { return m_claimedSeconds; }
+
+    /**
+     * Bigger fields and windows are taken for broken logs,
+     * custom games have the same limit
+     */
+    static const int MAX_FIELD_SIDE = 2000;
+private:
+    /**
+     * Plays event m_next and reads the one after it
+     */
+    void playEvent();
+    /**
+     * Marks the log as broken from the current event on
+     */
+    void fail();
+    /**
+     * @return whether idx is a cell of the field or the window
+     */
+    bool isValidCell(int idx) const;
+
+    MineField* m_field;
+    ChunkedMineField* m_chunkedField;
+    ReplayReader m_reader;
+    /**
+     * Event to be played next, valid unless m_atEnd is set
+     */
+    ReplayReader::Event m_next;
+    qint64 m_time;
+    qint64 m_duration;
+    bool m_atEnd;
+    bool m_error;
+    bool m_paused;
+    bool m_useQuestionMarks;
+    /**
+     * Times of the first reveal and of the end of the game, -1 until they happen
+     */
+    qint64 m_startTime;
+    qint64 m_endTime;
+    /**
+     * Time spent paused while the clock was running,
+     * and start of the current pause
+     */
+    qint64 m_pausedTime;
+    qint64 m_pauseStart;
+    bool m_hasClaim;
+    bool m_claimedWon;
+    qint64 m_claimedSeconds;
+};
+
+#endif
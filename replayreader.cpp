@@ -0,0 +1,137 @@
+/*
+    Copyright 2026 The KMines Authors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#include "replayreader.h"
+
+#include <climits>
+#include <cstring>
+
+ReplayReader::ReplayReader()
+    : m_pos(0), m_eventsStart(0), m_error(false), m_time(0), m_idx(0),
+      m_mode(ReplayRecorder::RandomMines), m_seed(0), m_rows(0), m_cols(0), m_mines(0)
+{
+}
+
+bool ReplayReader::open(const QByteArray& data)
+{
+    m_data = data;
+    m_pos = 0;
+    m_eventsStart = 0;
+    m_error = true;
+    if(m_data.size() < ReplayRecorder::FIXED_HEADER_SIZE
+       || memcmp(m_data.constData(), ReplayRecorder::magic(), 4) != 0
+       || m_data.at(4) != ReplayRecorder::VERSION
+       || quint8(m_data.at(5)) > ReplayRecorder::Endless)
+        return false;
+    m_mode = static_cast<ReplayRecorder::Mode>(m_data.at(5));
+    m_seed = 0;
+    for(int i=0; i<8; ++i)
+        m_seed |= quint64(quint8(m_data.at(6+i))) << (8*i);
+
+    m_pos = ReplayRecorder::FIXED_HEADER_SIZE;
+    qint64 rows, cols, mines;
+    if(!readInt(&rows, false) || !readInt(&cols, false) || !readInt(&mines, false))
+        return false;
+    m_rows = rows;
+    m_cols = cols;
+    m_mines = mines;
+
+    m_eventsStart = m_pos;
+    rewind();
+    return true;
+}
+
+void ReplayReader::rewind()
+{
+    m_pos = m_eventsStart;
+    m_error = false;
+    m_time = 0;
+    m_idx = 0;
+}
+
+bool ReplayReader::readVarint(quint64* value)
+{
+    *value = 0;
+    for(int shift=0; shift<64; shift+=7)
+    {
+        if(m_pos >= m_data.size())
+            return false;
+        const quint8 byte = m_data.at(m_pos++);
+        *value |= quint64(byte & 0x7f) << shift;
+        if(!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+bool ReplayReader::readInt(qint64* value, bool zigzag)
+{
+    quint64 raw;
+    if(!readVarint(&raw))
+        return false;
+    *value = zigzag ? qint64(raw >> 1) ^ -qint64(raw & 1) : qint64(raw);
+    return *value >= INT_MIN && *value <= INT_MAX;
+}
+
+bool ReplayReader::next(Event* event)
+{
+    if(m_error || m_pos >= m_data.size())
+        return false;
+    // anything that doesn't read to the end breaks the log
+    m_error = true;
+
+    qint64 dt, delta;
+    quint64 code;
+    if(!readInt(&dt, false) || !readVarint(&code))
+        return false;
+    const quint64 raw = code >> ReplayRecorder::ACTION_BITS;
+    delta = qint64(raw >> 1) ^ -qint64(raw & 1);
+    if(delta < INT_MIN || delta > INT_MAX || m_idx + delta < 0 || m_idx + delta > INT_MAX)
+        return false;
+
+    event->action = static_cast<ReplayRecorder::Action>(code & ((1 << ReplayRecorder::ACTION_BITS) - 1));
+    int argCount = 0;
+    bool zigzag = false;
+    switch(event->action)
+    {
+        case ReplayRecorder::Window:
+            argCount = 4;
+            zigzag = true;
+            break;
+        case ReplayRecorder::Pause:
+        case ReplayRecorder::QuestionMarks:
+            argCount = 1;
+            break;
+        case ReplayRecorder::Finish:
+            argCount = 2;
+            break;
+        default:
+            break;
+    }
+    for(int i=0; i<argCount; ++i)
+    {
+        if(!readInt(&event->args[i], zigzag))
+            return false;
+    }
+
+    m_time += dt;
+    m_idx += delta;
+    event->time = m_time;
+    event->idx = m_idx;
+    m_error = false;
+    return true;
+}
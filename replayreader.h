@@ -0,0 +1,118 @@
+/*
+    Copyright 2026 The KMines Authors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#ifndef REPLAYREADER_H
+#define REPLAYREADER_H
+
+#include <QByteArray>
+
+#include "replayrecorder.h"
+
+/**
+ * Reads logs written by ReplayRecorder, event by event.
+ * Doesn't allocate anything after open(), so it can go through
+ * many logs quickly
+ */
+class ReplayReader
+{
+public:
+    /**
+     * Single event of the log
+     */
+    struct Event
+    {
+        /**
+         * Milliseconds since the start of the game
+         */
+        qint64 time;
+        ReplayRecorder::Action action;
+        /**
+         * Cell of the event, the previous one for events
+         * which don't concern a cell
+         */
+        int idx;
+        /**
+         * Arguments, see ReplayRecorder
+         */
+        qint64 args[4];
+    };
+
+    ReplayReader();
+    /**
+     * Reads header of given log and goes to its first event
+     *
+     * @return false if data isn't a log of a known version
+     */
+    bool open(const QByteArray& data);
+    /**
+     * Goes back to the first event
+     */
+    void rewind();
+    /**
+     * Reads the next event
+     *
+     * @return false at the end of the log or if the rest of it is broken,
+     * hasError() tells which one
+     */
+    bool next(Event* event);
+    /**
+     * @return whether the log turned out to be broken
+     */
+    bool hasError() const { return m_error; }
+
+    ReplayRecorder::Mode mode() const { return m_mode; }
+    quint64 seed() const { return m_seed; }
+    /**
+     * @return number of rows, 0 in endless games
+     */
+    int rowCount() const { return m_rows; }
+    /**
+     * @return number of columns, 0 in endless games
+     */
+    int columnCount() const { return m_cols; }
+    /**
+     * @return number of mines, 0 in endless games
+     */
+    int minesCount() const { return m_mode == ReplayRecorder::Endless ? 0 : m_mines; }
+    /**
+     * @return density of mines in endless games
+     */
+    double density() const { return double(m_mines) / ReplayRecorder::DENSITY_SCALE; }
+private:
+    bool readVarint(quint64* value);
+    /**
+     * Reads a varint which has to fit in an int
+     */
+    bool readInt(qint64* value, bool zigzag);
+
+    QByteArray m_data;
+    /**
+     * Offset of the next byte to read and of the first event
+     */
+    int m_pos;
+    int m_eventsStart;
+    bool m_error;
+    qint64 m_time;
+    int m_idx;
+    ReplayRecorder::Mode m_mode;
+    quint64 m_seed;
+    int m_rows;
+    int m_cols;
+    int m_mines;
+};
+
+#endif
@@ -0,0 +1,216 @@
+/*
+    Copyright 2026 The KMines Authors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#include "replayrecorder.h"
+#include "replayreader.h"
+#include "commondefs.h"
+
+#include <QHash>
+#include <QSaveFile>
+
+ReplayRecorder::ReplayRecorder()
+    : m_timeBase(0), m_lastTime(0), m_lastIdx(0), m_eventCount(0), m_useQuestionMarks(false), m_paused(false)
+{
+}
+
+void ReplayRecorder::start(Mode mode, quint64 seed, int rows, int cols, int mines)
+{
+    // reserved capacity survives resize(), so this allocates only once
+    if(m_data.capacity() < RESERVED_SIZE)
+        m_data.reserve(RESERVED_SIZE);
+    m_data.resize(0);
+    m_data.append(magic(), 4);
+    m_data.append(static_cast<char>(VERSION));
+    m_data.append(static_cast<char>(mode));
+    for(int i=0; i<8; ++i)
+        m_data.append(static_cast<char>(seed >> (8*i)));
+    writeVarint(rows);
+    writeVarint(cols);
+    writeVarint(mines);
+
+    m_timeBase = 0;
+    m_lastTime = 0;
+    m_lastIdx = 0;
+    m_eventCount = 0;
+    m_useQuestionMarks = false;
+    m_paused = false;
+    m_clock.start();
+}
+
+bool ReplayRecorder::resume(const QByteArray& data, int seconds)
+{
+    ReplayReader reader;
+    if(!reader.open(data))
+        return false;
+    ReplayReader::Event event;
+    event.time = 0;
+    event.idx = 0;
+    int eventCount = 0;
+    bool useQuestionMarks = false;
+    bool paused = false;
+    // the game clock starts with the first reveal of a cell which
+    // isn't marked, marks before it are followed to know which one
+    QHash<int, KMinesState::CellState> marks;
+    qint64 startTime = -1;
+    qint64 pausedTime = 0;
+    qint64 pauseStart = 0;
+    while(reader.next(&event))
+    {
+        switch(event.action)
+        {
+            case Reveal:
+                if(startTime == -1 && !marks.contains(event.idx))
+                    startTime = event.time;
+                break;
+            case Mark:
+                if(startTime != -1)
+                    break;
+                if(!marks.contains(event.idx))
+                    marks.insert(event.idx, KMinesState::Flagged);
+                else if(marks.value(event.idx) == KMinesState::Flagged && useQuestionMarks)
+                    marks.insert(event.idx, KMinesState::Questioned);
+                else
+                    marks.remove(event.idx);
+                break;
+            case Pause:
+                paused = event.args[0];
+                if(paused)
+                    pauseStart = event.time;
+                else
+                    pausedTime += event.time - pauseStart;
+                break;
+            case QuestionMarks:
+                useQuestionMarks = event.args[0];
+                break;
+            default:
+                break;
+        }
+        eventCount++;
+    }
+    if(reader.hasError())
+        return false;
+
+    m_data = data;
+    if(m_data.capacity() < RESERVED_SIZE)
+        m_data.reserve(RESERVED_SIZE);
+    // time the player idled after the last event is on the game clock,
+    // but not in the log yet; it goes to the delta of the next event
+    m_timeBase = event.time;
+    if(startTime != -1 && !paused)
+        m_timeBase = qMax(m_timeBase, startTime + pausedTime + qint64(seconds)*1000);
+    m_lastTime = event.time;
+    m_lastIdx = event.idx;
+    m_eventCount = eventCount;
+    m_useQuestionMarks = useQuestionMarks;
+    m_paused = paused;
+    m_clock.start();
+    return true;
+}
+
+void ReplayRecorder::setBoard(Mode mode, quint64 seed)
+{
+    if(m_data.size() < FIXED_HEADER_SIZE)
+        return;
+    char* header = m_data.data();
+    header[5] = static_cast<char>(mode);
+    for(int i=0; i<8; ++i)
+        header[6+i] = static_cast<char>(seed >> (8*i));
+}
+
+void ReplayRecorder::writeVarint(quint64 value)
+{
+    while(value >= 0x80)
+    {
+        m_data.append(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    m_data.append(static_cast<char>(value));
+}
+
+void ReplayRecorder::writeTime()
+{
+    const qint64 now = m_timeBase + m_clock.elapsed();
+    writeVarint(now - m_lastTime);
+    m_lastTime = now;
+}
+
+void ReplayRecorder::record(Action action, int idx)
+{
+    if(m_data.isEmpty())
+        return;
+    writeTime();
+    writeVarint((zigzag(qint64(idx) - m_lastIdx) << ACTION_BITS) | action);
+    m_lastIdx = idx;
+    m_eventCount++;
+}
+
+void ReplayRecorder::writeCommand(Action action)
+{
+    writeTime();
+    // index doesn't change
+    writeVarint(action);
+    m_eventCount++;
+}
+
+void ReplayRecorder::recordWindow(int originRow, int originCol, int rows, int cols)
+{
+    if(m_data.isEmpty())
+        return;
+    writeCommand(Window);
+    writeVarint(zigzag(originRow));
+    writeVarint(zigzag(originCol));
+    writeVarint(zigzag(rows));
+    writeVarint(zigzag(cols));
+}
+
+void ReplayRecorder::recordPause(bool paused)
+{
+    if(m_data.isEmpty() || paused == m_paused)
+        return;
+    m_paused = paused;
+    writeCommand(Pause);
+    writeVarint(paused ? 1 : 0);
+}
+
+void ReplayRecorder::setUseQuestionMarks(bool use)
+{
+    if(m_data.isEmpty() || use == m_useQuestionMarks)
+        return;
+    m_useQuestionMarks = use;
+    writeCommand(QuestionMarks);
+    writeVarint(use ? 1 : 0);
+}
+
+void ReplayRecorder::recordFinish(bool won, int seconds)
+{
+    if(m_data.isEmpty())
+        return;
+    writeCommand(Finish);
+    writeVarint(won ? 1 : 0);
+    writeVarint(qMax(0, seconds));
+}
+
+bool ReplayRecorder::save(const QString& fileName) const
+{
+    if(m_data.isEmpty())
+        return false;
+    QSaveFile file(fileName);
+    if(!file.open(QIODevice::WriteOnly))
+        return false;
+    file.write(m_data);
+    return file.commit();
+}
@@ -0,0 +1,205 @@
+/*
+    Copyright 2026 The KMines Authors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#ifndef REPLAYRECORDER_H
+#define REPLAYRECORDER_H
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QString>
+
+/**
+ * Records a game as a compact binary log, which is enough to play the
+ * game again: the field is generated from its seed and the first click,
+ * see MineField::setSeed().
+ *
+ * The log starts with a fixed header:
+ * @li 4 bytes: "KMRP"
+ * @li 1 byte: VERSION
+ * @li 1 byte: Mode
+ * @li 8 bytes: seed, little endian
+ *
+ * followed by varints (7 bits per byte, lowest first) of rows, columns
+ * and mines. Endless games have 0 rows and columns and store density
+ * times DENSITY_SCALE instead of mines.
+ *
+ * Events follow up to the end of the log, each as two varints:
+ * milliseconds since the previous event, then zigzag encoded difference
+ * of the cell index from the previous event, shifted left by ACTION_BITS
+ * and or-ed with the Action. Events which don't concern a cell keep
+ * the index and carry arguments in more varints after it: Window has
+ * zigzag encoded origin row, origin column, rows and columns, Pause
+ * and QuestionMarks have 1 or 0, Finish has 1 if the game was won and
+ * seconds shown by the game clock.
+ *
+ * Events are only ever appended, the header is only changed when
+ * the first reveal uses preset mines (see setBoard()). Memory for
+ * RESERVED_SIZE bytes is taken once, so recording a click doesn't
+ * allocate anything; an Expert game takes about 2 KiB.
+ */
+class ReplayRecorder
+{
+public:
+    /**
+     * How the field of the game is generated
+     */
+    enum Mode
+    {
+        /// MineField::RandomMines
+        RandomMines,
+        /// MineField::NoGuess
+        NoGuess,
+        /// ChunkedMineField
+        Endless
+    };
+    /**
+     * What the player did
+     */
+    enum Action
+    {
+        /// left button went down on a cell, or moved to it while down
+        Press,
+        Reveal,
+        /// cycle marks of the cell
+        Mark,
+        Chord,
+        /// window of the endless mode changed
+        Window,
+        /// game was paused or resumed
+        Pause,
+        /// question marks were switched on or off, they change what Mark does
+        QuestionMarks,
+        /// game ended, claims the result
+        Finish
+    };
+
+    ReplayRecorder();
+    /**
+     * Starts a new log, drops the old one
+     *
+     * @param mines number of mines, or density of endless games
+     * times DENSITY_SCALE
+     */
+    void start(Mode mode, quint64 seed, int rows, int cols, int mines);
+    /**
+     * Goes on with a log written before, time spent meanwhile
+     * doesn't count. The log continues at the time which makes its
+     * play time, as ReplayPlayer counts it, equal to seconds; the game
+     * clock runs on while the player idles after the last event
+     *
+     * @param seconds time on the game clock when data was saved
+     * @return false if data isn't a valid log, then nothing changes
+     */
+    bool resume(const QByteArray& data, int seconds);
+    /**
+     * Changes mode and seed in the header, used when preset mines
+     * generated from another seed are placed
+     */
+    void setBoard(Mode mode, quint64 seed);
+    /**
+     * Appends an event, time is taken from the clock started by start()
+     */
+    void record(Action action, int idx);
+    /**
+     * Appends a Window event
+     */
+    void recordWindow(int originRow, int originCol, int rows, int cols);
+    /**
+     * Appends a Pause event if paused differs from the last recorded value
+     */
+    void recordPause(bool paused);
+    /**
+     * Appends a QuestionMarks event if use differs from the last
+     * recorded value. Games start without question marks
+     */
+    void setUseQuestionMarks(bool use);
+    /**
+     * Appends a Finish event
+     *
+     * @param seconds time shown by the game clock
+     */
+    void recordFinish(bool won, int seconds);
+    /**
+     * @return the log so far
+     */
+    const QByteArray& data() const { return m_data; }
+    /**
+     * @return number of events recorded since start()
+     */
+    int eventCount() const { return m_eventCount; }
+    /**
+     * Writes the log to given file
+     * @return false if writing failed
+     */
+    bool save(const QString& fileName) const;
+
+    /**
+     * First bytes of every log
+     */
+    static const char* magic() { return "KMRP"; }
+    /**
+     * Version of the format
+     */
+    static const int VERSION = 1;
+    /**
+     * Size of the fixed part of the header
+     */
+    static const int FIXED_HEADER_SIZE = 14;
+    /**
+     * Bits of an event taken by its Action
+     */
+    static const int ACTION_BITS = 3;
+    /**
+     * Density of endless games is stored as a fraction of this
+     */
+    static const int DENSITY_SCALE = 1 << 16;
+    /**
+     * Capacity reserved by start(). Longer games still
+     * get recorded, they just allocate now and then
+     */
+    static const int RESERVED_SIZE = 16 * 1024;
+private:
+    void writeVarint(quint64 value);
+    /**
+     * @return value with the sign moved to the lowest bit,
+     * so that small negative values stay small
+     */
+    static quint64 zigzag(qint64 value) { return (quint64(value) << 1) ^ quint64(value >> 63); }
+    /**
+     * Appends time since the previous event
+     */
+    void writeTime();
+    /**
+     * Appends time and action of an event which doesn't move
+     * to another cell, arguments have to follow
+     */
+    void writeCommand(Action action);
+
+    QByteArray m_data;
+    QElapsedTimer m_clock;
+    /**
+     * Time of the log when m_clock was started
+     */
+    qint64 m_timeBase;
+    qint64 m_lastTime;
+    int m_lastIdx;
+    int m_eventCount;
+    bool m_useQuestionMarks;
+    bool m_paused;
+};
+
+#endif
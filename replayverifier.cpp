@@ -0,0 +1,123 @@
+/*
+    Copyright 2026 The KMines Authors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#include "replayverifier.h"
+
+#include <QAtomicInt>
+#include <QFile>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+#include "minefield.h"
+#include "chunkedminefield.h"
+#include "replayplayer.h"
+
+class ReplayVerifier::Worker : public QRunnable
+{
+public:
+    Worker(const QStringList& fileNames, Result* results, QAtomicInt* nextFile)
+        : m_fileNames(fileNames), m_results(results), m_nextFile(nextFile) {}
+    void run()
+    {
+        // fields are reused for all logs the worker takes
+        MineField field;
+        ChunkedMineField chunkedField;
+        ReplayPlayer player(&field, &chunkedField);
+        forever
+        {
+            const int i = m_nextFile->fetchAndAddRelaxed(1);
+            if(i >= m_fileNames.size())
+                return;
+            QFile file(m_fileNames.at(i));
+            if(file.open(QIODevice::ReadOnly))
+                m_results[i] = verify(&player, file.readAll());
+            else
+            {
+                m_results[i].status = Unreadable;
+                m_results[i].won = false;
+                m_results[i].playTime = 0;
+                m_results[i].claimedSeconds = 0;
+            }
+            m_results[i].fileName = m_fileNames.at(i);
+        }
+    }
+private:
+    const QStringList& m_fileNames;
+    Result* m_results;
+    QAtomicInt* m_nextFile;
+};
+
+QVector<ReplayVerifier::Result> ReplayVerifier::verifyFiles(const QStringList& fileNames)
+{
+    QVector<Result> results(fileNames.size());
+    QAtomicInt nextFile(0);
+    QThreadPool pool;
+    const int numWorkers = qBound(1, QThread::idealThreadCount(), qMax(1, fileNames.size()));
+    pool.setMaxThreadCount(numWorkers);
+    // workers take files one by one, so slow ones don't hold the others
+    for(int i=0; i<numWorkers; ++i)
+        pool.start(new Worker(fileNames, results.data(), &nextFile));
+    pool.waitForDone();
+    return results;
+}
+
+ReplayVerifier::Result ReplayVerifier::verify(ReplayPlayer* player, const QByteArray& data)
+{
+    Result result;
+    result.status = Corrupt;
+    result.won = false;
+    result.playTime = 0;
+    result.claimedSeconds = 0;
+    if(!player->load(data))
+        return result;
+
+    player->playToEnd();
+    result.won = player->isWon();
+    result.playTime = player->playTime();
+    result.claimedSeconds = player->claimedSeconds();
+    if(player->hasError())
+        result.status = Corrupt;
+    else if(!player->hasClaim())
+        result.status = Unfinished;
+    else if(!player->isGameOver() || player->claimedWon() != player->isWon())
+        result.status = ResultMismatch;
+    else if(qAbs(player->claimedSeconds()*1000 - player->playTime()) > TIME_TOLERANCE)
+        result.status = TimeMismatch;
+    else
+        result.status = Valid;
+    return result;
+}
+
+const char* ReplayVerifier::statusName(Status status)
+{
+    switch(status)
+    {
+        case Valid:
+            return "valid";
+        case Unreadable:
+            return "unreadable";
+        case Corrupt:
+            return "corrupt";
+        case Unfinished:
+            return "unfinished";
+        case ResultMismatch:
+            return "result mismatch";
+        case TimeMismatch:
+            return "time mismatch";
+    }
+    return "";
+}
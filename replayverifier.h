@@ -0,0 +1,99 @@
+/*
+    Copyright 2026 The KMines Authors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#ifndef REPLAYVERIFIER_H
+#define REPLAYVERIFIER_H
+
+#include <QVector>
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+
+class ReplayPlayer;
+
+/**
+ * Checks logs written by ReplayRecorder by playing them with
+ * ReplayPlayer: the game must end with the claimed result and the
+ * claimed time must match time the game clock was running.
+ *
+ * Many logs are checked in parallel by worker threads, every one
+ * reusing its own fields, so only reading the files allocates.
+ */
+class ReplayVerifier
+{
+public:
+    /**
+     * Outcome of checking a log
+     */
+    enum Status
+    {
+        Valid,
+        /// file couldn't be read
+        Unreadable,
+        /// log is broken or has events the game couldn't produce
+        Corrupt,
+        /// log has no result
+        Unfinished,
+        /// the game ends differently or not at all
+        ResultMismatch,
+        /// claimed time is off
+        TimeMismatch
+    };
+    /**
+     * Result of checking a single log
+     */
+    struct Result
+    {
+        QString fileName;
+        Status status;
+        bool won;
+        /**
+         * Time the game clock was running, in milliseconds
+         */
+        qint64 playTime;
+        /**
+         * Time claimed by the log, in seconds
+         */
+        qint64 claimedSeconds;
+    };
+
+    /**
+     * Checks given files, using all cores
+     *
+     * @return results in the order of fileNames
+     */
+    static QVector<Result> verifyFiles(const QStringList& fileNames);
+    /**
+     * Checks a single log with given player
+     */
+    static Result verify(ReplayPlayer* player, const QByteArray& data);
+    /**
+     * @return name of status for reports
+     */
+    static const char* statusName(Status status);
+
+    /**
+     * Difference between claimed time and time the clock ran which is
+     * still accepted, in milliseconds. The game clock only shows whole
+     * seconds and starts a little after the first reveal
+     */
+    static const int TIME_TOLERANCE = 1500;
+private:
+    class Worker;
+};
+
+#endif
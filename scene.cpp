@@ -21,22 +21,167 @@
 #include "settings.h"
 
 #include <QResizeEvent>
+#include <QTimer>
+#include <QWheelEvent>
+#include <QKeyEvent>
 
 #include <KGamePopupItem>
 #include <KLocalizedString>
 #include <KgThemeProvider>
 
+#include "kminesdebug.h"
 #include "minefielditem.h"
+#include "spriterasterizer.h"
 // --------------- KMinesView ---------------
 
 KMinesView::KMinesView( KMinesScene* scene, QWidget *parent )
-    : QGraphicsView(scene, parent), m_scene(scene)
+    : QGraphicsView(scene, parent), m_scene(scene), m_firstFrameTime(-1),
+      m_relayoutTimer(new QTimer(this)), m_resizeCount(0), m_relayoutCount(0), m_lastRelayoutTime(0)
 {
+    m_relayoutTimer->setSingleShot(true);
+    m_relayoutTimer->setInterval(RELAYOUT_DELAY);
+    connect(m_relayoutTimer, &QTimer::timeout, this, &KMinesView::relayout);
+}
+
+QElapsedTimer& KMinesView::startupClock()
+{
+    static QElapsedTimer clock;
+    return clock;
 }
 
 void KMinesView::resizeEvent( QResizeEvent *ev )
 {
-    m_scene->resizeScene( ev->size().width(), ev->size().height() );
+    Q_UNUSED(ev);
+    m_resizeCount++;
+    // the first layout can't be scaled from anything
+    if(m_relayoutCount == 0)
+    {
+        relayout();
+        return;
+    }
+
+    // while the window is being resized, the old layout is only
+    // scaled to fit. everything is laid out again once it settles.
+    // a scrollable field just shows more or less of itself
+    if(!m_scene->isScrollable())
+        fitInView(sceneRect(), Qt::KeepAspectRatio);
+    m_relayoutTimer->start();
+}
+
+void KMinesView::relayout()
+{
+    QElapsedTimer timer;
+    timer.start();
+    resetTransform();
+    m_scene->resizeScene( viewport()->width(), viewport()->height() );
+    updateVisibleRect();
+    m_lastRelayoutTime = timer.nsecsElapsed() / 1000;
+    m_relayoutCount++;
+    qCDebug(KMINES_PERF) << "relayout" << m_relayoutCount << "for" << m_resizeCount << "resize events took"
+                         << m_lastRelayoutTime << "us";
+}
+
+void KMinesView::wheelEvent( QWheelEvent *ev )
+{
+    if(!(ev->modifiers() & Qt::ControlModifier) && m_scene->isEndless())
+    {
+        // a wheel step moves by three cells, like text views scroll lines.
+        // Shift+wheel scrolls horizontally
+        const QPoint delta = ev->angleDelta() * ENDLESS_SCROLL_CELLS / -120;
+        if(ev->modifiers() & Qt::ShiftModifier)
+            m_scene->scrollField(0, delta.y() + delta.x());
+        else
+            m_scene->scrollField(delta.y(), delta.x());
+        ev->accept();
+        return;
+    }
+    if(!(ev->modifiers() & Qt::ControlModifier))
+    {
+        QGraphicsView::wheelEvent(ev);
+        return;
+    }
+    if(ev->angleDelta().y() > 0)
+        zoomIn();
+    else if(ev->angleDelta().y() < 0)
+        zoomOut();
+    ev->accept();
+}
+
+void KMinesView::keyPressEvent( QKeyEvent *ev )
+{
+    if(!m_scene->isEndless())
+    {
+        QGraphicsView::keyPressEvent(ev);
+        return;
+    }
+    switch(ev->key())
+    {
+        case Qt::Key_Up:
+            m_scene->scrollField(-ENDLESS_SCROLL_CELLS, 0);
+            break;
+        case Qt::Key_Down:
+            m_scene->scrollField(ENDLESS_SCROLL_CELLS, 0);
+            break;
+        case Qt::Key_Left:
+            m_scene->scrollField(0, -ENDLESS_SCROLL_CELLS);
+            break;
+        case Qt::Key_Right:
+            m_scene->scrollField(0, ENDLESS_SCROLL_CELLS);
+            break;
+        default:
+            QGraphicsView::keyPressEvent(ev);
+    }
+}
+
+void KMinesView::scrollContentsBy( int dx, int dy )
+{
+    QGraphicsView::scrollContentsBy(dx, dy);
+    updateVisibleRect();
+}
+
+void KMinesView::zoomIn()
+{
+    setZoom(m_scene->zoom() * 1.25);
+}
+
+void KMinesView::zoomOut()
+{
+    setZoom(m_scene->zoom() / 1.25);
+}
+
+void KMinesView::zoomToFit()
+{
+    setZoom(1);
+}
+
+void KMinesView::setZoom(qreal zoom)
+{
+    // keep the same part of the field in the center
+    const QRectF oldRect = sceneRect();
+    const QPointF oldCenter = mapToScene(viewport()->rect().center());
+    const qreal fx = oldRect.width() > 0 ? oldCenter.x() / oldRect.width() : 0.5;
+    const qreal fy = oldRect.height() > 0 ? oldCenter.y() / oldRect.height() : 0.5;
+
+    m_relayoutTimer->stop();
+    resetTransform();
+    m_scene->setZoom(zoom);
+    centerOn(fx * sceneRect().width(), fy * sceneRect().height());
+    updateVisibleRect();
+}
+
+void KMinesView::updateVisibleRect()
+{
+    m_scene->setVisibleRect( mapToScene(viewport()->rect()).boundingRect() );
+}
+
+void KMinesView::paintEvent( QPaintEvent *ev )
+{
+    QGraphicsView::paintEvent(ev);
+    if(m_firstFrameTime < 0 && startupClock().isValid())
+    {
+        m_firstFrameTime = startupClock().elapsed();
+        qCDebug(KMINES_PERF) << "time to first frame:" << m_firstFrameTime << "ms";
+    }
 }
 
 // -------------- KMinesScene --------------------
@@ -50,8 +195,13 @@ static KgThemeProvider* provider()
 }
 
 KMinesScene::KMinesScene( QObject* parent )
-    : QGraphicsScene(parent), m_renderer(provider())
+    : QGraphicsScene(parent), m_renderer(provider()), m_spriteCache(&m_renderer), m_themeChanged(false),
+      m_zoom(1.0)
 {
+    m_backgroundRasterizer = new SpriteRasterizer(&m_renderer, this);
+    connect(m_backgroundRasterizer, &SpriteRasterizer::rendered, this, &KMinesScene::onBackgroundRendered);
+    connect(m_renderer.themeProvider(), &KgThemeProvider::currentThemeChanged,
+            this, &KMinesScene::onThemeChanged);
     setItemIndexMethod( NoIndex );
     m_fieldItem = new MineFieldItem(&m_renderer);
     connect(m_fieldItem, &MineFieldItem::flaggedMinesCountChanged, this, &KMinesScene::minesCountChanged);
@@ -59,6 +209,8 @@ KMinesScene::KMinesScene( QObject* parent )
     connect(m_fieldItem, &MineFieldItem::gameOver, this, &KMinesScene::onGameOver);
     // and re-emit it for others
     connect(m_fieldItem, &MineFieldItem::gameOver, this, &KMinesScene::gameOver);
+    connect(m_fieldItem, &MineFieldItem::cellsChanged, this, &KMinesScene::cellsChanged);
+    connect(m_fieldItem, &MineFieldItem::boardRequested, this, &KMinesScene::boardRequested);
     addItem(m_fieldItem);
 
     m_messageItem = new KGamePopupItem;
@@ -72,30 +224,168 @@ KMinesScene::KMinesScene( QObject* parent )
     m_gamePausedMessageItem->setHideOnMouseClick(false);
     addItem(m_gamePausedMessageItem);
     
-    setBackgroundBrush(m_renderer.spritePixmap(QLatin1String( "mainWidget" ), sceneRect().size().toSize()));
+    updateBackground();
 }
 
 void KMinesScene::resizeScene(int width, int height)
 {
-    setSceneRect(0, 0, width, height);
-    setBackgroundBrush(m_renderer.spritePixmap(QLatin1String( "mainWidget" ), sceneRect().size().toSize()));
-    m_fieldItem->resizeToFitInRect( sceneRect() );
-    m_fieldItem->setPos( sceneRect().width()/2 - m_fieldItem->boundingRect().width()/2,
-                         sceneRect().height()/2 - m_fieldItem->boundingRect().height()/2 );
-    m_gamePausedMessageItem->setPos( sceneRect().width()/2 - m_gamePausedMessageItem->boundingRect().width()/2,
-                          sceneRect().height()/2 - m_gamePausedMessageItem->boundingRect().height()/2 );
-    m_messageItem->setPos( sceneRect().width()/2 - m_messageItem->boundingRect().width()/2,
-                          sceneRect().height()/2 - m_messageItem->boundingRect().height()/2 );
+    m_viewSize = QSize(width, height);
+    if(m_fieldItem->isEndless())
+    {
+        // endless field shows as many cells as fit in the view
+        const int cellSize = qMax(static_cast<int>(MIN_CELL_SIZE), qRound(ENDLESS_CELL_SIZE * m_zoom));
+        m_fieldItem->setWindowSize(qMax(1, height/cellSize - 2), qMax(1, width/cellSize - 2));
+        m_fieldItem->setCellSize(cellSize);
+    }
+    else
+    {
+        const int fitting = m_fieldItem->fittingCellSize( QRectF(0, 0, width, height) );
+        m_fieldItem->setCellSize( qMax(static_cast<int>(MIN_CELL_SIZE), qRound(fitting * m_zoom)) );
+    }
+
+    // a field which doesn't fit makes the scene bigger than the view
+    const QRectF fieldRect = m_fieldItem->boundingRect();
+    setSceneRect(0, 0, qMax(qreal(width), fieldRect.width()), qMax(qreal(height), fieldRect.height()));
+    updateBackground();
+    m_fieldItem->setPos( sceneRect().width()/2 - fieldRect.width()/2,
+                         sceneRect().height()/2 - fieldRect.height()/2 );
+    if(m_visibleRect.isEmpty() || !isScrollable())
+        m_visibleRect = sceneRect();
+    repositionMessages();
+}
+
+void KMinesScene::relayout()
+{
+    resizeScene(m_viewSize.width(), m_viewSize.height());
+}
+
+void KMinesScene::setZoom(qreal zoom)
+{
+    m_zoom = qBound(qreal(1), zoom, qreal(MAX_ZOOM));
+    relayout();
+}
+
+bool KMinesScene::isScrollable() const
+{
+    const QRectF fieldRect = m_fieldItem->boundingRect();
+    return fieldRect.width() > m_viewSize.width() || fieldRect.height() > m_viewSize.height();
+}
+
+void KMinesScene::setVisibleRect(const QRectF& rect)
+{
+    m_visibleRect = rect;
+    repositionMessages();
+}
+
+void KMinesScene::repositionMessages()
+{
+    const QPointF center = m_visibleRect.center();
+    m_gamePausedMessageItem->setPos( center.x() - m_gamePausedMessageItem->boundingRect().width()/2,
+                                     center.y() - m_gamePausedMessageItem->boundingRect().height()/2 );
+    m_messageItem->setPos( center.x() - m_messageItem->boundingRect().width()/2,
+                           center.y() - m_messageItem->boundingRect().height()/2 );
 }
 
-void KMinesScene::startNewGame(int rows, int cols, int numMines)
+void KMinesScene::updateBackground()
+{
+    // a bigger scene gets the brush tiled, so only the view has to be covered
+    const QSize size = m_viewSize;
+    if(size == m_backgroundSize && !m_themeChanged)
+        return;
+    m_backgroundSize = size;
+    m_themeChanged = false;
+
+    const QString cacheFile = size.isEmpty() ? QString() : m_spriteCache.fileName(QLatin1String( "mainWidget" ), size);
+    const QPixmap cached = SpriteCache::load(cacheFile);
+    if(!cached.isNull())
+    {
+        m_backgroundRasterizer->cancel();
+        m_background = cached;
+    }
+    else if(m_background.isNull() || size.isEmpty())
+    {
+        // nothing to stretch yet, render the first one right away
+        m_background = m_renderer.spritePixmap(QLatin1String( "mainWidget" ), size);
+        SpriteCache::save(cacheFile, m_background.toImage());
+    }
+    else
+    {
+        m_background = m_background.scaled(size, Qt::IgnoreAspectRatio, Qt::FastTransformation);
+        SpriteRasterizer::Layer layer;
+        layer.spriteKey = QLatin1String( "mainWidget" );
+        layer.rect = QRectF(QPointF(0, 0), size);
+        m_backgroundRasterizer->render(size, QVector<SpriteRasterizer::Layer>() << layer, cacheFile);
+    }
+    setBackgroundBrush(m_background);
+}
+
+void KMinesScene::onThemeChanged()
+{
+    // background is rendered again on the next resize
+    m_themeChanged = true;
+}
+
+void KMinesScene::onBackgroundRendered(const QImage& image)
+{
+    m_background = QPixmap::fromImage(image);
+    setBackgroundBrush(m_background);
+}
+
+void KMinesScene::startNewGame(int rows, int cols, int numMines, quint64 seed)
 {
     // hide message if any
     m_messageItem->forceHide();
 
-    m_fieldItem->initField(rows, cols, numMines);
+    m_fieldItem->initField(rows, cols, numMines, seed);
     // reposition items
-    resizeScene((int)sceneRect().width(), (int)sceneRect().height());
+    relayout();
+}
+
+void KMinesScene::startNewGame(const BoardShape& shape, int numMines, quint64 seed)
+{
+    m_messageItem->forceHide();
+
+    m_fieldItem->initField(shape, numMines, seed);
+    relayout();
+}
+
+void KMinesScene::startEndlessGame(quint64 seed, double density)
+{
+    m_messageItem->forceHide();
+
+    m_fieldItem->initEndlessField(seed, density);
+    // window is created for the current size
+    relayout();
+}
+
+bool KMinesScene::isEndless() const
+{
+    return m_fieldItem->isEndless();
+}
+
+bool KMinesScene::isShaped() const
+{
+    return m_fieldItem->isShaped();
+}
+
+void KMinesScene::scrollField(int rows, int cols)
+{
+    m_fieldItem->scrollWindow(rows, cols);
+}
+
+bool KMinesScene::setPresetBoard(const QVector<int>& mines, int startIdx, quint64 seed, bool noGuess)
+{
+    return m_fieldItem->setPresetBoard(mines, startIdx, seed, noGuess);
+}
+
+bool KMinesScene::isWaitingForBoard() const
+{
+    return m_fieldItem->isWaitingForBoard();
+}
+
+bool KMinesScene::revealGeneratedBoard(const QVector<int>& mines, int startIdx, bool noGuess)
+{
+    return m_fieldItem->revealGeneratedBoard(mines, startIdx, noGuess);
 }
 
 int KMinesScene::totalMines() const
@@ -103,8 +393,94 @@ int KMinesScene::totalMines() const
     return m_fieldItem->minesCount();
 }
 
+quint64 KMinesScene::seed() const
+{
+    return m_fieldItem->seed();
+}
+
+const ReplayRecorder& KMinesScene::replay() const
+{
+    return m_fieldItem->replay();
+}
+
+void KMinesScene::recordResult(bool won, int seconds)
+{
+    m_fieldItem->recordResult(won, seconds);
+}
+
+void KMinesScene::setSnapshotFile(const QString& fileName)
+{
+    m_fieldItem->setSnapshotFile(fileName);
+}
+
+bool KMinesScene::restoreSnapshot(int* seconds, QByteArray* level, bool* botPlayed)
+{
+    if(!m_fieldItem->restoreSnapshot(seconds, level, botPlayed))
+        return false;
+    m_messageItem->forceHide();
+    relayout();
+    return true;
+}
+
+void KMinesScene::setSnapshotSeconds(int seconds)
+{
+    m_fieldItem->setSnapshotSeconds(seconds);
+}
+
+void KMinesScene::setSnapshotLevel(const QByteArray& level)
+{
+    m_fieldItem->setSnapshotLevel(level);
+}
+
+void KMinesScene::setSnapshotBotPlayed(bool played)
+{
+    m_fieldItem->setSnapshotBotPlayed(played);
+}
+
+bool KMinesScene::loadReplay(const QByteArray& data)
+{
+    if(!m_fieldItem->loadReplay(data))
+        return false;
+    m_messageItem->forceHide();
+    relayout();
+    return true;
+}
+
+void KMinesScene::setReplayPosition(qint64 time)
+{
+    // endless replays change their window
+    if(m_fieldItem->seekReplay(time))
+        relayout();
+}
+
+qint64 KMinesScene::replayDuration() const
+{
+    return m_fieldItem->replayDuration();
+}
+
+bool KMinesScene::isReplaying() const
+{
+    return m_fieldItem->isReplaying();
+}
+
+const MineField* KMinesScene::field() const
+{
+    return m_fieldItem->field();
+}
+
+bool KMinesScene::playMove(ReplayRecorder::Action action, int idx)
+{
+    return m_fieldItem->playMove(action, idx);
+}
+
+void KMinesScene::setShowHints(bool show)
+{
+    m_fieldItem->setShowHints(show);
+}
+
 void KMinesScene::setGamePaused(bool paused)
 {
+    m_fieldItem->recordPause(paused);
     m_fieldItem->setVisible(!paused);
     if(paused)
         m_gamePausedMessageItem->showMessage(i18n("Game is paused."), KGamePopupItem::Center);
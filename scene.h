@@ -21,10 +21,17 @@
 
 #include <QGraphicsView>
 #include <QGraphicsScene>
+#include <QElapsedTimer>
 #include <KGameRenderer>
 
+#include "spritecache.h"
+#include "replayrecorder.h"
+
 class MineFieldItem;
+class MineField;
+class BoardShape;
 class KGamePopupItem;
+class SpriteRasterizer;
 
 /**
  * Graphics scene for KMines game
@@ -38,48 +45,310 @@ public:
      */
     explicit KMinesScene( QObject* parent );
     /**
-     * Resizes scene to given dimensions
+     * Lays out scene for a view of given dimensions. The field fits in
+     * unless it is zoomed in or its cells would get smaller than
+     * MIN_CELL_SIZE, then the scene grows to hold it
      */
     void resizeScene(int width, int height);
+    /**
+     * Lays out scene again for the last size given to resizeScene()
+     */
+    void relayout();
+    /**
+     * Sets zoom of the field, 1 makes it fit in the view
+     */
+    void setZoom(qreal zoom);
+    qreal zoom() const { return m_zoom; }
+    /**
+     * @return whether the field doesn't fit in the view, so it has to be scrolled
+     */
+    bool isScrollable() const;
+    /**
+     * Sets part of the scene which is visible in the view,
+     * messages are shown in its center
+     */
+    void setVisibleRect(const QRectF& rect);
     /**
      * @return total number of mines in field
      */
     int totalMines() const;
+    /**
+     * @return seed of mine positions of the current game. Together with
+     * the first revealed cell it describes the whole field
+     */
+    quint64 seed() const;
+    /**
+     * @return log of player's actions in the current game
+     */
+    const ReplayRecorder& replay() const;
+    /**
+     * Appends the result of the game to its log
+     *
+     * @param seconds time shown by the game clock
+     */
+    void recordResult(bool won, int seconds);
+    /**
+     * Sets file games in progress are kept in
+     */
+    void setSnapshotFile(const QString& fileName);
+    /**
+     * Continues the game kept in the snapshot file
+     *
+     * @param seconds time on the game clock when it was left
+     * @param level key of the level the game was played at
+     * @param botPlayed whether a bot made a move in the game
+     * @return false if there's no game to continue
+     */
+    bool restoreSnapshot(int* seconds, QByteArray* level, bool* botPlayed);
+    /**
+     * Stores time on the game clock in the snapshot
+     */
+    void setSnapshotSeconds(int seconds);
+    /**
+     * Stores level of the game in the snapshot, see GameSnapshot::setLevel()
+     */
+    void setSnapshotLevel(const QByteArray& level);
+    /**
+     * Stores that a bot played the game in the snapshot
+     */
+    void setSnapshotBotPlayed(bool played);
+    /**
+     * Shows a recorded game instead of the current one,
+     * until a new game is started
+     *
+     * @return false if data isn't a valid log
+     */
+    bool loadReplay(const QByteArray& data);
+    /**
+     * Shows the recorded game as it was at given time in milliseconds
+     */
+    void setReplayPosition(qint64 time);
+    /**
+     * @return length of the recorded game in milliseconds
+     */
+    qint64 replayDuration() const;
+    /**
+     * @return whether a recorded game is shown
+     */
+    bool isReplaying() const;
+    /**
+     * @return field of the current game, 0 in the endless mode
+     * and while a recorded game is shown
+     */
+    const MineField* field() const;
+    /**
+     * Makes a move as if the player made it with the mouse
+     *
+     * @return false if no move is possible now
+     */
+    bool playMove(ReplayRecorder::Action action, int idx);
     /**
      * Starts new game
+     *
+     * @param seed seed of mine positions, 0 means a random one
+     */
+    void startNewGame(int rows, int cols, int numMines, quint64 seed);
+    /**
+     * Starts new game on a field of given shape
+     *
+     * @param seed seed of mine positions, 0 means a random one
+     */
+    void startNewGame(const BoardShape& shape, int numMines, quint64 seed);
+    /**
+     * Starts new endless game, see ChunkedMineField
+     *
+     * @param seed seed of mine positions, 0 means a random one
+     * @param density probability that a cell holds mine
+     */
+    void startEndlessGame(quint64 seed, double density);
+    /**
+     * @return whether an endless game is played
+     */
+    bool isEndless() const;
+    /**
+     * @return whether the field of the current game has holes
+     */
+    bool isShaped() const;
+    /**
+     * Moves the visible part of an endless field by given number of cells
+     */
+    void scrollField(int rows, int cols);
+    /**
+     * Makes the current game use prepared mines if it is started
+     * by revealing startIdx
+     *
+     * @return false if the game has already started
+     */
+    bool setPresetBoard(const QVector<int>& mines, int startIdx, quint64 seed, bool noGuess);
+    /**
+     * Reveals the first cell with mines generated in background
+     * after boardRequested() was emitted for it
+     *
+     * @return false if the game doesn't wait for them anymore
+     */
+    bool revealGeneratedBoard(const QVector<int>& mines, int startIdx, bool noGuess);
+    /**
+     * @return whether the first revealed cell waits for generated mines
      */
-    void startNewGame(int rows, int cols, int numMines);
+    bool isWaitingForBoard() const;
     /**
-     * Toggles paused state for all cells in the field item
+     * Sets whether the safest cells should be shown with a hint
+     */
+    void setShowHints(bool show);
+    /**
+     * Toggles paused state for all cells in the field item,
+     * the log of the game gets it too
      */
     void setGamePaused(bool paused);
 
     KGameRenderer& renderer() {return m_renderer;}
+
+    /**
+     * Cells are never smaller, bigger fields have to be scrolled
+     */
+    static const int MIN_CELL_SIZE = 16;
+    /**
+     * Maximal value of zoom()
+     */
+    static const int MAX_ZOOM = 8;
+    /**
+     * Size of cells of an endless field at zoom 1
+     */
+    static const int ENDLESS_CELL_SIZE = 32;
 signals:
     void minesCountChanged(int);
     void gameOver(bool);
     void firstClickDone();
+    /**
+     * Emitted after every move which changed cells of a bounded field
+     */
+    void cellsChanged(const QVector<int>& cells);
+    /**
+     * Emitted when the first revealed cell needs "no guess" mines
+     * generated in background, see MineFieldItem::boardRequested()
+     */
+    void boardRequested(int startIdx);
 private slots:
     void onGameOver(bool);
+    void onThemeChanged();
+    void onBackgroundRendered(const QImage& image);
 private:
+    /**
+     * Makes background fit the view. If there is one already,
+     * it is stretched until the new one is rendered in background
+     */
+    void updateBackground();
+    /**
+     * Moves messages to the center of the visible rect
+     */
+    void repositionMessages();
+
     KGameRenderer m_renderer;
+    SpriteCache m_spriteCache;
+    SpriteRasterizer* m_backgroundRasterizer;
+    QPixmap m_background;
+    /**
+     * Size m_background was requested in
+     */
+    QSize m_backgroundSize;
+    bool m_themeChanged;
     /**
      * Game field graphics item
      */
     MineFieldItem* m_fieldItem;
     KGamePopupItem* m_messageItem;
     KGamePopupItem* m_gamePausedMessageItem;
+    /**
+     * Size of the view given to resizeScene()
+     */
+    QSize m_viewSize;
+    QRectF m_visibleRect;
+    qreal m_zoom;
 };
 
 class QResizeEvent;
+class QPaintEvent;
+class QTimer;
+class QWheelEvent;
+class QKeyEvent;
 
 class KMinesView : public QGraphicsView
 {
+    Q_OBJECT
 public:
     KMinesView( KMinesScene* scene, QWidget *parent );
+    /**
+     * Clock started by main(). Time from its start to the
+     * first painted frame is kept, see firstFrameTime()
+     */
+    static QElapsedTimer& startupClock();
+    /**
+     * @return time from the start of startupClock() to the first
+     * painted frame in milliseconds, -1 until it is painted
+     */
+    qint64 firstFrameTime() const { return m_firstFrameTime; }
+    /**
+     * @return number of resize events received
+     */
+    int resizeCount() const { return m_resizeCount; }
+    /**
+     * @return number of full relayouts of the scene done for them
+     */
+    int relayoutCount() const { return m_relayoutCount; }
+    /**
+     * @return time the last full relayout took, in microseconds
+     */
+    qint64 lastRelayoutTime() const { return m_lastRelayoutTime; }
+
+    /**
+     * Time without resize events after which the scene
+     * is laid out for the new size, in milliseconds
+     */
+    static const int RELAYOUT_DELAY = 150;
+    /**
+     * Cells an endless field moves by for a wheel step or an arrow key
+     */
+    static const int ENDLESS_SCROLL_CELLS = 3;
+public slots:
+    void zoomIn();
+    void zoomOut();
+    /**
+     * Makes the whole field fit in the view again, if possible
+     */
+    void zoomToFit();
 private:
     virtual void resizeEvent( QResizeEvent *ev );
+    virtual void paintEvent( QPaintEvent *ev );
+    /**
+     * Ctrl+wheel zooms, the wheel alone scrolls
+     */
+    virtual void wheelEvent( QWheelEvent *ev );
+    /**
+     * Arrow keys scroll an endless field
+     */
+    virtual void keyPressEvent( QKeyEvent *ev );
+    virtual void scrollContentsBy( int dx, int dy );
+    /**
+     * Zooms keeping the center of the view in place
+     */
+    void setZoom(qreal zoom);
+    /**
+     * Tells the scene which part of it is visible
+     */
+    void updateVisibleRect();
+    /**
+     * Lays out the scene for the current size of the view
+     */
+    void relayout();
 
     KMinesScene* m_scene;
+    qint64 m_firstFrameTime;
+    /**
+     * Restarted by every resize event, relayout() runs when it fires
+     */
+    QTimer* m_relayoutTimer;
+    int m_resizeCount;
+    int m_relayoutCount;
+    qint64 m_lastRelayoutTime;
 };
 #endif
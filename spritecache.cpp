@@ -0,0 +1,134 @@
+/*
+    Copyright 2026 The KMines Authors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#include "spritecache.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <KGameRenderer>
+#include <KgTheme>
+
+namespace
+{
+/**
+ * Header of a cache file, pixels follow
+ */
+struct Header
+{
+    quint32 magic;
+    quint32 version;
+    qint32 width;
+    qint32 height;
+    qint32 bytesPerLine;
+};
+
+const quint32 MAGIC = 0x4b4d5343; // "KMSC"
+}
+
+SpriteCache::SpriteCache(KGameRenderer* renderer)
+    : m_renderer(renderer)
+{
+    const QString base = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    if(!base.isEmpty() && QDir().mkpath(base + QLatin1String("/sprites")))
+        m_directory = base + QLatin1String("/sprites");
+}
+
+QString SpriteCache::fileName(const QString& key, const QSize& size)
+{
+    if(m_directory.isEmpty() || !m_renderer->theme())
+        return QString();
+    const QString hash = fileHash(m_renderer->theme()->graphicsPath());
+    if(hash.isEmpty())
+        return QString();
+    return QStringLiteral("%1/%2-%3-%4x%5").arg(m_directory, hash, key)
+               .arg(size.width()).arg(size.height());
+}
+
+QString SpriteCache::fileHash(const QString& path)
+{
+    const QFileInfo info(path);
+    const QString id = path + QLatin1Char(':') + QString::number(info.lastModified().toMSecsSinceEpoch());
+    QHash<QString, QString>::const_iterator it = m_hashes.constFind(id);
+    if(it != m_hashes.constEnd())
+        return it.value();
+
+    // reading the file is much cheaper than rendering it
+    QString hash;
+    QFile file(path);
+    QCryptographicHash sha1(QCryptographicHash::Sha1);
+    if(file.open(QIODevice::ReadOnly) && sha1.addData(&file))
+        hash = QString::fromLatin1(sha1.result().toHex().left(16));
+    m_hashes.insert(id, hash);
+    return hash;
+}
+
+QPixmap SpriteCache::load(const QString& fileName)
+{
+    if(fileName.isEmpty())
+        return QPixmap();
+    QFile file(fileName);
+    if(!file.open(QIODevice::ReadOnly) || file.size() < qint64(sizeof(Header)))
+        return QPixmap();
+
+    const uchar* data = file.map(0, file.size());
+    if(!data)
+        return QPixmap();
+    const Header* header = reinterpret_cast<const Header*>(data);
+    if(header->magic != MAGIC || header->version != VERSION || header->width <= 0 || header->height <= 0)
+        return QPixmap();
+    // lines have to hold all their pixels and stay 32-bit aligned,
+    // otherwise QImage reads past the end of a corrupt file
+    const qint64 bytesPerLine = header->bytesPerLine;
+    if(bytesPerLine < qint64(header->width)*4 || bytesPerLine % 4 != 0
+       || file.size() - qint64(sizeof(Header)) < bytesPerLine*header->height)
+        return QPixmap();
+
+    // the image only points to the mapping, which is gone once file is
+    // closed. raster pixmaps share the data of images in their format,
+    // so the pixels are copied before the pixmap is made
+    const QImage image(data + sizeof(Header), header->width, header->height, header->bytesPerLine,
+                       QImage::Format_ARGB32_Premultiplied);
+    return QPixmap::fromImage(image.copy());
+}
+
+bool SpriteCache::save(const QString& fileName, const QImage& image)
+{
+    if(fileName.isEmpty() || image.isNull())
+        return false;
+    const QImage pixels = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+
+    Header header;
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.width = pixels.width();
+    header.height = pixels.height();
+    header.bytesPerLine = pixels.bytesPerLine();
+
+    // readers never see a half written file
+    QSaveFile file(fileName);
+    if(!file.open(QIODevice::WriteOnly))
+        return false;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(pixels.constBits()), qint64(pixels.bytesPerLine())*pixels.height());
+    return file.commit();
+}
@@ -0,0 +1,72 @@
+/*
+    Copyright 2026 The KMines Authors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#ifndef SPRITECACHE_H
+#define SPRITECACHE_H
+
+#include <QHash>
+#include <QPixmap>
+#include <QString>
+
+class KGameRenderer;
+
+/**
+ * Persistent cache of rendered sprites on disk, so that starting the
+ * game again at the same window size doesn't need to render any SVG.
+ *
+ * Each entry is a file in the user's cache directory, named after the
+ * hash of the theme's graphics file, the key of the entry and its size.
+ * Files hold raw premultiplied ARGB32 pixels behind a small versioned
+ * header and are memory-mapped when loaded. Entries of a changed theme
+ * file simply stop being found.
+ */
+class SpriteCache
+{
+public:
+    explicit SpriteCache(KGameRenderer* renderer);
+    /**
+     * @return file of the entry with given key and size for the
+     * current theme, empty if the cache directory isn't available
+     */
+    QString fileName(const QString& key, const QSize& size);
+    /**
+     * @return pixmap stored in given file, null if there is none
+     * or it was written by another version
+     */
+    static QPixmap load(const QString& fileName);
+    /**
+     * Stores image to given file. Can be called from any thread
+     * @return false if writing failed
+     */
+    static bool save(const QString& fileName, const QImage& image);
+
+    /**
+     * Version of the file format, files of other versions are ignored
+     */
+    static const quint32 VERSION = 1;
+private:
+    /**
+     * @return hash of given file, computed once per file and modification time
+     */
+    QString fileHash(const QString& path);
+
+    KGameRenderer* m_renderer;
+    QString m_directory;
+    QHash<QString, QString> m_hashes;
+};
+
+#endif
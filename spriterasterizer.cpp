@@ -0,0 +1,130 @@
+/*
+    Copyright 2026 The KMines Authors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#include "spriterasterizer.h"
+
+#include <QPainter>
+#include <QRunnable>
+#include <QSvgRenderer>
+#include <QThreadStorage>
+
+#include <KGameRenderer>
+#include <KgTheme>
+
+#include "spritecache.h"
+
+namespace
+{
+/**
+ * Parsed theme of a pool thread, QSvgRenderer isn't thread-safe
+ */
+struct ThreadRenderer
+{
+    explicit ThreadRenderer(const QString& path) : graphicsPath(path), svg(path) {}
+    QString graphicsPath;
+    QSvgRenderer svg;
+};
+/**
+ * Deleted when its thread exits
+ */
+QThreadStorage<ThreadRenderer*> threadRenderer;
+}
+
+class SpriteRasterizer::Job : public QRunnable
+{
+public:
+    Job(SpriteRasterizer* rasterizer, int generation, const QString& graphicsPath,
+        const QSize& size, const QVector<Layer>& layers, const QString& cacheFile)
+        : m_rasterizer(rasterizer), m_generation(generation), m_graphicsPath(graphicsPath),
+          m_size(size), m_layers(layers), m_cacheFile(cacheFile) {}
+    void run();
+private:
+    bool isStale() const { return m_rasterizer->m_generation.load() != m_generation; }
+
+    SpriteRasterizer* m_rasterizer;
+    int m_generation;
+    QString m_graphicsPath;
+    QSize m_size;
+    QVector<Layer> m_layers;
+    QString m_cacheFile;
+};
+
+void SpriteRasterizer::Job::run()
+{
+    if(isStale())
+        return;
+    // the theme is parsed again only when it changes
+    if(!threadRenderer.hasLocalData() || threadRenderer.localData()->graphicsPath != m_graphicsPath)
+        threadRenderer.setLocalData(new ThreadRenderer(m_graphicsPath));
+    QSvgRenderer& svg = threadRenderer.localData()->svg;
+    if(isStale() || !svg.isValid())
+        return;
+
+    QImage image(m_size, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+    QPainter painter(&image);
+    foreach(const Layer& layer, m_layers)
+    {
+        if(isStale())
+            return;
+        if(svg.elementExists(layer.spriteKey))
+            svg.render(&painter, layer.spriteKey, layer.rect);
+    }
+    painter.end();
+    // even if the result is already stale, the next start may use it
+    SpriteCache::save(m_cacheFile, image);
+
+    // QImage can cross threads, the pixmap is made in the GUI thread
+    QMetaObject::invokeMethod(m_rasterizer, "onJobDone", Qt::QueuedConnection,
+                              Q_ARG(QImage, image), Q_ARG(int, m_generation));
+}
+
+SpriteRasterizer::SpriteRasterizer(KGameRenderer* renderer, QObject* parent)
+    : QObject(parent), m_renderer(renderer), m_generation(0), m_doneGeneration(0)
+{
+    // idle threads would take their parsed theme with them
+    m_pool.setExpiryTimeout(-1);
+}
+
+SpriteRasterizer::~SpriteRasterizer()
+{
+    cancel();
+    m_pool.waitForDone();
+}
+
+void SpriteRasterizer::cancel()
+{
+    // make running workers give up
+    m_doneGeneration = m_generation.fetchAndAddOrdered(1) + 1;
+    m_pool.clear();
+}
+
+void SpriteRasterizer::render(const QSize& size, const QVector<Layer>& layers, const QString& cacheFile)
+{
+    const int generation = m_generation.fetchAndAddOrdered(1) + 1;
+    // workers still waiting in the queue have nothing to do anymore
+    m_pool.clear();
+    m_pool.start(new Job(this, generation, m_renderer->theme()->graphicsPath(), size, layers, cacheFile));
+}
+
+void SpriteRasterizer::onJobDone(const QImage& image, int generation)
+{
+    if(generation != m_generation.load())
+        return; // there is a newer request
+    m_doneGeneration = generation;
+    emit rendered(image);
+}
@@ -0,0 +1,90 @@
+/*
+    Copyright 2026 The KMines Authors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#ifndef SPRITERASTERIZER_H
+#define SPRITERASTERIZER_H
+
+#include <QObject>
+#include <QAtomicInt>
+#include <QImage>
+#include <QRectF>
+#include <QThreadPool>
+#include <QVector>
+
+class KGameRenderer;
+
+/**
+ * Renders sprites of the current theme into an image in a background
+ * thread, so that resizing or changing the theme never blocks the GUI.
+ *
+ * Only the last request matters: workers rendering older requests give
+ * up between sprites and their results are dropped, so the owner keeps
+ * showing what it has until rendered() brings a complete new image.
+ */
+class SpriteRasterizer : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * Sprite drawn into given rect of the image
+     */
+    struct Layer
+    {
+        QString spriteKey;
+        QRectF rect;
+    };
+
+    explicit SpriteRasterizer(KGameRenderer* renderer, QObject* parent = 0);
+    /**
+     * Drops pending requests and waits for workers
+     */
+    ~SpriteRasterizer();
+    /**
+     * Starts rendering layers, bottom first, into a transparent
+     * image of given size. Replaces any pending request
+     *
+     * @param cacheFile file of SpriteCache to store the image to, if any
+     */
+    void render(const QSize& size, const QVector<Layer>& layers, const QString& cacheFile = QString());
+    /**
+     * Drops pending requests, rendered() won't be emitted for them
+     */
+    void cancel();
+    /**
+     * @return whether the last request isn't finished yet
+     */
+    bool isBusy() const { return m_doneGeneration != m_generation.load(); }
+signals:
+    /**
+     * Emitted when the image of the last request is ready
+     */
+    void rendered(const QImage& image);
+private slots:
+    void onJobDone(const QImage& image, int generation);
+private:
+    class Job;
+
+    KGameRenderer* m_renderer;
+    QThreadPool m_pool;
+    /**
+     * Number of the last request, workers compare it with their own
+     */
+    QAtomicInt m_generation;
+    int m_doneGeneration;
+};
+
+#endif
@@ -0,0 +1,248 @@
+/*
+    Copyright 2026 The KMines Authors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#include "tileatlas.h"
+
+#include <QPainter>
+#include <QStringList>
+
+#include <KGameRenderer>
+#include <KgThemeProvider>
+
+#include "kminesdebug.h"
+
+TileAtlas::TileAtlas(KGameRenderer* renderer, QObject* parent)
+    : QObject(parent), m_renderer(renderer), m_rasterizer(renderer), m_diskCache(renderer), m_tiles(TILE_COUNT),
+      m_tileSize(0), m_pendingSize(0), m_themeChanged(false), m_hits(0), m_misses(0)
+{
+    connect(&m_rasterizer, &SpriteRasterizer::rendered, this, &TileAtlas::onRendered);
+    connect(renderer->themeProvider(), &KgThemeProvider::currentThemeChanged,
+            this, &TileAtlas::onThemeChanged);
+}
+
+void TileAtlas::setTileSize(int tileSize)
+{
+    if(tileSize == m_pendingSize && !m_themeChanged)
+        return;
+    m_pendingSize = tileSize;
+    m_themeChanged = false;
+
+    // tiles of the same theme and size may be on disk already
+    const QSize stripSize(TILE_COUNT*tileSize, tileSize);
+    const QString cacheFile = tileSize > 0 ? m_diskCache.fileName(QLatin1String("tiles"), stripSize) : QString();
+    const QPixmap cached = SpriteCache::load(cacheFile);
+    if(!cached.isNull())
+    {
+        m_rasterizer.cancel();
+        dropTiles(tileSize);
+        m_pixmap = cached;
+        emit tilesChanged();
+        return;
+    }
+
+    if(m_tileSize <= 0 || tileSize <= 0)
+    {
+        // nothing to show meanwhile, so the first tiles
+        // are rendered right away
+        dropTiles(tileSize);
+        if(!cacheFile.isEmpty())
+            SpriteCache::save(cacheFile, pixmap().toImage());
+        return;
+    }
+
+    // old tiles stay in use, scaled, until the new ones are ready
+    QVector<SpriteRasterizer::Layer> layers;
+    for(int tile=0; tile<TILE_COUNT; ++tile)
+    {
+        foreach(const QString& key, spriteKeys(tile))
+        {
+            SpriteRasterizer::Layer layer;
+            layer.spriteKey = key;
+            layer.rect = QRectF(tile*tileSize, 0, tileSize, tileSize);
+            layers.append(layer);
+        }
+    }
+    m_rasterizer.render(stripSize, layers, cacheFile);
+}
+
+void TileAtlas::onThemeChanged()
+{
+    // tiles are rendered again on the next setTileSize()
+    m_themeChanged = true;
+}
+
+void TileAtlas::onRendered(const QImage& image)
+{
+    dropTiles(m_pendingSize);
+    m_pixmap = QPixmap::fromImage(image);
+    emit tilesChanged();
+}
+
+void TileAtlas::dropTiles(int tileSize)
+{
+    if(m_hits + m_misses > 0)
+        qCDebug(KMINES_PERF) << "tile cache:" << m_misses << "tiles," << cacheSize()/1024 << "KiB, hit rate"
+                             << qRound(100 * hitRate()) << "%";
+
+    m_tileSize = tileSize;
+    m_tiles.fill(QPixmap());
+    m_pixmap = QPixmap();
+    m_hits = 0;
+    m_misses = 0;
+}
+
+double TileAtlas::hitRate() const
+{
+    const int lookups = m_hits + m_misses;
+    return lookups > 0 ? double(m_hits) / lookups : 0;
+}
+
+const QPixmap& TileAtlas::tile(int tile)
+{
+    QPixmap& pixmap = m_tiles[tile];
+    if(m_tileSize <= 0)
+        return pixmap;
+    if(!pixmap.isNull())
+    {
+        m_hits++;
+        return pixmap;
+    }
+
+    m_misses++;
+    // tiles rendered in background only need to be cut out
+    if(!m_pixmap.isNull())
+    {
+        pixmap = m_pixmap.copy(sourceRect(tile).toRect());
+        return pixmap;
+    }
+
+    const QSize size(m_tileSize, m_tileSize);
+    pixmap = QPixmap(size);
+    pixmap.fill(Qt::transparent);
+    QPainter painter(&pixmap);
+    foreach(const QString& key, spriteKeys(tile))
+        painter.drawPixmap(0, 0, m_renderer->spritePixmap(key, size));
+    return pixmap;
+}
+
+const QPixmap& TileAtlas::pixmap()
+{
+    if(m_tileSize <= 0)
+        return m_pixmap;
+    if(!m_pixmap.isNull())
+    {
+        m_hits++;
+        return m_pixmap;
+    }
+
+    m_pixmap = QPixmap(TILE_COUNT*m_tileSize, m_tileSize);
+    m_pixmap.fill(Qt::transparent);
+    QPainter painter(&m_pixmap);
+    for(int i=0; i<TILE_COUNT; ++i)
+        painter.drawPixmap(i*m_tileSize, 0, tile(i));
+    return m_pixmap;
+}
+
+qint64 TileAtlas::cacheSize() const
+{
+    // 32-bit pixels
+    const qint64 tileBytes = qint64(m_tileSize)*m_tileSize*4;
+    qint64 size = m_pixmap.isNull() ? 0 : TILE_COUNT*tileBytes;
+    foreach(const QPixmap& pixmap, m_tiles)
+    {
+        if(!pixmap.isNull())
+            size += tileBytes;
+    }
+    return size;
+}
+
+int TileAtlas::cellTile(KMinesState::CellState state, int digit, bool hasMine, bool exploded)
+{
+    switch(state)
+    {
+        case KMinesState::Released:
+            return ReleasedTile;
+        case KMinesState::Pressed:
+            return PressedTile;
+        case KMinesState::Questioned:
+            return QuestionedTile;
+        case KMinesState::Flagged:
+            return FlaggedTile;
+        case KMinesState::Error:
+            return ErrorTile;
+        case KMinesState::Hint:
+            return HintTile;
+        case KMinesState::Revealed:
+            break;
+    }
+    if(digit == 0 && hasMine)
+        return exploded ? ExplodedTile : MineTile;
+    return FIRST_DIGIT_TILE + digit;
+}
+
+QStringList TileAtlas::spriteKeys(int tile)
+{
+    static const char* const digitNames[] = { "arabicOne", "arabicTwo", "arabicThree", "arabicFour",
+                                              "arabicFive", "arabicSix", "arabicSeven", "arabicEight" };
+    // same order as KMinesState::BorderElement
+    static const char* const borderNames[] = { "border.edge.north", "border.edge.south",
+                                               "border.edge.east", "border.edge.west",
+                                               "border.outsideCorner.nw", "border.outsideCorner.sw",
+                                               "border.outsideCorner.ne", "border.outsideCorner.se" };
+
+    QStringList keys;
+    if(tile >= FIRST_BORDER_TILE)
+    {
+        keys << QLatin1String(borderNames[tile - FIRST_BORDER_TILE]);
+        return keys;
+    }
+    if(tile > FIRST_DIGIT_TILE)
+    {
+        keys << QLatin1String("cell_down") << QLatin1String(digitNames[tile - FIRST_DIGIT_TILE - 1]);
+        return keys;
+    }
+
+    switch(tile)
+    {
+        case ReleasedTile:
+            keys << QLatin1String("cell_up");
+            break;
+        case QuestionedTile:
+            keys << QLatin1String("cell_up") << QLatin1String("question");
+            break;
+        case FlaggedTile:
+            keys << QLatin1String("cell_up") << QLatin1String("flag");
+            break;
+        case HintTile:
+            keys << QLatin1String("cell_up") << QLatin1String("hint");
+            break;
+        case ErrorTile:
+            keys << QLatin1String("cell_down") << QLatin1String("mine") << QLatin1String("error");
+            break;
+        case MineTile:
+            keys << QLatin1String("cell_down") << QLatin1String("mine");
+            break;
+        case ExplodedTile:
+            keys << QLatin1String("cell_down") << QLatin1String("explosion") << QLatin1String("mine");
+            break;
+        default:
+            // pressed cells and revealed empty ones
+            keys << QLatin1String("cell_down");
+            break;
+    }
+    return keys;
+}
@@ -0,0 +1,157 @@
+/*
+    Copyright 2026 The KMines Authors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#ifndef TILEATLAS_H
+#define TILEATLAS_H
+
+#include <QObject>
+#include <QPixmap>
+#include <QStringList>
+#include <QVector>
+#include <QRectF>
+
+#include "commondefs.h"
+#include "spritecache.h"
+#include "spriterasterizer.h"
+
+class KGameRenderer;
+
+/**
+ * Cache of all distinct looks of a cell and of the border at the current
+ * cell size. Overlays (digits, marks, mines) are composited into the
+ * tiles, so showing a cell in another state only swaps a pixmap, and
+ * painting it is a single blit.
+ *
+ * The first tiles are rendered on first use. When the size or the theme
+ * changes, all tiles are rendered again in a background thread by
+ * SpriteRasterizer. Until they are ready the old ones stay in use, so
+ * users of the atlas have to scale them from tileSize() to their size.
+ * New tiles replace all old ones at once, then tilesChanged() is emitted.
+ *
+ * Complete sets of tiles are kept in SpriteCache, so that once a size
+ * was used, it never has to be rendered again.
+ *
+ * Besides single tiles, the whole set is available as one pixmap with
+ * tiles side by side, for batched painting. Numbers of lookups served
+ * from the cache and of rendered tiles are counted. They are logged to
+ * the kmines.perf category when the cache is dropped.
+ */
+class TileAtlas : public QObject
+{
+    Q_OBJECT
+public:
+    explicit TileAtlas(KGameRenderer* renderer, QObject* parent = 0);
+    /**
+     * Requests tiles in given size. Must be called again
+     * when the theme changes, otherwise calls with the
+     * same size do nothing
+     */
+    void setTileSize(int tileSize);
+    /**
+     * @return size of tiles in use, which may differ from
+     * the requested size until new tiles are ready
+     */
+    int tileSize() const { return m_tileSize; }
+    /**
+     * @return pixmap of given tile, rendering it if needed
+     */
+    const QPixmap& tile(int tile);
+    /**
+     * @return pixmap holding all tiles side by side
+     */
+    const QPixmap& pixmap();
+    /**
+     * @return rect of given tile in pixmap()
+     */
+    QRectF sourceRect(int tile) const { return QRectF(tile*m_tileSize, 0, m_tileSize, m_tileSize); }
+    /**
+     * @return number of lookups served from the cache since the last setTileSize()
+     */
+    int hitCount() const { return m_hits; }
+    /**
+     * @return number of tiles rendered since the last setTileSize()
+     */
+    int missCount() const { return m_misses; }
+    /**
+     * @return share of lookups since the last setTileSize() which
+     * were served from the cache, 0 if there were none
+     */
+    double hitRate() const;
+    /**
+     * @return approximate memory held by rendered tiles, in bytes
+     */
+    qint64 cacheSize() const;
+    /**
+     * @return tile showing cell with given properties,
+     * see CellItem::setCellState()
+     */
+    static int cellTile(KMinesState::CellState state, int digit, bool hasMine, bool exploded);
+    /**
+     * @return tile showing given border element
+     */
+    static int borderTile(KMinesState::BorderElement element) { return FIRST_BORDER_TILE + element; }
+
+    /**
+     * Tiles of cells which aren't revealed
+     */
+    enum { ReleasedTile, PressedTile, QuestionedTile, FlaggedTile, ErrorTile, HintTile,
+           MineTile, ExplodedTile, FIRST_DIGIT_TILE };
+    /**
+     * Revealed cells with digits 0 to 8 follow, then border elements
+     */
+    static const int FIRST_BORDER_TILE = FIRST_DIGIT_TILE + 9;
+    static const int TILE_COUNT = FIRST_BORDER_TILE + 8;
+signals:
+    /**
+     * Emitted when tiles rendered in background replace the old ones
+     */
+    void tilesChanged();
+private slots:
+    void onThemeChanged();
+    void onRendered(const QImage& image);
+private:
+    /**
+     * Drops all tiles, next lookups give tiles of given size
+     */
+    void dropTiles(int tileSize);
+    /**
+     * @return sprite keys composing given tile, bottom first
+     */
+    static QStringList spriteKeys(int tile);
+
+    KGameRenderer* m_renderer;
+    SpriteRasterizer m_rasterizer;
+    SpriteCache m_diskCache;
+    /**
+     * Rendered tiles, null until first used
+     */
+    QVector<QPixmap> m_tiles;
+    /**
+     * All tiles side by side, null until first used
+     */
+    QPixmap m_pixmap;
+    int m_tileSize;
+    /**
+     * Size of the last request
+     */
+    int m_pendingSize;
+    bool m_themeChanged;
+    int m_hits;
+    int m_misses;
+};
+
+#endif
@@ -0,0 +1,98 @@
+/*
+    Copyright 2026 The KMines Authors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#include "tournament.h"
+
+#include <QElapsedTimer>
+
+#include <cmath>
+
+Tournament::Tournament(const GameSimulator::Settings& settings)
+    : m_settings(settings)
+{
+}
+
+QVector<Tournament::Standing> Tournament::run()
+{
+    QVector<Standing> standings;
+    // results of the first strategy by game
+    QVector<quint8> firstWon(m_settings.count, 0);
+    foreach(int strategy, m_strategies)
+    {
+        Standing standing;
+        standing.strategy = strategy;
+        standing.games = m_settings.count;
+        standing.won = 0;
+        standing.onlyThisWon = 0;
+        standing.onlyFirstWon = 0;
+        qint64 guesses = 0;
+        qint64 decisions = 0;
+        qint64 decisionMicros = 0;
+
+        GameSimulator::Settings settings = m_settings;
+        settings.strategy = strategy;
+        QElapsedTimer timer;
+        timer.start();
+        GameSimulator simulator(settings);
+        simulator.start();
+        QVector<GameSimulator::Result> results;
+        while(simulator.takeResults(&results))
+        {
+            foreach(const GameSimulator::Result& result, results)
+            {
+                const int game = static_cast<int>(result.seed - m_settings.firstSeed);
+                if(standings.isEmpty())
+                    firstWon[game] = result.won;
+                else if(result.won && !firstWon.at(game))
+                    standing.onlyThisWon++;
+                else if(!result.won && firstWon.at(game))
+                    standing.onlyFirstWon++;
+                if(result.won)
+                    standing.won++;
+                guesses += result.guesses;
+                decisions += result.clicks - 1;
+                decisionMicros += result.decisionMicros;
+            }
+        }
+        const qint64 elapsed = qMax(qint64(1), timer.nsecsElapsed());
+
+        winRateInterval(standing.won, standing.games, &standing.winRateLow, &standing.winRateHigh);
+        standing.meanGuesses = standing.games ? double(guesses) / standing.games : 0;
+        standing.meanDecisionMicros = decisions ? double(decisionMicros) / decisions : 0;
+        standing.gamesPerSecond = standing.games * 1e9 / elapsed;
+        standings.append(standing);
+    }
+    return standings;
+}
+
+void Tournament::winRateInterval(int won, int games, double* low, double* high)
+{
+    if(games <= 0)
+    {
+        *low = 0;
+        *high = 1;
+        return;
+    }
+    // two-sided 95% quantile of the normal distribution
+    const double z = 1.959964;
+    const double p = double(won) / games;
+    const double z2n = z*z / games;
+    const double center = (p + z2n/2) / (1 + z2n);
+    const double margin = z * std::sqrt(p*(1-p)/games + z2n/(4*games)) / (1 + z2n);
+    *low = qMax(0.0, center - margin);
+    *high = qMin(1.0, center + margin);
+}
@@ -0,0 +1,95 @@
+/*
+    Copyright 2026 The KMines Authors
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#ifndef TOURNAMENT_H
+#define TOURNAMENT_H
+
+#include <QVector>
+
+#include "gamesimulator.h"
+
+/**
+ * Compares strategies of GameSimulator: every strategy plays the same
+ * set of seeds, one strategy after another on all cores, so both the
+ * strength and the speed of strategies can be compared.
+ *
+ * As the boards are the same, boards won by one strategy and lost by
+ * the other are counted too. They tell whether two strategies really
+ * differ better than the win rates alone.
+ */
+class Tournament
+{
+public:
+    /**
+     * Results of a single strategy
+     */
+    struct Standing
+    {
+        /**
+         * Index in GameSimulator::STRATEGIES
+         */
+        int strategy;
+        int games;
+        int won;
+        /**
+         * 95% confidence interval of the win rate
+         */
+        double winRateLow;
+        double winRateHigh;
+        double meanGuesses;
+        /**
+         * Mean time needed for a click after the first one, in microseconds
+         */
+        double meanDecisionMicros;
+        double gamesPerSecond;
+        /**
+         * Boards won by this strategy and lost by the first one,
+         * and the other way round
+         */
+        int onlyThisWon;
+        int onlyFirstWon;
+    };
+
+    /**
+     * Constructor
+     *
+     * @param settings games to play, strategy is ignored
+     */
+    explicit Tournament(const GameSimulator::Settings& settings);
+    /**
+     * Adds strategy of given index in GameSimulator::STRATEGIES.
+     * The first one added is compared with all the others
+     */
+    void addStrategy(int strategy) { m_strategies.append(strategy); }
+    /**
+     * Plays all games of all strategies
+     *
+     * @return standings in the order strategies were added
+     */
+    QVector<Standing> run();
+    /**
+     * Computes Wilson score interval of the win rate at
+     * 95% confidence, which stays sane for few games or
+     * win rates near 0 and 1
+     */
+    static void winRateInterval(int won, int games, double* low, double* high);
+private:
+    GameSimulator::Settings m_settings;
+    QVector<int> m_strategies;
+};
+
+#endif